@@ -5,6 +5,7 @@ INCLUDEPATH += . src ../common
 MOC_DIR = build
 OBJECTS_DIR = build
 RESOURCES = cockatrice.qrc
+LIBS += -lz
 QT += network script svg
 unix:!macx {
 	CONFIG += mobility
@@ -83,12 +84,14 @@ HEADERS += src/abstractcounter.h \
  src/soundengine.h \
  	../common/color.h \
  	../common/serializable_item.h \
+	../common/stream_compression.h \
 	../common/decklist.h \
 	../common/protocol.h \
 	../common/protocol_items.h \
 	../common/protocol_datastructures.h \
 	../common/rng_abstract.h \
 	../common/rng_sfmt.h \
+	../common/rng_xoroshiro.h \
 	../common/server.h \
 	../common/server_arrow.h \
 	../common/server_card.h \
@@ -98,7 +101,10 @@ HEADERS += src/abstractcounter.h \
 	../common/server_game.h \
 	../common/server_player.h \
 	../common/server_protocolhandler.h \
-	../common/server_arrowtarget.h
+	../common/server_arrowtarget.h \
+	../common/server_timerwheel.h \
+	../common/server_ratelimiter.h \
+	../common/server_gamestatecache.h
 
 SOURCES += src/abstractcounter.cpp \
  src/counter_general.cpp \
@@ -168,20 +174,26 @@ SOURCES += src/abstractcounter.cpp \
  src/priceupdater.cpp \
  src/soundengine.cpp \
  	../common/serializable_item.cpp \
+	../common/stream_compression.cpp \
 	../common/decklist.cpp \
 	../common/protocol.cpp \
 	../common/protocol_items.cpp \
 	../common/protocol_datastructures.cpp \
 	../common/rng_abstract.cpp \
 	../common/rng_sfmt.cpp \
+	../common/rng_xoroshiro.cpp \
 	../common/sfmt/SFMT.c \
 	../common/server.cpp \
 	../common/server_card.cpp \
+	../common/server_arrowtarget.cpp \
 	../common/server_cardzone.cpp \
 	../common/server_room.cpp \
 	../common/server_game.cpp \
 	../common/server_player.cpp \
-	../common/server_protocolhandler.cpp
+	../common/server_protocolhandler.cpp \
+	../common/server_timerwheel.cpp \
+	../common/server_ratelimiter.cpp \
+	../common/server_gamestatecache.cpp
 
 TRANSLATIONS += \
 	translations/cockatrice_de.ts \
@@ -5,9 +5,10 @@
 #include "remoteclient.h"
 #include "protocol.h"
 #include "protocol_items.h"
+#include "stream_compression.h"
 
 RemoteClient::RemoteClient(QObject *parent)
-	: AbstractClient(parent), timeRunning(0), lastDataReceived(0), topLevelItem(0)
+	: AbstractClient(parent), timeRunning(0), lastDataReceived(0), topLevelItem(0), binaryInput(false), binaryOutput(false), decompressor(0)
 {
 	ProtocolItem::initializeHash();
 	
@@ -62,18 +63,56 @@ void RemoteClient::loginResponse(ProtocolResponse *response)
 	}
 }
 
+void RemoteClient::readBinaryData(const QByteArray &data)
+{
+	bool ok;
+	if (decompressor) {
+		QByteArray uncompressedData;
+		ok = decompressor->decompress(data, uncompressedData) && topLevelItem->readBinaryData(uncompressedData);
+	} else
+		ok = topLevelItem->readBinaryData(data);
+	if (!ok) {
+		emit protocolError();
+		disconnectFromServer();
+	}
+}
+
 void RemoteClient::readData()
 {
 	QByteArray data = socket->readAll();
+	lastDataReceived = timeRunning;
+	if (binaryInput) {
+		readBinaryData(data);
+		return;
+	}
 	qDebug() << data;
 	xmlReader->addData(data);
-	lastDataReceived = timeRunning;
 
 	while (!xmlReader->atEnd()) {
 		xmlReader->readNext();
-		if (topLevelItem)
+		if (topLevelItem) {
+			bool deflate = xmlReader->name() == QLatin1String("deflate_stream");
+			if (xmlReader->isStartElement() && (deflate || (xmlReader->name() == QLatin1String("binary_stream")))) {
+				// The server accepted binary framing. Tell it that our
+				// own stream switches over as well. Deflate is only used
+				// in the server to client direction.
+				xmlWriter->writeEmptyElement("binary_stream");
+				// Forces the writer to close the tag before binary data follows.
+				xmlWriter->writeCharacters(QString());
+				binaryInput = binaryOutput = true;
+				if (deflate) {
+					decompressor = new StreamDecompressor;
+					if (!decompressor->isValid()) {
+						emit protocolError();
+						disconnectFromServer();
+						return;
+					}
+				}
+				readBinaryData(TopLevelProtocolItem::getBinaryRemainder(data, deflate ? TopLevelProtocolItem::deflateStreamMarker : TopLevelProtocolItem::binaryStreamMarker));
+				return;
+			}
 			topLevelItem->readElement(xmlReader);
-		else if (xmlReader->isStartElement() && (xmlReader->name().toString() == "cockatrice_server_stream")) {
+		} else if (xmlReader->isStartElement() && (xmlReader->name() == QLatin1String("cockatrice_server_stream"))) {
 			int serverVersion = xmlReader->attributes().value("version").toString().toInt();
 			if (serverVersion != ProtocolItem::protocolVersion) {
 				emit protocolVersionMismatch(ProtocolItem::protocolVersion, serverVersion);
@@ -84,6 +123,8 @@ void RemoteClient::readData()
 			xmlWriter->writeStartElement("cockatrice_client_stream");
 			xmlWriter->writeAttribute("version", QString::number(ProtocolItem::protocolVersion));
 			xmlWriter->writeAttribute("comp", "1");
+			xmlWriter->writeAttribute("binary", "1");
+			xmlWriter->writeAttribute("deflate", "1");
 			
 			topLevelItem = new TopLevelProtocolItem;
 			connect(topLevelItem, SIGNAL(protocolItemReceived(ProtocolItem *)), this, SLOT(processProtocolItem(ProtocolItem *)));
@@ -100,7 +141,15 @@ void RemoteClient::readData()
 
 void RemoteClient::sendCommandContainer(CommandContainer *cont)
 {
-	cont->write(xmlWriter);
+	if (binaryOutput) {
+		// An unencodable command stays pending and runs into the timeout.
+		QByteArray frame;
+		if (cont->writeBinaryFrame(frame))
+			socket->write(frame);
+		else
+			qDebug() << "RemoteClient: cannot encode command container in binary mode";
+	} else
+		cont->write(xmlWriter);
 	pendingCommands.insert(cont->getCmdId(), cont);
 }
 
@@ -118,6 +167,9 @@ void RemoteClient::disconnectFromServer()
 {
 	delete topLevelItem;
 	topLevelItem = 0;
+	binaryInput = binaryOutput = false;
+	delete decompressor;
+	decompressor = 0;
 	
 	xmlReader->clear();
 	
@@ -7,6 +7,7 @@
 class QTimer;
 class QXmlStreamReader;
 class QXmlStreamWriter;
+class StreamDecompressor;
 
 class RemoteClient : public AbstractClient {
 	Q_OBJECT
@@ -31,6 +32,9 @@ private:
 	QXmlStreamReader *xmlReader;
 	QXmlStreamWriter *xmlWriter;
 	TopLevelProtocolItem *topLevelItem;
+	bool binaryInput, binaryOutput;
+	StreamDecompressor *decompressor;
+	void readBinaryData(const QByteArray &data);
 public:
 	RemoteClient(QObject *parent = 0);
 	~RemoteClient();
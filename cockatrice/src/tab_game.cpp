@@ -5,6 +5,7 @@
 #include <QAction>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QTimer>
 #include "tab_game.h"
 #include "tab_supervisor.h"
 #include "cardinfowidget.h"
@@ -160,8 +161,11 @@ void DeckViewContainer::setDeck(DeckList *deck)
 }
 
 TabGame::TabGame(TabSupervisor *_tabSupervisor, QList<AbstractClient *> &_clients, int _gameId, const QString &_gameDescription, int _hostId, int _localPlayerId, bool _spectator, bool _spectatorsCanTalk, bool _spectatorsSeeEverything, bool _resuming)
-	: Tab(_tabSupervisor), clients(_clients), gameId(_gameId), gameDescription(_gameDescription), hostId(_hostId), localPlayerId(_localPlayerId), spectator(_spectator), spectatorsCanTalk(_spectatorsCanTalk), spectatorsSeeEverything(_spectatorsSeeEverything), gameStateKnown(false), started(false), resuming(_resuming), currentPhase(-1)
+	: Tab(_tabSupervisor), clients(_clients), gameId(_gameId), gameDescription(_gameDescription), hostId(_hostId), localPlayerId(_localPlayerId), spectator(_spectator), spectatorsCanTalk(_spectatorsCanTalk), spectatorsSeeEverything(_spectatorsSeeEverything), gameStateKnown(false), started(false), resuming(_resuming), currentPhase(-1), secondsElapsed(0)
 {
+	gameClock = new QTimer(this);
+	connect(gameClock, SIGNAL(timeout()), this, SLOT(gameClockTimeout()));
+	
 	phasesToolbar = new PhasesToolbar;
 	phasesToolbar->hide();
 	connect(phasesToolbar, SIGNAL(sendGameCommand(GameCommand *, int)), this, SLOT(sendGameCommand(GameCommand *, int)));
@@ -634,18 +638,22 @@ void TabGame::eventPlayerPropertiesChanged(Event_PlayerPropertiesChanged *event,
 	}
 }
 
-void TabGame::eventJoin(Event_Join *event, GameEventContext * /*context*/)
+void TabGame::eventJoin(Event_Join *event, GameEventContext *context)
 {
 	ServerInfo_PlayerProperties *playerInfo = event->getPlayer();
 	if (players.contains(playerInfo->getPlayerId()))
 		return;
+	// Joins that came with the game state happened before we got here.
+	const bool replay = qobject_cast<Context_StateReplay *>(context);
 	if (playerInfo->getSpectator()) {
 		spectators.insert(playerInfo->getPlayerId(), playerInfo->getUserInfo()->getName());
-		messageLog->logJoinSpectator(playerInfo->getUserInfo()->getName());
+		if (!replay)
+			messageLog->logJoinSpectator(playerInfo->getUserInfo()->getName());
 		playerListWidget->addPlayer(playerInfo);
 	} else {
 		Player *newPlayer = addPlayer(playerInfo->getPlayerId(), playerInfo->getUserInfo());
-		messageLog->logJoin(newPlayer);
+		if (!replay)
+			messageLog->logJoin(newPlayer);
 		playerListWidget->addPlayer(playerInfo);
 	}
 	emit userEvent();
@@ -689,6 +697,7 @@ void TabGame::eventGameHostChanged(Event_GameHostChanged *event, GameEventContex
 void TabGame::eventGameClosed(Event_GameClosed * /*event*/, GameEventContext * /*context*/)
 {
 	started = false;
+	gameClock->stop();
 	messageLog->logGameClosed();
 	emit userEvent();
 }
@@ -750,7 +759,21 @@ void TabGame::eventPing(Event_Ping *event, GameEventContext * /*context*/)
 	for (int i = 0; i < pingList.size(); ++i)
 		playerListWidget->updatePing(pingList[i]->getPlayerId(), pingList[i]->getPingTime());
 	
-	int seconds = event->getSecondsElapsed();
+	// Restarting the clock keeps it in step with the server's.
+	secondsElapsed = event->getSecondsElapsed();
+	gameClock->start(1000);
+	updateTimeElapsedLabel();
+}
+
+void TabGame::gameClockTimeout()
+{
+	++secondsElapsed;
+	updateTimeElapsedLabel();
+}
+
+void TabGame::updateTimeElapsedLabel()
+{
+	int seconds = secondsElapsed;
 	int minutes = seconds / 60;
 	seconds -= minutes * 60;
 	int hours = minutes / 60;
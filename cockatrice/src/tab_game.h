@@ -14,6 +14,7 @@ class CardInfoWidget;
 class MessageLogWidget;
 class QSplitter;
 class QLabel;
+class QTimer;
 class QLineEdit;
 class QPushButton;
 class QMenu;
@@ -106,6 +107,9 @@ private:
 	CardInfoWidget *cardInfo;
 	PlayerListWidget *playerListWidget;
 	QLabel *timeElapsedLabel;
+	// The server only sends pings when something changes, so the clock runs locally in between.
+	QTimer *gameClock;
+	int secondsElapsed;
 	MessageLogWidget *messageLog;
 	QLabel *sayLabel;
 	QLineEdit *sayEdit;
@@ -141,6 +145,7 @@ private:
 	void setActivePhase(int phase);
 	void eventSetActivePhase(Event_SetActivePhase *event, GameEventContext *context);
 	void eventPing(Event_Ping *event, GameEventContext *context);
+	void updateTimeElapsedLabel();
 signals:
 	void gameClosing(TabGame *tab);
 	void playerAdded(Player *player);
@@ -151,6 +156,7 @@ signals:
 private slots:
 	void adminLockChanged(bool lock);
 	void newCardAdded(AbstractCardItem *card);
+	void gameClockTimeout();
 	
 	void actConcede();
 	void actLeaveGame();
@@ -251,7 +251,7 @@ DeckList::DeckList()
 }
 
 DeckList::DeckList(DeckList *other)
-	: SerializableItem("cockatrice_deck"), currentZone(0), currentSideboardPlan(0)
+	: SerializableItem("cockatrice_deck"), name(other->getName()), comments(other->getComments()), currentZone(0), currentSideboardPlan(0)
 {
 	root = new InnerDecklistNode(other->getRoot());
 	
@@ -1,5 +1,7 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
+#include <QDataStream>
+#include <QDebug>
 #include "protocol.h"
 #include "protocol_items.h"
 #include "decklist.h"
@@ -67,6 +69,43 @@ void ProtocolItem::initializeHash()
 	registerSerializableItem("game_eventping", Event_Ping::newItem);
 }
 
+bool ProtocolItem::writeBinaryFrame(QByteArray &buffer)
+{
+	// Frame layout: quint32 payload length, quint16 item tag, item data.
+	int frameStart = buffer.size();
+	buffer.append(QByteArray(4, 0));
+	
+	QDataStream out(&buffer, QIODevice::WriteOnly | QIODevice::Append);
+	out.setVersion(QDataStream::Qt_4_0);
+	if (!writeBinary(out)) {
+		buffer.truncate(frameStart);
+		return false;
+	}
+	
+	quint32 payloadSize = buffer.size() - frameStart - 4;
+	buffer[frameStart] = (char) (payloadSize >> 24);
+	buffer[frameStart + 1] = (char) (payloadSize >> 16);
+	buffer[frameStart + 2] = (char) (payloadSize >> 8);
+	buffer[frameStart + 3] = (char) payloadSize;
+	return true;
+}
+
+const QByteArray TopLevelProtocolItem::binaryStreamMarker("<binary_stream/>");
+const QByteArray TopLevelProtocolItem::deflateStreamMarker("<deflate_stream/>");
+
+QByteArray TopLevelProtocolItem::getBinaryRemainder(const QByteArray &data, const QByteArray &marker)
+{
+	// Returns whatever follows the switch marker in the chunk that
+	// completed it. The marker may have started in an earlier chunk.
+	int markerPos = data.indexOf(marker);
+	if (markerPos != -1)
+		return data.mid(markerPos + marker.size());
+	for (int i = marker.size() - 1; i > 0; --i)
+		if (data.startsWith(marker.right(i)))
+			return data.mid(i);
+	return QByteArray();
+}
+
 TopLevelProtocolItem::TopLevelProtocolItem()
 	: SerializableItem(QString()), currentItem(0)
 {
@@ -87,13 +126,17 @@ bool TopLevelProtocolItem::readCurrentItem(QXmlStreamReader *xml)
 bool TopLevelProtocolItem::readElement(QXmlStreamReader *xml)
 {
 	if (!readCurrentItem(xml) && (xml->isStartElement())) {
-		QString childName = xml->name().toString();
-		QString childSubType = xml->attributes().value("type").toString();
+		const QXmlStreamAttributes attributes = xml->attributes();
+		const QStringRef childSubType = attributes.value(QLatin1String("type"));
+		QString itemName;
+		itemName.reserve(xml->name().size() + childSubType.size());
+		itemName.append(xml->name());
+		itemName.append(childSubType);
 		
-		currentItem = dynamic_cast<ProtocolItem *>(getNewItem(childName + childSubType));
+		currentItem = dynamic_cast<ProtocolItem *>(getNewItem(itemName));
 		if (!currentItem)
 			currentItem = new ProtocolItem_Invalid;
-		if (xml->attributes().value("comp").toString().toInt() == 1)
+		if (attributes.value(QLatin1String("comp")) == QLatin1String("1"))
 			currentItem->setCompressed(true);
 		
 		readCurrentItem(xml);
@@ -105,6 +148,60 @@ void TopLevelProtocolItem::writeElement(QXmlStreamWriter * /*xml*/)
 {
 }
 
+bool TopLevelProtocolItem::readBinaryData(const QByteArray &data)
+{
+	binaryBuffer.append(data);
+	while (binaryBuffer.size() >= 4) {
+		quint32 payloadSize = (((quint32) (unsigned char) binaryBuffer[0]) << 24)
+		                    + (((quint32) (unsigned char) binaryBuffer[1]) << 16)
+		                    + (((quint32) (unsigned char) binaryBuffer[2]) << 8)
+		                    + (quint32) (unsigned char) binaryBuffer[3];
+		if (payloadSize > (quint32) maxBinaryFrameSize)
+			return false;
+		if ((quint32) binaryBuffer.size() < payloadSize + 4)
+			break;
+		
+		QByteArray payload = binaryBuffer.mid(4, payloadSize);
+		binaryBuffer.remove(0, payloadSize + 4);
+		
+		QDataStream in(payload);
+		in.setVersion(QDataStream::Qt_4_0);
+		SerializableItem *newItem = readBinary(in);
+		ProtocolItem *item = dynamic_cast<ProtocolItem *>(newItem);
+		if (item)
+			emit protocolItemReceived(item);
+		else {
+			qDebug() << "TopLevelProtocolItem: dropping invalid binary frame";
+			delete newItem;
+		}
+	}
+	return true;
+}
+
+EncodedProtocolItem::~EncodedProtocolItem()
+{
+	if (ownsItem)
+		delete item;
+}
+
+const QByteArray &EncodedProtocolItem::getXmlData()
+{
+	QMutexLocker locker(&encodeMutex);
+	if (xmlData.isEmpty()) {
+		QXmlStreamWriter xml(&xmlData);
+		item->write(&xml);
+	}
+	return xmlData;
+}
+
+const QByteArray &EncodedProtocolItem::getBinaryFrame()
+{
+	QMutexLocker locker(&encodeMutex);
+	if (binaryFrame.isEmpty())
+		item->writeBinaryFrame(binaryFrame);
+	return binaryFrame;
+}
+
 int CommandContainer::lastCmdId = 0;
 
 Command::Command(const QString &_itemName)
@@ -119,7 +216,7 @@ void Command::processResponse(ProtocolResponse *response)
 }
 
 CommandContainer::CommandContainer(const QList<Command *> &_commandList, int _cmdId)
-	: ProtocolItem("container", "cmd"), ticks(0), resp(0), gameEventQueuePublic(0), gameEventQueueOmniscient(0), gameEventQueuePrivate(0), privatePlayerId(-1)
+	: ProtocolItem("container", "cmd"), ticks(0), resp(0), gameEventContext(0), gameEventQueueGameId(-1), gameEventAudiences(0), privatePlayerId(-1)
 {
 	if (_cmdId == -1)
 		_cmdId = lastCmdId++;
@@ -129,6 +226,13 @@ CommandContainer::CommandContainer(const QList<Command *> &_commandList, int _cm
 		itemList.append(_commandList[i]);
 }
 
+CommandContainer::~CommandContainer()
+{
+	for (int i = 0; i < gameEventQueue.size(); ++i)
+		delete gameEventQueue[i].event;
+	delete gameEventContext;
+}
+
 void CommandContainer::processResponse(ProtocolResponse *response)
 {
 	emit finished(response);
@@ -145,32 +249,36 @@ void CommandContainer::setResponse(ProtocolResponse *_resp)
 	resp = _resp;
 }
 
-void CommandContainer::enqueueGameEventPublic(GameEvent *event, int gameId, GameEventContext *context)
+void CommandContainer::enqueueGameEvent(GameEvent *event, int gameId, int audiences, GameEventContext *context, int _privatePlayerId)
 {
-	if (!gameEventQueuePublic)
-		gameEventQueuePublic = new GameEventContainer(QList<GameEvent *>(), gameId);
-	gameEventQueuePublic->addGameEvent(event);
+	QueuedGameEvent queuedEvent;
+	queuedEvent.event = event;
+	queuedEvent.audiences = audiences;
+	gameEventQueue.append(queuedEvent);
+	gameEventQueueGameId = gameId;
+	gameEventAudiences |= audiences;
+	if (audiences & AudiencePrivate)
+		privatePlayerId = _privatePlayerId;
 	if (context)
-		gameEventQueuePublic->setContext(context);
+		setGameEventContext(context);
 }
 
-void CommandContainer::enqueueGameEventOmniscient(GameEvent *event, int gameId, GameEventContext *context)
+void CommandContainer::setGameEventContext(GameEventContext *context)
 {
-	if (!gameEventQueueOmniscient)
-		gameEventQueueOmniscient = new GameEventContainer(QList<GameEvent *>(), gameId);
-	gameEventQueueOmniscient->addGameEvent(event);
-	if (context)
-		gameEventQueueOmniscient->setContext(context);
+	delete gameEventContext;
+	gameEventContext = context;
 }
 
-void CommandContainer::enqueueGameEventPrivate(GameEvent *event, int gameId, int playerId, GameEventContext *context)
+GameEventContainer *CommandContainer::makeGameEventContainer(GameEventAudience audience) const
 {
-	if (!gameEventQueuePrivate)
-		gameEventQueuePrivate = new GameEventContainer(QList<GameEvent *>(), gameId);
-	gameEventQueuePrivate->addGameEvent(event);
-	privatePlayerId = playerId;
-	if (context)
-		gameEventQueuePrivate->setContext(context);
+	if (!(gameEventAudiences & audience))
+		return 0;
+	
+	QList<GameEvent *> eventList;
+	for (int i = 0; i < gameEventQueue.size(); ++i)
+		if (gameEventQueue[i].audiences & audience)
+			eventList.append(gameEventQueue[i].event);
+	return new GameEventContainer(eventList, gameEventQueueGameId, gameEventContext);
 }
 
 Command_CreateGame::Command_CreateGame(int _roomId, const QString &_description, const QString &_password, int _maxPlayers, const QList<GameTypeId *> &_gameTypes, bool _onlyBuddies, bool _onlyRegistered, bool _spectatorsAllowed, bool _spectatorsNeedPassword, bool _spectatorsCanTalk, bool _spectatorsSeeEverything)
@@ -483,6 +591,13 @@ void GameEventContainer::addGameEvent(GameEvent *event)
 	eventList.append(event);
 }
 
+void GameEventContainer::releaseItems()
+{
+	itemList.clear();
+	eventList.clear();
+	context = 0;
+}
+
 GameEventContainer *GameEventContainer::makeNew(GameEvent *event, int _gameId)
 {
 	return new GameEventContainer(QList<GameEvent *>() << event, _gameId);
@@ -6,6 +6,7 @@
 #include <QHash>
 #include <QObject>
 #include <QVariant>
+#include <QMutex>
 #include "protocol_item_ids.h"
 #include "protocol_datastructures.h"
 
@@ -66,6 +67,8 @@ public:
 	void setReceiverMayDelete(bool _receiverMayDelete) { receiverMayDelete = _receiverMayDelete; }
 	ProtocolItem(const QString &_itemType, const QString &_itemSubType);
 	bool isEmpty() const { return false; }
+	// Appends nothing and returns false if the item can't be encoded.
+	bool writeBinaryFrame(QByteArray &buffer);
 };
 
 class ProtocolItem_Invalid : public ProtocolItem {
@@ -80,14 +83,39 @@ signals:
 	void protocolItemReceived(ProtocolItem *item);
 private:
 	ProtocolItem *currentItem;
+	QByteArray binaryBuffer;
 	bool readCurrentItem(QXmlStreamReader *xml);
 public:
+	static const int maxBinaryFrameSize = 16777216;
+	static const QByteArray binaryStreamMarker;
+	static const QByteArray deflateStreamMarker;
+	static QByteArray getBinaryRemainder(const QByteArray &data, const QByteArray &marker = binaryStreamMarker);
 	TopLevelProtocolItem();
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryData(const QByteArray &data);
 	bool isEmpty() const { return false; }
 };
 
+// Encodes an item at most once per wire format, so that a broadcast
+// does not serialize the same item again for every recipient. The
+// encoded data is implicitly shared with the output buffers.
+// Encoding is thread-safe, so one instance may be shared through a
+// QSharedPointer; with ownsItem set, the item dies with it.
+class EncodedProtocolItem {
+private:
+	ProtocolItem *item;
+	bool ownsItem;
+	QMutex encodeMutex;
+	QByteArray xmlData, binaryFrame;
+public:
+	EncodedProtocolItem(ProtocolItem *_item, bool _ownsItem = false) : item(_item), ownsItem(_ownsItem) { }
+	~EncodedProtocolItem();
+	ProtocolItem *getItem() const { return item; }
+	const QByteArray &getXmlData();
+	const QByteArray &getBinaryFrame();
+};
+
 // ----------------
 // --- COMMANDS ---
 // ----------------
@@ -106,6 +134,16 @@ public:
 	void processResponse(ProtocolResponse *response);
 };
 
+// Who gets to see a queued game event. The private audience is the player
+// whose hidden information is concerned, the omniscient audience are
+// spectators who see everything and the public audience is everyone else.
+enum GameEventAudience {
+	AudiencePrivate = 0x01,
+	AudienceOmniscient = 0x02,
+	AudiencePublic = 0x04,
+	AudienceAll = AudiencePrivate | AudienceOmniscient | AudiencePublic
+};
+
 class CommandContainer : public ProtocolItem {
 	Q_OBJECT
 signals:
@@ -119,12 +157,18 @@ private:
 	ProtocolResponse *resp;
 	QList<ProtocolItem *> itemQueue;
 	GameEventContext *gameEventContext;
-	GameEventContainer *gameEventQueuePublic;
-	GameEventContainer *gameEventQueueOmniscient;
-	GameEventContainer *gameEventQueuePrivate;
+	// Every event is stored once, together with the audiences it goes to.
+	struct QueuedGameEvent {
+		GameEvent *event;
+		int audiences;
+	};
+	QList<QueuedGameEvent> gameEventQueue;
+	int gameEventQueueGameId;
+	int gameEventAudiences;
 	int privatePlayerId;
 public:
 	CommandContainer(const QList<Command *> &_commandList = QList<Command *>(), int _cmdId = -1);
+	~CommandContainer();
 	static SerializableItem *newItem() { return new CommandContainer; }
 	int getItemId() const { return ItemId_CommandContainer; }
 	int getCmdId() const { return static_cast<SerializableItem_Int *>(itemMap.value("cmd_id"))->getData(); }
@@ -136,13 +180,17 @@ public:
 	void setResponse(ProtocolResponse *_resp);
 	const QList<ProtocolItem *> &getItemQueue() const { return itemQueue; }
 	void enqueueItem(ProtocolItem *item) { itemQueue.append(item); }
-	GameEventContainer *getGameEventQueuePublic() const { return gameEventQueuePublic; }
-	void enqueueGameEventPublic(GameEvent *event, int gameId, GameEventContext *context = 0);
-	GameEventContainer *getGameEventQueueOmniscient() const { return gameEventQueueOmniscient; }
-	void enqueueGameEventOmniscient(GameEvent *event, int gameId, GameEventContext *context = 0);
-	GameEventContainer *getGameEventQueuePrivate() const { return gameEventQueuePrivate; }
-	void enqueueGameEventPrivate(GameEvent *event, int gameId, int playerId = -1, GameEventContext *context = 0);
+	bool hasGameEvents() const { return !gameEventQueue.isEmpty(); }
+	bool hasGameEventsFor(GameEventAudience audience) const { return gameEventAudiences & audience; }
+	int getGameEventQueueGameId() const { return gameEventQueueGameId; }
 	int getPrivatePlayerId() const { return privatePlayerId; }
+	// Events that look the same to everybody are enqueued once for AudienceAll.
+	// Otherwise, enqueue one redacted version per set of audiences.
+	void enqueueGameEvent(GameEvent *event, int gameId, int audiences = AudienceAll, GameEventContext *context = 0, int _privatePlayerId = -1);
+	void setGameEventContext(GameEventContext *context);
+	// Returns the events for one audience, or 0 if there are none. The container
+	// only borrows them: call releaseItems() on it before deleting it.
+	GameEventContainer *makeGameEventContainer(GameEventAudience audience) const;
 };
 
 class RoomCommand : public Command {
@@ -392,6 +440,8 @@ public:
 	GameEventContext *getContext() const { return context; }
 	void setContext(GameEventContext *_context);
 	void addGameEvent(GameEvent *event);
+	// Forgets the events and the context without deleting them.
+	void releaseItems();
 	static GameEventContainer *makeNew(GameEvent *event, int _gameId);
 
 	int getGameId() const { return static_cast<SerializableItem_Int *>(itemMap.value("game_id"))->getData(); }
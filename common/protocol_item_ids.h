@@ -81,8 +81,9 @@ ItemId_Context_DeckSelect = 1079,
 ItemId_Context_UndoDraw = 1080,
 ItemId_Context_MoveCard = 1081,
 ItemId_Context_Mulligan = 1082,
-ItemId_Command_UpdateServerMessage = 1083,
-ItemId_Command_ShutdownServer = 1084,
-ItemId_Command_BanFromServer = 1085,
-ItemId_Other = 1086
+ItemId_Context_StateReplay = 1083,
+ItemId_Command_UpdateServerMessage = 1084,
+ItemId_Command_ShutdownServer = 1085,
+ItemId_Command_BanFromServer = 1086,
+ItemId_Other = 1087
 };
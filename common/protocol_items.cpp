@@ -1,3 +1,5 @@
+#include <QXmlStreamWriter>
+#include <QDataStream>
 #include "protocol.h"
 #include "protocol_items.h"
 
@@ -6,107 +8,589 @@ Command_Ping::Command_Ping()
 {
 }
 Command_Login::Command_Login(const QString &_username, const QString &_password)
-	: Command("login")
+	: Command("login"), username(_username), password(_password)
 {
-	insertItem(new SerializableItem_String("username", _username));
-	insertItem(new SerializableItem_String("password", _password));
+}
+int Command_Login::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 8:
+		if (fieldName == QLatin1String("username"))
+			return 0;
+		if (fieldName == QLatin1String("password"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Command_Login::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: username.append(fieldText); break;
+	case 1: password.append(fieldText); break;
+	}
+}
+void Command_Login::writeFields(QXmlStreamWriter *xml)
+{
+	if (!username.isEmpty())
+		xml->writeTextElement("username", username);
+	if (!password.isEmpty())
+		xml->writeTextElement("password", password);
+}
+void Command_Login::readBinaryFields(QDataStream &in)
+{
+	in >> username;
+	in >> password;
+}
+void Command_Login::writeBinaryFields(QDataStream &out)
+{
+	out << username;
+	out << password;
 }
 Command_Message::Command_Message(const QString &_userName, const QString &_text)
-	: Command("message")
+	: Command("message"), userName(_userName), text(_text)
+{
+}
+int Command_Message::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("text"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_Message::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: userName.append(fieldText); break;
+	case 1: text.append(fieldText); break;
+	}
+}
+void Command_Message::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("user_name", _userName));
-	insertItem(new SerializableItem_String("text", _text));
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+	if (!text.isEmpty())
+		xml->writeTextElement("text", text);
+}
+void Command_Message::readBinaryFields(QDataStream &in)
+{
+	in >> userName;
+	in >> text;
+}
+void Command_Message::writeBinaryFields(QDataStream &out)
+{
+	out << userName;
+	out << text;
 }
 Command_ListUsers::Command_ListUsers()
 	: Command("list_users")
 {
 }
 Command_GetGamesOfUser::Command_GetGamesOfUser(const QString &_userName)
-	: Command("get_games_of_user")
+	: Command("get_games_of_user"), userName(_userName)
+{
+}
+int Command_GetGamesOfUser::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_GetGamesOfUser::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("user_name", _userName));
+	switch (index) {
+	case 0: userName.append(fieldText); break;
+	}
+}
+void Command_GetGamesOfUser::writeFields(QXmlStreamWriter *xml)
+{
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+}
+void Command_GetGamesOfUser::readBinaryFields(QDataStream &in)
+{
+	in >> userName;
+}
+void Command_GetGamesOfUser::writeBinaryFields(QDataStream &out)
+{
+	out << userName;
 }
 Command_GetUserInfo::Command_GetUserInfo(const QString &_userName)
-	: Command("get_user_info")
+	: Command("get_user_info"), userName(_userName)
+{
+}
+int Command_GetUserInfo::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_GetUserInfo::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: userName.append(fieldText); break;
+	}
+}
+void Command_GetUserInfo::writeFields(QXmlStreamWriter *xml)
+{
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+}
+void Command_GetUserInfo::readBinaryFields(QDataStream &in)
+{
+	in >> userName;
+}
+void Command_GetUserInfo::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_String("user_name", _userName));
+	out << userName;
 }
 Command_AddToList::Command_AddToList(const QString &_list, const QString &_userName)
-	: Command("add_to_list")
+	: Command("add_to_list"), list(_list), userName(_userName)
+{
+}
+int Command_AddToList::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("list"))
+			return 0;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Command_AddToList::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: list.append(fieldText); break;
+	case 1: userName.append(fieldText); break;
+	}
+}
+void Command_AddToList::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("list", _list));
-	insertItem(new SerializableItem_String("user_name", _userName));
+	if (!list.isEmpty())
+		xml->writeTextElement("list", list);
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+}
+void Command_AddToList::readBinaryFields(QDataStream &in)
+{
+	in >> list;
+	in >> userName;
+}
+void Command_AddToList::writeBinaryFields(QDataStream &out)
+{
+	out << list;
+	out << userName;
 }
 Command_RemoveFromList::Command_RemoveFromList(const QString &_list, const QString &_userName)
-	: Command("remove_from_list")
+	: Command("remove_from_list"), list(_list), userName(_userName)
+{
+}
+int Command_RemoveFromList::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("list"))
+			return 0;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Command_RemoveFromList::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("list", _list));
-	insertItem(new SerializableItem_String("user_name", _userName));
+	switch (index) {
+	case 0: list.append(fieldText); break;
+	case 1: userName.append(fieldText); break;
+	}
+}
+void Command_RemoveFromList::writeFields(QXmlStreamWriter *xml)
+{
+	if (!list.isEmpty())
+		xml->writeTextElement("list", list);
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+}
+void Command_RemoveFromList::readBinaryFields(QDataStream &in)
+{
+	in >> list;
+	in >> userName;
+}
+void Command_RemoveFromList::writeBinaryFields(QDataStream &out)
+{
+	out << list;
+	out << userName;
 }
 Command_DeckList::Command_DeckList()
 	: Command("deck_list")
 {
 }
 Command_DeckNewDir::Command_DeckNewDir(const QString &_path, const QString &_dirName)
-	: Command("deck_new_dir")
+	: Command("deck_new_dir"), path(_path), dirName(_dirName)
+{
+}
+int Command_DeckNewDir::getFieldIndex(const QStringRef &fieldName) const
 {
-	insertItem(new SerializableItem_String("path", _path));
-	insertItem(new SerializableItem_String("dir_name", _dirName));
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("path"))
+			return 0;
+		break;
+	case 8:
+		if (fieldName == QLatin1String("dir_name"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Command_DeckNewDir::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: path.append(fieldText); break;
+	case 1: dirName.append(fieldText); break;
+	}
+}
+void Command_DeckNewDir::writeFields(QXmlStreamWriter *xml)
+{
+	if (!path.isEmpty())
+		xml->writeTextElement("path", path);
+	if (!dirName.isEmpty())
+		xml->writeTextElement("dir_name", dirName);
+}
+void Command_DeckNewDir::readBinaryFields(QDataStream &in)
+{
+	in >> path;
+	in >> dirName;
+}
+void Command_DeckNewDir::writeBinaryFields(QDataStream &out)
+{
+	out << path;
+	out << dirName;
 }
 Command_DeckDelDir::Command_DeckDelDir(const QString &_path)
-	: Command("deck_del_dir")
+	: Command("deck_del_dir"), path(_path)
+{
+}
+int Command_DeckDelDir::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("path"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_DeckDelDir::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: path.append(fieldText); break;
+	}
+}
+void Command_DeckDelDir::writeFields(QXmlStreamWriter *xml)
+{
+	if (!path.isEmpty())
+		xml->writeTextElement("path", path);
+}
+void Command_DeckDelDir::readBinaryFields(QDataStream &in)
 {
-	insertItem(new SerializableItem_String("path", _path));
+	in >> path;
+}
+void Command_DeckDelDir::writeBinaryFields(QDataStream &out)
+{
+	out << path;
 }
 Command_DeckDel::Command_DeckDel(int _deckId)
-	: Command("deck_del")
+	: Command("deck_del"), deckId(_deckId)
+{
+}
+int Command_DeckDel::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("deck_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_DeckDel::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: deckId = intFromText(fieldText); break;
+	}
+}
+void Command_DeckDel::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_Int("deck_id", _deckId));
+	if (deckId != -1)
+		xml->writeTextElement("deck_id", QString::number(deckId));
+}
+void Command_DeckDel::readBinaryFields(QDataStream &in)
+{
+	deckId = readBinaryInt(in);
+}
+void Command_DeckDel::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) deckId;
 }
 Command_DeckDownload::Command_DeckDownload(int _deckId)
-	: Command("deck_download")
+	: Command("deck_download"), deckId(_deckId)
+{
+}
+int Command_DeckDownload::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("deck_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_DeckDownload::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: deckId = intFromText(fieldText); break;
+	}
+}
+void Command_DeckDownload::writeFields(QXmlStreamWriter *xml)
+{
+	if (deckId != -1)
+		xml->writeTextElement("deck_id", QString::number(deckId));
+}
+void Command_DeckDownload::readBinaryFields(QDataStream &in)
+{
+	deckId = readBinaryInt(in);
+}
+void Command_DeckDownload::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("deck_id", _deckId));
+	out << (qint32) deckId;
 }
 Command_ListRooms::Command_ListRooms()
 	: Command("list_rooms")
 {
 }
 Command_JoinRoom::Command_JoinRoom(int _roomId)
-	: Command("join_room")
+	: Command("join_room"), roomId(_roomId)
+{
+}
+int Command_JoinRoom::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("room_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_JoinRoom::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: roomId = intFromText(fieldText); break;
+	}
+}
+void Command_JoinRoom::writeFields(QXmlStreamWriter *xml)
+{
+	if (roomId != -1)
+		xml->writeTextElement("room_id", QString::number(roomId));
+}
+void Command_JoinRoom::readBinaryFields(QDataStream &in)
 {
-	insertItem(new SerializableItem_Int("room_id", _roomId));
+	roomId = readBinaryInt(in);
+}
+void Command_JoinRoom::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) roomId;
 }
 Command_LeaveRoom::Command_LeaveRoom(int _roomId)
 	: RoomCommand("leave_room", _roomId)
 {
 }
 Command_RoomSay::Command_RoomSay(int _roomId, const QString &_message)
-	: RoomCommand("room_say", _roomId)
+	: RoomCommand("room_say", _roomId), message(_message)
 {
-	insertItem(new SerializableItem_String("message", _message));
 }
-Command_JoinGame::Command_JoinGame(int _roomId, int _gameId, const QString &_password, bool _spectator, bool _overrideRestrictions)
-	: RoomCommand("join_game", _roomId)
+int Command_RoomSay::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("message"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_RoomSay::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: message.append(fieldText); break;
+	}
+}
+void Command_RoomSay::writeFields(QXmlStreamWriter *xml)
+{
+	if (!message.isEmpty())
+		xml->writeTextElement("message", message);
+}
+void Command_RoomSay::readBinaryFields(QDataStream &in)
 {
-	insertItem(new SerializableItem_Int("game_id", _gameId));
-	insertItem(new SerializableItem_String("password", _password));
-	insertItem(new SerializableItem_Bool("spectator", _spectator));
-	insertItem(new SerializableItem_Bool("override_restrictions", _overrideRestrictions));
+	in >> message;
+}
+void Command_RoomSay::writeBinaryFields(QDataStream &out)
+{
+	out << message;
+}
+Command_JoinGame::Command_JoinGame(int _roomId, int _gameId, const QString &_password, bool _spectator, bool _overrideRestrictions)
+	: RoomCommand("join_game", _roomId), gameId(_gameId), password(_password), spectator(_spectator), overrideRestrictions(_overrideRestrictions)
+{
+}
+int Command_JoinGame::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("game_id"))
+			return 0;
+		break;
+	case 8:
+		if (fieldName == QLatin1String("password"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("spectator"))
+			return 2;
+		break;
+	case 21:
+		if (fieldName == QLatin1String("override_restrictions"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Command_JoinGame::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: gameId = intFromText(fieldText); break;
+	case 1: password.append(fieldText); break;
+	case 2: spectator = boolFromText(fieldText); break;
+	case 3: overrideRestrictions = boolFromText(fieldText); break;
+	}
+}
+void Command_JoinGame::writeFields(QXmlStreamWriter *xml)
+{
+	if (gameId != -1)
+		xml->writeTextElement("game_id", QString::number(gameId));
+	if (!password.isEmpty())
+		xml->writeTextElement("password", password);
+	if (spectator)
+		xml->writeTextElement("spectator", "1");
+	if (overrideRestrictions)
+		xml->writeTextElement("override_restrictions", "1");
+}
+void Command_JoinGame::readBinaryFields(QDataStream &in)
+{
+	gameId = readBinaryInt(in);
+	in >> password;
+	spectator = readBinaryBool(in);
+	overrideRestrictions = readBinaryBool(in);
+}
+void Command_JoinGame::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) gameId;
+	out << password;
+	out << (quint8) spectator;
+	out << (quint8) overrideRestrictions;
 }
 Command_KickFromGame::Command_KickFromGame(int _gameId, int _playerId)
-	: GameCommand("kick_from_game", _gameId)
+	: GameCommand("kick_from_game", _gameId), playerId(_playerId)
+{
+}
+int Command_KickFromGame::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("player_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_KickFromGame::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: playerId = intFromText(fieldText); break;
+	}
+}
+void Command_KickFromGame::writeFields(QXmlStreamWriter *xml)
+{
+	if (playerId != -1)
+		xml->writeTextElement("player_id", QString::number(playerId));
+}
+void Command_KickFromGame::readBinaryFields(QDataStream &in)
+{
+	playerId = readBinaryInt(in);
+}
+void Command_KickFromGame::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("player_id", _playerId));
+	out << (qint32) playerId;
 }
 Command_LeaveGame::Command_LeaveGame(int _gameId)
 	: GameCommand("leave_game", _gameId)
 {
 }
 Command_Say::Command_Say(int _gameId, const QString &_message)
-	: GameCommand("say", _gameId)
+	: GameCommand("say", _gameId), message(_message)
+{
+}
+int Command_Say::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("message"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_Say::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: message.append(fieldText); break;
+	}
+}
+void Command_Say::writeFields(QXmlStreamWriter *xml)
+{
+	if (!message.isEmpty())
+		xml->writeTextElement("message", message);
+}
+void Command_Say::readBinaryFields(QDataStream &in)
 {
-	insertItem(new SerializableItem_String("message", _message));
+	in >> message;
+}
+void Command_Say::writeBinaryFields(QDataStream &out)
+{
+	out << message;
 }
 Command_Shuffle::Command_Shuffle(int _gameId)
 	: GameCommand("shuffle", _gameId)
@@ -117,159 +601,1041 @@ Command_Mulligan::Command_Mulligan(int _gameId)
 {
 }
 Command_RollDie::Command_RollDie(int _gameId, int _sides)
-	: GameCommand("roll_die", _gameId)
+	: GameCommand("roll_die", _gameId), sides(_sides)
+{
+}
+int Command_RollDie::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("sides"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_RollDie::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: sides = intFromText(fieldText); break;
+	}
+}
+void Command_RollDie::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_Int("sides", _sides));
+	if (sides != -1)
+		xml->writeTextElement("sides", QString::number(sides));
+}
+void Command_RollDie::readBinaryFields(QDataStream &in)
+{
+	sides = readBinaryInt(in);
+}
+void Command_RollDie::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) sides;
 }
 Command_DrawCards::Command_DrawCards(int _gameId, int _number)
-	: GameCommand("draw_cards", _gameId)
+	: GameCommand("draw_cards", _gameId), number(_number)
+{
+}
+int Command_DrawCards::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 6:
+		if (fieldName == QLatin1String("number"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_DrawCards::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_Int("number", _number));
+	switch (index) {
+	case 0: number = intFromText(fieldText); break;
+	}
+}
+void Command_DrawCards::writeFields(QXmlStreamWriter *xml)
+{
+	if (number != -1)
+		xml->writeTextElement("number", QString::number(number));
+}
+void Command_DrawCards::readBinaryFields(QDataStream &in)
+{
+	number = readBinaryInt(in);
+}
+void Command_DrawCards::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) number;
 }
 Command_UndoDraw::Command_UndoDraw(int _gameId)
 	: GameCommand("undo_draw", _gameId)
 {
 }
 Command_FlipCard::Command_FlipCard(int _gameId, const QString &_zone, int _cardId, bool _faceDown)
-	: GameCommand("flip_card", _gameId)
+	: GameCommand("flip_card", _gameId), zone(_zone), cardId(_cardId), faceDown(_faceDown)
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Bool("face_down", _faceDown));
 }
-Command_AttachCard::Command_AttachCard(int _gameId, const QString &_startZone, int _cardId, int _targetPlayerId, const QString &_targetZone, int _targetCardId)
-	: GameCommand("attach_card", _gameId)
+int Command_FlipCard::getFieldIndex(const QStringRef &fieldName) const
 {
-	insertItem(new SerializableItem_String("start_zone", _startZone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Int("target_player_id", _targetPlayerId));
-	insertItem(new SerializableItem_String("target_zone", _targetZone));
-	insertItem(new SerializableItem_Int("target_card_id", _targetCardId));
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("face_down"))
+			return 2;
+		break;
+	}
+	return -1;
 }
-Command_CreateToken::Command_CreateToken(int _gameId, const QString &_zone, const QString &_cardName, const QString &_color, const QString &_pt, const QString &_annotation, bool _destroy, int _x, int _y)
-	: GameCommand("create_token", _gameId)
+void Command_FlipCard::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_String("card_name", _cardName));
-	insertItem(new SerializableItem_String("color", _color));
-	insertItem(new SerializableItem_String("pt", _pt));
-	insertItem(new SerializableItem_String("annotation", _annotation));
-	insertItem(new SerializableItem_Bool("destroy", _destroy));
-	insertItem(new SerializableItem_Int("x", _x));
-	insertItem(new SerializableItem_Int("y", _y));
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: faceDown = boolFromText(fieldText); break;
+	}
 }
-Command_CreateArrow::Command_CreateArrow(int _gameId, int _startPlayerId, const QString &_startZone, int _startCardId, int _targetPlayerId, const QString &_targetZone, int _targetCardId, const Color &_color)
-	: GameCommand("create_arrow", _gameId)
+void Command_FlipCard::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (faceDown)
+		xml->writeTextElement("face_down", "1");
+}
+void Command_FlipCard::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	faceDown = readBinaryBool(in);
+}
+void Command_FlipCard::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("start_player_id", _startPlayerId));
-	insertItem(new SerializableItem_String("start_zone", _startZone));
-	insertItem(new SerializableItem_Int("start_card_id", _startCardId));
-	insertItem(new SerializableItem_Int("target_player_id", _targetPlayerId));
-	insertItem(new SerializableItem_String("target_zone", _targetZone));
-	insertItem(new SerializableItem_Int("target_card_id", _targetCardId));
-	insertItem(new SerializableItem_Color("color", _color));
+	out << zone;
+	out << (qint32) cardId;
+	out << (quint8) faceDown;
+}
+Command_AttachCard::Command_AttachCard(int _gameId, const QString &_startZone, int _cardId, int _targetPlayerId, const QString &_targetZone, int _targetCardId)
+	: GameCommand("attach_card", _gameId), startZone(_startZone), cardId(_cardId), targetPlayerId(_targetPlayerId), targetZone(_targetZone), targetCardId(_targetCardId)
+{
+}
+int Command_AttachCard::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("start_zone"))
+			return 0;
+		break;
+	case 11:
+		if (fieldName == QLatin1String("target_zone"))
+			return 3;
+		break;
+	case 14:
+		if (fieldName == QLatin1String("target_card_id"))
+			return 4;
+		break;
+	case 16:
+		if (fieldName == QLatin1String("target_player_id"))
+			return 2;
+		break;
+	}
+	return -1;
+}
+void Command_AttachCard::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: startZone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: targetPlayerId = intFromText(fieldText); break;
+	case 3: targetZone.append(fieldText); break;
+	case 4: targetCardId = intFromText(fieldText); break;
+	}
+}
+void Command_AttachCard::writeFields(QXmlStreamWriter *xml)
+{
+	if (!startZone.isEmpty())
+		xml->writeTextElement("start_zone", startZone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (targetPlayerId != -1)
+		xml->writeTextElement("target_player_id", QString::number(targetPlayerId));
+	if (!targetZone.isEmpty())
+		xml->writeTextElement("target_zone", targetZone);
+	if (targetCardId != -1)
+		xml->writeTextElement("target_card_id", QString::number(targetCardId));
+}
+void Command_AttachCard::readBinaryFields(QDataStream &in)
+{
+	in >> startZone;
+	cardId = readBinaryInt(in);
+	targetPlayerId = readBinaryInt(in);
+	in >> targetZone;
+	targetCardId = readBinaryInt(in);
+}
+void Command_AttachCard::writeBinaryFields(QDataStream &out)
+{
+	out << startZone;
+	out << (qint32) cardId;
+	out << (qint32) targetPlayerId;
+	out << targetZone;
+	out << (qint32) targetCardId;
+}
+Command_CreateToken::Command_CreateToken(int _gameId, const QString &_zone, const QString &_cardName, const QString &_color, const QString &_pt, const QString &_annotation, bool _destroy, int _x, int _y)
+	: GameCommand("create_token", _gameId), zone(_zone), cardName(_cardName), color(_color), pt(_pt), annotation(_annotation), destroy(_destroy), x(_x), y(_y)
+{
+}
+int Command_CreateToken::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 1:
+		if (fieldName == QLatin1String("x"))
+			return 6;
+		if (fieldName == QLatin1String("y"))
+			return 7;
+		break;
+	case 2:
+		if (fieldName == QLatin1String("pt"))
+			return 3;
+		break;
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 5:
+		if (fieldName == QLatin1String("color"))
+			return 2;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("destroy"))
+			return 5;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("card_name"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("annotation"))
+			return 4;
+		break;
+	}
+	return -1;
+}
+void Command_CreateToken::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardName.append(fieldText); break;
+	case 2: color.append(fieldText); break;
+	case 3: pt.append(fieldText); break;
+	case 4: annotation.append(fieldText); break;
+	case 5: destroy = boolFromText(fieldText); break;
+	case 6: x = intFromText(fieldText); break;
+	case 7: y = intFromText(fieldText); break;
+	}
+}
+void Command_CreateToken::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (!cardName.isEmpty())
+		xml->writeTextElement("card_name", cardName);
+	if (!color.isEmpty())
+		xml->writeTextElement("color", color);
+	if (!pt.isEmpty())
+		xml->writeTextElement("pt", pt);
+	if (!annotation.isEmpty())
+		xml->writeTextElement("annotation", annotation);
+	if (destroy)
+		xml->writeTextElement("destroy", "1");
+	if (x != -1)
+		xml->writeTextElement("x", QString::number(x));
+	if (y != -1)
+		xml->writeTextElement("y", QString::number(y));
+}
+void Command_CreateToken::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	in >> cardName;
+	in >> color;
+	in >> pt;
+	in >> annotation;
+	destroy = readBinaryBool(in);
+	x = readBinaryInt(in);
+	y = readBinaryInt(in);
+}
+void Command_CreateToken::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << cardName;
+	out << color;
+	out << pt;
+	out << annotation;
+	out << (quint8) destroy;
+	out << (qint32) x;
+	out << (qint32) y;
+}
+Command_CreateArrow::Command_CreateArrow(int _gameId, int _startPlayerId, const QString &_startZone, int _startCardId, int _targetPlayerId, const QString &_targetZone, int _targetCardId, const Color &_color)
+	: GameCommand("create_arrow", _gameId), startPlayerId(_startPlayerId), startZone(_startZone), startCardId(_startCardId), targetPlayerId(_targetPlayerId), targetZone(_targetZone), targetCardId(_targetCardId), color(_color)
+{
+}
+int Command_CreateArrow::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("color"))
+			return 6;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("start_zone"))
+			return 1;
+		break;
+	case 11:
+		if (fieldName == QLatin1String("target_zone"))
+			return 4;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("start_card_id"))
+			return 2;
+		break;
+	case 14:
+		if (fieldName == QLatin1String("target_card_id"))
+			return 5;
+		break;
+	case 15:
+		if (fieldName == QLatin1String("start_player_id"))
+			return 0;
+		break;
+	case 16:
+		if (fieldName == QLatin1String("target_player_id"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Command_CreateArrow::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: startPlayerId = intFromText(fieldText); break;
+	case 1: startZone.append(fieldText); break;
+	case 2: startCardId = intFromText(fieldText); break;
+	case 3: targetPlayerId = intFromText(fieldText); break;
+	case 4: targetZone.append(fieldText); break;
+	case 5: targetCardId = intFromText(fieldText); break;
+	case 6: color = colorFromText(fieldText); break;
+	}
+}
+void Command_CreateArrow::writeFields(QXmlStreamWriter *xml)
+{
+	if (startPlayerId != -1)
+		xml->writeTextElement("start_player_id", QString::number(startPlayerId));
+	if (!startZone.isEmpty())
+		xml->writeTextElement("start_zone", startZone);
+	if (startCardId != -1)
+		xml->writeTextElement("start_card_id", QString::number(startCardId));
+	if (targetPlayerId != -1)
+		xml->writeTextElement("target_player_id", QString::number(targetPlayerId));
+	if (!targetZone.isEmpty())
+		xml->writeTextElement("target_zone", targetZone);
+	if (targetCardId != -1)
+		xml->writeTextElement("target_card_id", QString::number(targetCardId));
+	if (color.getValue() != 0)
+		xml->writeTextElement("color", QString::number(color.getValue()));
+}
+void Command_CreateArrow::readBinaryFields(QDataStream &in)
+{
+	startPlayerId = readBinaryInt(in);
+	in >> startZone;
+	startCardId = readBinaryInt(in);
+	targetPlayerId = readBinaryInt(in);
+	in >> targetZone;
+	targetCardId = readBinaryInt(in);
+	color = Color(readBinaryInt(in));
+}
+void Command_CreateArrow::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) startPlayerId;
+	out << startZone;
+	out << (qint32) startCardId;
+	out << (qint32) targetPlayerId;
+	out << targetZone;
+	out << (qint32) targetCardId;
+	out << (qint32) color.getValue();
 }
 Command_DeleteArrow::Command_DeleteArrow(int _gameId, int _arrowId)
-	: GameCommand("delete_arrow", _gameId)
+	: GameCommand("delete_arrow", _gameId), arrowId(_arrowId)
 {
-	insertItem(new SerializableItem_Int("arrow_id", _arrowId));
 }
-Command_SetCardAttr::Command_SetCardAttr(int _gameId, const QString &_zone, int _cardId, const QString &_attrName, const QString &_attrValue)
-	: GameCommand("set_card_attr", _gameId)
+int Command_DeleteArrow::getFieldIndex(const QStringRef &fieldName) const
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_String("attr_name", _attrName));
-	insertItem(new SerializableItem_String("attr_value", _attrValue));
+	switch (fieldName.size()) {
+	case 8:
+		if (fieldName == QLatin1String("arrow_id"))
+			return 0;
+		break;
+	}
+	return -1;
 }
-Command_SetCardCounter::Command_SetCardCounter(int _gameId, const QString &_zone, int _cardId, int _counterId, int _counterValue)
-	: GameCommand("set_card_counter", _gameId)
+void Command_DeleteArrow::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
-	insertItem(new SerializableItem_Int("counter_value", _counterValue));
+	switch (index) {
+	case 0: arrowId = intFromText(fieldText); break;
+	}
 }
-Command_IncCardCounter::Command_IncCardCounter(int _gameId, const QString &_zone, int _cardId, int _counterId, int _counterDelta)
-	: GameCommand("inc_card_counter", _gameId)
+void Command_DeleteArrow::writeFields(QXmlStreamWriter *xml)
+{
+	if (arrowId != -1)
+		xml->writeTextElement("arrow_id", QString::number(arrowId));
+}
+void Command_DeleteArrow::readBinaryFields(QDataStream &in)
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
-	insertItem(new SerializableItem_Int("counter_delta", _counterDelta));
+	arrowId = readBinaryInt(in);
+}
+void Command_DeleteArrow::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) arrowId;
+}
+Command_SetCardAttr::Command_SetCardAttr(int _gameId, const QString &_zone, int _cardId, const QString &_attrName, const QString &_attrValue)
+	: GameCommand("set_card_attr", _gameId), zone(_zone), cardId(_cardId), attrName(_attrName), attrValue(_attrValue)
+{
+}
+int Command_SetCardAttr::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("attr_name"))
+			return 2;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("attr_value"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Command_SetCardAttr::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: attrName.append(fieldText); break;
+	case 3: attrValue.append(fieldText); break;
+	}
+}
+void Command_SetCardAttr::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (!attrName.isEmpty())
+		xml->writeTextElement("attr_name", attrName);
+	if (!attrValue.isEmpty())
+		xml->writeTextElement("attr_value", attrValue);
+}
+void Command_SetCardAttr::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	in >> attrName;
+	in >> attrValue;
+}
+void Command_SetCardAttr::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << attrName;
+	out << attrValue;
+}
+Command_SetCardCounter::Command_SetCardCounter(int _gameId, const QString &_zone, int _cardId, int _counterId, int _counterValue)
+	: GameCommand("set_card_counter", _gameId), zone(_zone), cardId(_cardId), counterId(_counterId), counterValue(_counterValue)
+{
+}
+int Command_SetCardCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 2;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("counter_value"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Command_SetCardCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: counterId = intFromText(fieldText); break;
+	case 3: counterValue = intFromText(fieldText); break;
+	}
+}
+void Command_SetCardCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+	if (counterValue != -1)
+		xml->writeTextElement("counter_value", QString::number(counterValue));
+}
+void Command_SetCardCounter::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	counterId = readBinaryInt(in);
+	counterValue = readBinaryInt(in);
+}
+void Command_SetCardCounter::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << (qint32) counterId;
+	out << (qint32) counterValue;
+}
+Command_IncCardCounter::Command_IncCardCounter(int _gameId, const QString &_zone, int _cardId, int _counterId, int _counterDelta)
+	: GameCommand("inc_card_counter", _gameId), zone(_zone), cardId(_cardId), counterId(_counterId), counterDelta(_counterDelta)
+{
+}
+int Command_IncCardCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 2;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("counter_delta"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Command_IncCardCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: counterId = intFromText(fieldText); break;
+	case 3: counterDelta = intFromText(fieldText); break;
+	}
+}
+void Command_IncCardCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+	if (counterDelta != -1)
+		xml->writeTextElement("counter_delta", QString::number(counterDelta));
+}
+void Command_IncCardCounter::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	counterId = readBinaryInt(in);
+	counterDelta = readBinaryInt(in);
+}
+void Command_IncCardCounter::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << (qint32) counterId;
+	out << (qint32) counterDelta;
 }
 Command_ReadyStart::Command_ReadyStart(int _gameId, bool _ready)
-	: GameCommand("ready_start", _gameId)
+	: GameCommand("ready_start", _gameId), ready(_ready)
+{
+}
+int Command_ReadyStart::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("ready"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_ReadyStart::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: ready = boolFromText(fieldText); break;
+	}
+}
+void Command_ReadyStart::writeFields(QXmlStreamWriter *xml)
+{
+	if (ready)
+		xml->writeTextElement("ready", "1");
+}
+void Command_ReadyStart::readBinaryFields(QDataStream &in)
+{
+	ready = readBinaryBool(in);
+}
+void Command_ReadyStart::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Bool("ready", _ready));
+	out << (quint8) ready;
 }
 Command_Concede::Command_Concede(int _gameId)
 	: GameCommand("concede", _gameId)
 {
 }
 Command_IncCounter::Command_IncCounter(int _gameId, int _counterId, int _delta)
-	: GameCommand("inc_counter", _gameId)
+	: GameCommand("inc_counter", _gameId), counterId(_counterId), delta(_delta)
 {
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
-	insertItem(new SerializableItem_Int("delta", _delta));
 }
-Command_CreateCounter::Command_CreateCounter(int _gameId, const QString &_counterName, const Color &_color, int _radius, int _value)
-	: GameCommand("create_counter", _gameId)
+int Command_IncCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("delta"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_IncCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: counterId = intFromText(fieldText); break;
+	case 1: delta = intFromText(fieldText); break;
+	}
+}
+void Command_IncCounter::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("counter_name", _counterName));
-	insertItem(new SerializableItem_Color("color", _color));
-	insertItem(new SerializableItem_Int("radius", _radius));
-	insertItem(new SerializableItem_Int("value", _value));
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+	if (delta != -1)
+		xml->writeTextElement("delta", QString::number(delta));
+}
+void Command_IncCounter::readBinaryFields(QDataStream &in)
+{
+	counterId = readBinaryInt(in);
+	delta = readBinaryInt(in);
+}
+void Command_IncCounter::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) counterId;
+	out << (qint32) delta;
+}
+Command_CreateCounter::Command_CreateCounter(int _gameId, const QString &_counterName, const Color &_color, int _radius, int _value)
+	: GameCommand("create_counter", _gameId), counterName(_counterName), color(_color), radius(_radius), value(_value)
+{
+}
+int Command_CreateCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("color"))
+			return 1;
+		if (fieldName == QLatin1String("value"))
+			return 3;
+		break;
+	case 6:
+		if (fieldName == QLatin1String("radius"))
+			return 2;
+		break;
+	case 12:
+		if (fieldName == QLatin1String("counter_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_CreateCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: counterName.append(fieldText); break;
+	case 1: color = colorFromText(fieldText); break;
+	case 2: radius = intFromText(fieldText); break;
+	case 3: value = intFromText(fieldText); break;
+	}
+}
+void Command_CreateCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (!counterName.isEmpty())
+		xml->writeTextElement("counter_name", counterName);
+	if (color.getValue() != 0)
+		xml->writeTextElement("color", QString::number(color.getValue()));
+	if (radius != -1)
+		xml->writeTextElement("radius", QString::number(radius));
+	if (value != -1)
+		xml->writeTextElement("value", QString::number(value));
+}
+void Command_CreateCounter::readBinaryFields(QDataStream &in)
+{
+	in >> counterName;
+	color = Color(readBinaryInt(in));
+	radius = readBinaryInt(in);
+	value = readBinaryInt(in);
+}
+void Command_CreateCounter::writeBinaryFields(QDataStream &out)
+{
+	out << counterName;
+	out << (qint32) color.getValue();
+	out << (qint32) radius;
+	out << (qint32) value;
 }
 Command_SetCounter::Command_SetCounter(int _gameId, int _counterId, int _value)
-	: GameCommand("set_counter", _gameId)
+	: GameCommand("set_counter", _gameId), counterId(_counterId), value(_value)
+{
+}
+int Command_SetCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("value"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_SetCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: counterId = intFromText(fieldText); break;
+	case 1: value = intFromText(fieldText); break;
+	}
+}
+void Command_SetCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+	if (value != -1)
+		xml->writeTextElement("value", QString::number(value));
+}
+void Command_SetCounter::readBinaryFields(QDataStream &in)
+{
+	counterId = readBinaryInt(in);
+	value = readBinaryInt(in);
+}
+void Command_SetCounter::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
-	insertItem(new SerializableItem_Int("value", _value));
+	out << (qint32) counterId;
+	out << (qint32) value;
 }
 Command_DelCounter::Command_DelCounter(int _gameId, int _counterId)
-	: GameCommand("del_counter", _gameId)
+	: GameCommand("del_counter", _gameId), counterId(_counterId)
+{
+}
+int Command_DelCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_DelCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: counterId = intFromText(fieldText); break;
+	}
+}
+void Command_DelCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+}
+void Command_DelCounter::readBinaryFields(QDataStream &in)
+{
+	counterId = readBinaryInt(in);
+}
+void Command_DelCounter::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
+	out << (qint32) counterId;
 }
 Command_NextTurn::Command_NextTurn(int _gameId)
 	: GameCommand("next_turn", _gameId)
 {
 }
 Command_SetActivePhase::Command_SetActivePhase(int _gameId, int _phase)
-	: GameCommand("set_active_phase", _gameId)
+	: GameCommand("set_active_phase", _gameId), phase(_phase)
+{
+}
+int Command_SetActivePhase::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("phase"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_SetActivePhase::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_Int("phase", _phase));
+	switch (index) {
+	case 0: phase = intFromText(fieldText); break;
+	}
+}
+void Command_SetActivePhase::writeFields(QXmlStreamWriter *xml)
+{
+	if (phase != -1)
+		xml->writeTextElement("phase", QString::number(phase));
+}
+void Command_SetActivePhase::readBinaryFields(QDataStream &in)
+{
+	phase = readBinaryInt(in);
+}
+void Command_SetActivePhase::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) phase;
 }
 Command_DumpZone::Command_DumpZone(int _gameId, int _playerId, const QString &_zoneName, int _numberCards)
-	: GameCommand("dump_zone", _gameId)
+	: GameCommand("dump_zone", _gameId), playerId(_playerId), zoneName(_zoneName), numberCards(_numberCards)
+{
+}
+int Command_DumpZone::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("player_id"))
+			return 0;
+		if (fieldName == QLatin1String("zone_name"))
+			return 1;
+		break;
+	case 12:
+		if (fieldName == QLatin1String("number_cards"))
+			return 2;
+		break;
+	}
+	return -1;
+}
+void Command_DumpZone::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: playerId = intFromText(fieldText); break;
+	case 1: zoneName.append(fieldText); break;
+	case 2: numberCards = intFromText(fieldText); break;
+	}
+}
+void Command_DumpZone::writeFields(QXmlStreamWriter *xml)
+{
+	if (playerId != -1)
+		xml->writeTextElement("player_id", QString::number(playerId));
+	if (!zoneName.isEmpty())
+		xml->writeTextElement("zone_name", zoneName);
+	if (numberCards != -1)
+		xml->writeTextElement("number_cards", QString::number(numberCards));
+}
+void Command_DumpZone::readBinaryFields(QDataStream &in)
+{
+	playerId = readBinaryInt(in);
+	in >> zoneName;
+	numberCards = readBinaryInt(in);
+}
+void Command_DumpZone::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("player_id", _playerId));
-	insertItem(new SerializableItem_String("zone_name", _zoneName));
-	insertItem(new SerializableItem_Int("number_cards", _numberCards));
+	out << (qint32) playerId;
+	out << zoneName;
+	out << (qint32) numberCards;
 }
 Command_StopDumpZone::Command_StopDumpZone(int _gameId, int _playerId, const QString &_zoneName)
-	: GameCommand("stop_dump_zone", _gameId)
+	: GameCommand("stop_dump_zone", _gameId), playerId(_playerId), zoneName(_zoneName)
 {
-	insertItem(new SerializableItem_Int("player_id", _playerId));
-	insertItem(new SerializableItem_String("zone_name", _zoneName));
+}
+int Command_StopDumpZone::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("player_id"))
+			return 0;
+		if (fieldName == QLatin1String("zone_name"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Command_StopDumpZone::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: playerId = intFromText(fieldText); break;
+	case 1: zoneName.append(fieldText); break;
+	}
+}
+void Command_StopDumpZone::writeFields(QXmlStreamWriter *xml)
+{
+	if (playerId != -1)
+		xml->writeTextElement("player_id", QString::number(playerId));
+	if (!zoneName.isEmpty())
+		xml->writeTextElement("zone_name", zoneName);
+}
+void Command_StopDumpZone::readBinaryFields(QDataStream &in)
+{
+	playerId = readBinaryInt(in);
+	in >> zoneName;
+}
+void Command_StopDumpZone::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) playerId;
+	out << zoneName;
 }
 Command_RevealCards::Command_RevealCards(int _gameId, const QString &_zoneName, int _cardId, int _playerId)
-	: GameCommand("reveal_cards", _gameId)
+	: GameCommand("reveal_cards", _gameId), zoneName(_zoneName), cardId(_cardId), playerId(_playerId)
+{
+}
+int Command_RevealCards::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("zone_name"))
+			return 0;
+		if (fieldName == QLatin1String("player_id"))
+			return 2;
+		break;
+	}
+	return -1;
+}
+void Command_RevealCards::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zoneName.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: playerId = intFromText(fieldText); break;
+	}
+}
+void Command_RevealCards::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("zone_name", _zoneName));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Int("player_id", _playerId));
+	if (!zoneName.isEmpty())
+		xml->writeTextElement("zone_name", zoneName);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (playerId != -1)
+		xml->writeTextElement("player_id", QString::number(playerId));
+}
+void Command_RevealCards::readBinaryFields(QDataStream &in)
+{
+	in >> zoneName;
+	cardId = readBinaryInt(in);
+	playerId = readBinaryInt(in);
+}
+void Command_RevealCards::writeBinaryFields(QDataStream &out)
+{
+	out << zoneName;
+	out << (qint32) cardId;
+	out << (qint32) playerId;
 }
 Event_ConnectionStateChanged::Event_ConnectionStateChanged(int _playerId, bool _connected)
-	: GameEvent("connection_state_changed", _playerId)
+	: GameEvent("connection_state_changed", _playerId), connected(_connected)
+{
+}
+int Event_ConnectionStateChanged::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("connected"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_ConnectionStateChanged::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_Bool("connected", _connected));
+	switch (index) {
+	case 0: connected = boolFromText(fieldText); break;
+	}
+}
+void Event_ConnectionStateChanged::writeFields(QXmlStreamWriter *xml)
+{
+	if (connected)
+		xml->writeTextElement("connected", "1");
+}
+void Event_ConnectionStateChanged::readBinaryFields(QDataStream &in)
+{
+	connected = readBinaryBool(in);
+}
+void Event_ConnectionStateChanged::writeBinaryFields(QDataStream &out)
+{
+	out << (quint8) connected;
 }
 Event_Say::Event_Say(int _playerId, const QString &_message)
-	: GameEvent("say", _playerId)
+	: GameEvent("say", _playerId), message(_message)
+{
+}
+int Event_Say::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("message"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_Say::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: message.append(fieldText); break;
+	}
+}
+void Event_Say::writeFields(QXmlStreamWriter *xml)
+{
+	if (!message.isEmpty())
+		xml->writeTextElement("message", message);
+}
+void Event_Say::readBinaryFields(QDataStream &in)
+{
+	in >> message;
+}
+void Event_Say::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_String("message", _message));
+	out << message;
 }
 Event_Leave::Event_Leave(int _playerId)
 	: GameEvent("leave", _playerId)
@@ -292,172 +1658,1212 @@ Event_Shuffle::Event_Shuffle(int _playerId)
 {
 }
 Event_RollDie::Event_RollDie(int _playerId, int _sides, int _value)
-	: GameEvent("roll_die", _playerId)
+	: GameEvent("roll_die", _playerId), sides(_sides), value(_value)
+{
+}
+int Event_RollDie::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("sides"))
+			return 0;
+		if (fieldName == QLatin1String("value"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Event_RollDie::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: sides = intFromText(fieldText); break;
+	case 1: value = intFromText(fieldText); break;
+	}
+}
+void Event_RollDie::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_Int("sides", _sides));
-	insertItem(new SerializableItem_Int("value", _value));
+	if (sides != -1)
+		xml->writeTextElement("sides", QString::number(sides));
+	if (value != -1)
+		xml->writeTextElement("value", QString::number(value));
+}
+void Event_RollDie::readBinaryFields(QDataStream &in)
+{
+	sides = readBinaryInt(in);
+	value = readBinaryInt(in);
+}
+void Event_RollDie::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) sides;
+	out << (qint32) value;
 }
 Event_MoveCard::Event_MoveCard(int _playerId, int _cardId, const QString &_cardName, const QString &_startZone, int _position, int _targetPlayerId, const QString &_targetZone, int _x, int _y, int _newCardId, bool _faceDown)
-	: GameEvent("move_card", _playerId)
-{
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_String("card_name", _cardName));
-	insertItem(new SerializableItem_String("start_zone", _startZone));
-	insertItem(new SerializableItem_Int("position", _position));
-	insertItem(new SerializableItem_Int("target_player_id", _targetPlayerId));
-	insertItem(new SerializableItem_String("target_zone", _targetZone));
-	insertItem(new SerializableItem_Int("x", _x));
-	insertItem(new SerializableItem_Int("y", _y));
-	insertItem(new SerializableItem_Int("new_card_id", _newCardId));
-	insertItem(new SerializableItem_Bool("face_down", _faceDown));
+	: GameEvent("move_card", _playerId), cardId(_cardId), cardName(_cardName), startZone(_startZone), position(_position), targetPlayerId(_targetPlayerId), targetZone(_targetZone), x(_x), y(_y), newCardId(_newCardId), faceDown(_faceDown)
+{
+}
+int Event_MoveCard::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 1:
+		if (fieldName == QLatin1String("x"))
+			return 6;
+		if (fieldName == QLatin1String("y"))
+			return 7;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 0;
+		break;
+	case 8:
+		if (fieldName == QLatin1String("position"))
+			return 3;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("card_name"))
+			return 1;
+		if (fieldName == QLatin1String("face_down"))
+			return 9;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("start_zone"))
+			return 2;
+		break;
+	case 11:
+		if (fieldName == QLatin1String("target_zone"))
+			return 5;
+		if (fieldName == QLatin1String("new_card_id"))
+			return 8;
+		break;
+	case 16:
+		if (fieldName == QLatin1String("target_player_id"))
+			return 4;
+		break;
+	}
+	return -1;
+}
+void Event_MoveCard::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: cardId = intFromText(fieldText); break;
+	case 1: cardName.append(fieldText); break;
+	case 2: startZone.append(fieldText); break;
+	case 3: position = intFromText(fieldText); break;
+	case 4: targetPlayerId = intFromText(fieldText); break;
+	case 5: targetZone.append(fieldText); break;
+	case 6: x = intFromText(fieldText); break;
+	case 7: y = intFromText(fieldText); break;
+	case 8: newCardId = intFromText(fieldText); break;
+	case 9: faceDown = boolFromText(fieldText); break;
+	}
+}
+void Event_MoveCard::writeFields(QXmlStreamWriter *xml)
+{
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (!cardName.isEmpty())
+		xml->writeTextElement("card_name", cardName);
+	if (!startZone.isEmpty())
+		xml->writeTextElement("start_zone", startZone);
+	if (position != -1)
+		xml->writeTextElement("position", QString::number(position));
+	if (targetPlayerId != -1)
+		xml->writeTextElement("target_player_id", QString::number(targetPlayerId));
+	if (!targetZone.isEmpty())
+		xml->writeTextElement("target_zone", targetZone);
+	if (x != -1)
+		xml->writeTextElement("x", QString::number(x));
+	if (y != -1)
+		xml->writeTextElement("y", QString::number(y));
+	if (newCardId != -1)
+		xml->writeTextElement("new_card_id", QString::number(newCardId));
+	if (faceDown)
+		xml->writeTextElement("face_down", "1");
+}
+void Event_MoveCard::readBinaryFields(QDataStream &in)
+{
+	cardId = readBinaryInt(in);
+	in >> cardName;
+	in >> startZone;
+	position = readBinaryInt(in);
+	targetPlayerId = readBinaryInt(in);
+	in >> targetZone;
+	x = readBinaryInt(in);
+	y = readBinaryInt(in);
+	newCardId = readBinaryInt(in);
+	faceDown = readBinaryBool(in);
+}
+void Event_MoveCard::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) cardId;
+	out << cardName;
+	out << startZone;
+	out << (qint32) position;
+	out << (qint32) targetPlayerId;
+	out << targetZone;
+	out << (qint32) x;
+	out << (qint32) y;
+	out << (qint32) newCardId;
+	out << (quint8) faceDown;
 }
 Event_FlipCard::Event_FlipCard(int _playerId, const QString &_zone, int _cardId, const QString &_cardName, bool _faceDown)
-	: GameEvent("flip_card", _playerId)
-{
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_String("card_name", _cardName));
-	insertItem(new SerializableItem_Bool("face_down", _faceDown));
+	: GameEvent("flip_card", _playerId), zone(_zone), cardId(_cardId), cardName(_cardName), faceDown(_faceDown)
+{
+}
+int Event_FlipCard::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("card_name"))
+			return 2;
+		if (fieldName == QLatin1String("face_down"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Event_FlipCard::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: cardName.append(fieldText); break;
+	case 3: faceDown = boolFromText(fieldText); break;
+	}
+}
+void Event_FlipCard::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (!cardName.isEmpty())
+		xml->writeTextElement("card_name", cardName);
+	if (faceDown)
+		xml->writeTextElement("face_down", "1");
+}
+void Event_FlipCard::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	in >> cardName;
+	faceDown = readBinaryBool(in);
+}
+void Event_FlipCard::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << cardName;
+	out << (quint8) faceDown;
 }
 Event_DestroyCard::Event_DestroyCard(int _playerId, const QString &_zone, int _cardId)
-	: GameEvent("destroy_card", _playerId)
+	: GameEvent("destroy_card", _playerId), zone(_zone), cardId(_cardId)
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
 }
-Event_AttachCard::Event_AttachCard(int _playerId, const QString &_startZone, int _cardId, int _targetPlayerId, const QString &_targetZone, int _targetCardId)
-	: GameEvent("attach_card", _playerId)
+int Event_DestroyCard::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Event_DestroyCard::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("start_zone", _startZone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Int("target_player_id", _targetPlayerId));
-	insertItem(new SerializableItem_String("target_zone", _targetZone));
-	insertItem(new SerializableItem_Int("target_card_id", _targetCardId));
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	}
+}
+void Event_DestroyCard::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+}
+void Event_DestroyCard::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+}
+void Event_DestroyCard::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+}
+Event_AttachCard::Event_AttachCard(int _playerId, const QString &_startZone, int _cardId, int _targetPlayerId, const QString &_targetZone, int _targetCardId)
+	: GameEvent("attach_card", _playerId), startZone(_startZone), cardId(_cardId), targetPlayerId(_targetPlayerId), targetZone(_targetZone), targetCardId(_targetCardId)
+{
+}
+int Event_AttachCard::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("start_zone"))
+			return 0;
+		break;
+	case 11:
+		if (fieldName == QLatin1String("target_zone"))
+			return 3;
+		break;
+	case 14:
+		if (fieldName == QLatin1String("target_card_id"))
+			return 4;
+		break;
+	case 16:
+		if (fieldName == QLatin1String("target_player_id"))
+			return 2;
+		break;
+	}
+	return -1;
+}
+void Event_AttachCard::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: startZone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: targetPlayerId = intFromText(fieldText); break;
+	case 3: targetZone.append(fieldText); break;
+	case 4: targetCardId = intFromText(fieldText); break;
+	}
+}
+void Event_AttachCard::writeFields(QXmlStreamWriter *xml)
+{
+	if (!startZone.isEmpty())
+		xml->writeTextElement("start_zone", startZone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (targetPlayerId != -1)
+		xml->writeTextElement("target_player_id", QString::number(targetPlayerId));
+	if (!targetZone.isEmpty())
+		xml->writeTextElement("target_zone", targetZone);
+	if (targetCardId != -1)
+		xml->writeTextElement("target_card_id", QString::number(targetCardId));
+}
+void Event_AttachCard::readBinaryFields(QDataStream &in)
+{
+	in >> startZone;
+	cardId = readBinaryInt(in);
+	targetPlayerId = readBinaryInt(in);
+	in >> targetZone;
+	targetCardId = readBinaryInt(in);
+}
+void Event_AttachCard::writeBinaryFields(QDataStream &out)
+{
+	out << startZone;
+	out << (qint32) cardId;
+	out << (qint32) targetPlayerId;
+	out << targetZone;
+	out << (qint32) targetCardId;
 }
 Event_CreateToken::Event_CreateToken(int _playerId, const QString &_zone, int _cardId, const QString &_cardName, const QString &_color, const QString &_pt, const QString &_annotation, bool _destroyOnZoneChange, int _x, int _y)
-	: GameEvent("create_token", _playerId)
-{
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_String("card_name", _cardName));
-	insertItem(new SerializableItem_String("color", _color));
-	insertItem(new SerializableItem_String("pt", _pt));
-	insertItem(new SerializableItem_String("annotation", _annotation));
-	insertItem(new SerializableItem_Bool("destroy_on_zone_change", _destroyOnZoneChange));
-	insertItem(new SerializableItem_Int("x", _x));
-	insertItem(new SerializableItem_Int("y", _y));
+	: GameEvent("create_token", _playerId), zone(_zone), cardId(_cardId), cardName(_cardName), color(_color), pt(_pt), annotation(_annotation), destroyOnZoneChange(_destroyOnZoneChange), x(_x), y(_y)
+{
+}
+int Event_CreateToken::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 1:
+		if (fieldName == QLatin1String("x"))
+			return 7;
+		if (fieldName == QLatin1String("y"))
+			return 8;
+		break;
+	case 2:
+		if (fieldName == QLatin1String("pt"))
+			return 4;
+		break;
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 5:
+		if (fieldName == QLatin1String("color"))
+			return 3;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("card_name"))
+			return 2;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("annotation"))
+			return 5;
+		break;
+	case 22:
+		if (fieldName == QLatin1String("destroy_on_zone_change"))
+			return 6;
+		break;
+	}
+	return -1;
+}
+void Event_CreateToken::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: cardName.append(fieldText); break;
+	case 3: color.append(fieldText); break;
+	case 4: pt.append(fieldText); break;
+	case 5: annotation.append(fieldText); break;
+	case 6: destroyOnZoneChange = boolFromText(fieldText); break;
+	case 7: x = intFromText(fieldText); break;
+	case 8: y = intFromText(fieldText); break;
+	}
+}
+void Event_CreateToken::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (!cardName.isEmpty())
+		xml->writeTextElement("card_name", cardName);
+	if (!color.isEmpty())
+		xml->writeTextElement("color", color);
+	if (!pt.isEmpty())
+		xml->writeTextElement("pt", pt);
+	if (!annotation.isEmpty())
+		xml->writeTextElement("annotation", annotation);
+	if (destroyOnZoneChange)
+		xml->writeTextElement("destroy_on_zone_change", "1");
+	if (x != -1)
+		xml->writeTextElement("x", QString::number(x));
+	if (y != -1)
+		xml->writeTextElement("y", QString::number(y));
+}
+void Event_CreateToken::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	in >> cardName;
+	in >> color;
+	in >> pt;
+	in >> annotation;
+	destroyOnZoneChange = readBinaryBool(in);
+	x = readBinaryInt(in);
+	y = readBinaryInt(in);
+}
+void Event_CreateToken::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << cardName;
+	out << color;
+	out << pt;
+	out << annotation;
+	out << (quint8) destroyOnZoneChange;
+	out << (qint32) x;
+	out << (qint32) y;
 }
 Event_DeleteArrow::Event_DeleteArrow(int _playerId, int _arrowId)
-	: GameEvent("delete_arrow", _playerId)
+	: GameEvent("delete_arrow", _playerId), arrowId(_arrowId)
 {
-	insertItem(new SerializableItem_Int("arrow_id", _arrowId));
 }
-Event_SetCardAttr::Event_SetCardAttr(int _playerId, const QString &_zone, int _cardId, const QString &_attrName, const QString &_attrValue)
-	: GameEvent("set_card_attr", _playerId)
+int Event_DeleteArrow::getFieldIndex(const QStringRef &fieldName) const
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_String("attr_name", _attrName));
-	insertItem(new SerializableItem_String("attr_value", _attrValue));
+	switch (fieldName.size()) {
+	case 8:
+		if (fieldName == QLatin1String("arrow_id"))
+			return 0;
+		break;
+	}
+	return -1;
 }
-Event_SetCardCounter::Event_SetCardCounter(int _playerId, const QString &_zone, int _cardId, int _counterId, int _counterValue)
-	: GameEvent("set_card_counter", _playerId)
+void Event_DeleteArrow::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: arrowId = intFromText(fieldText); break;
+	}
+}
+void Event_DeleteArrow::writeFields(QXmlStreamWriter *xml)
+{
+	if (arrowId != -1)
+		xml->writeTextElement("arrow_id", QString::number(arrowId));
+}
+void Event_DeleteArrow::readBinaryFields(QDataStream &in)
+{
+	arrowId = readBinaryInt(in);
+}
+void Event_DeleteArrow::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("card_id", _cardId));
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
-	insertItem(new SerializableItem_Int("counter_value", _counterValue));
+	out << (qint32) arrowId;
+}
+Event_SetCardAttr::Event_SetCardAttr(int _playerId, const QString &_zone, int _cardId, const QString &_attrName, const QString &_attrValue)
+	: GameEvent("set_card_attr", _playerId), zone(_zone), cardId(_cardId), attrName(_attrName), attrValue(_attrValue)
+{
+}
+int Event_SetCardAttr::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("attr_name"))
+			return 2;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("attr_value"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Event_SetCardAttr::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: attrName.append(fieldText); break;
+	case 3: attrValue.append(fieldText); break;
+	}
+}
+void Event_SetCardAttr::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (!attrName.isEmpty())
+		xml->writeTextElement("attr_name", attrName);
+	if (!attrValue.isEmpty())
+		xml->writeTextElement("attr_value", attrValue);
+}
+void Event_SetCardAttr::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	in >> attrName;
+	in >> attrValue;
+}
+void Event_SetCardAttr::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << attrName;
+	out << attrValue;
+}
+Event_SetCardCounter::Event_SetCardCounter(int _playerId, const QString &_zone, int _cardId, int _counterId, int _counterValue)
+	: GameEvent("set_card_counter", _playerId), zone(_zone), cardId(_cardId), counterId(_counterId), counterValue(_counterValue)
+{
+}
+int Event_SetCardCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("card_id"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 2;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("counter_value"))
+			return 3;
+		break;
+	}
+	return -1;
+}
+void Event_SetCardCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zone.append(fieldText); break;
+	case 1: cardId = intFromText(fieldText); break;
+	case 2: counterId = intFromText(fieldText); break;
+	case 3: counterValue = intFromText(fieldText); break;
+	}
+}
+void Event_SetCardCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (cardId != -1)
+		xml->writeTextElement("card_id", QString::number(cardId));
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+	if (counterValue != -1)
+		xml->writeTextElement("counter_value", QString::number(counterValue));
+}
+void Event_SetCardCounter::readBinaryFields(QDataStream &in)
+{
+	in >> zone;
+	cardId = readBinaryInt(in);
+	counterId = readBinaryInt(in);
+	counterValue = readBinaryInt(in);
+}
+void Event_SetCardCounter::writeBinaryFields(QDataStream &out)
+{
+	out << zone;
+	out << (qint32) cardId;
+	out << (qint32) counterId;
+	out << (qint32) counterValue;
 }
 Event_SetCounter::Event_SetCounter(int _playerId, int _counterId, int _value)
-	: GameEvent("set_counter", _playerId)
+	: GameEvent("set_counter", _playerId), counterId(_counterId), value(_value)
+{
+}
+int Event_SetCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("value"))
+			return 1;
+		break;
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_SetCounter::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
-	insertItem(new SerializableItem_Int("value", _value));
+	switch (index) {
+	case 0: counterId = intFromText(fieldText); break;
+	case 1: value = intFromText(fieldText); break;
+	}
+}
+void Event_SetCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+	if (value != -1)
+		xml->writeTextElement("value", QString::number(value));
+}
+void Event_SetCounter::readBinaryFields(QDataStream &in)
+{
+	counterId = readBinaryInt(in);
+	value = readBinaryInt(in);
+}
+void Event_SetCounter::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) counterId;
+	out << (qint32) value;
 }
 Event_DelCounter::Event_DelCounter(int _playerId, int _counterId)
-	: GameEvent("del_counter", _playerId)
+	: GameEvent("del_counter", _playerId), counterId(_counterId)
+{
+}
+int Event_DelCounter::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 10:
+		if (fieldName == QLatin1String("counter_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_DelCounter::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: counterId = intFromText(fieldText); break;
+	}
+}
+void Event_DelCounter::writeFields(QXmlStreamWriter *xml)
+{
+	if (counterId != -1)
+		xml->writeTextElement("counter_id", QString::number(counterId));
+}
+void Event_DelCounter::readBinaryFields(QDataStream &in)
+{
+	counterId = readBinaryInt(in);
+}
+void Event_DelCounter::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("counter_id", _counterId));
+	out << (qint32) counterId;
 }
 Event_SetActivePlayer::Event_SetActivePlayer(int _playerId, int _activePlayerId)
-	: GameEvent("set_active_player", _playerId)
+	: GameEvent("set_active_player", _playerId), activePlayerId(_activePlayerId)
+{
+}
+int Event_SetActivePlayer::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 16:
+		if (fieldName == QLatin1String("active_player_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_SetActivePlayer::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: activePlayerId = intFromText(fieldText); break;
+	}
+}
+void Event_SetActivePlayer::writeFields(QXmlStreamWriter *xml)
+{
+	if (activePlayerId != -1)
+		xml->writeTextElement("active_player_id", QString::number(activePlayerId));
+}
+void Event_SetActivePlayer::readBinaryFields(QDataStream &in)
+{
+	activePlayerId = readBinaryInt(in);
+}
+void Event_SetActivePlayer::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("active_player_id", _activePlayerId));
+	out << (qint32) activePlayerId;
 }
 Event_SetActivePhase::Event_SetActivePhase(int _playerId, int _phase)
-	: GameEvent("set_active_phase", _playerId)
+	: GameEvent("set_active_phase", _playerId), phase(_phase)
+{
+}
+int Event_SetActivePhase::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 5:
+		if (fieldName == QLatin1String("phase"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_SetActivePhase::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_Int("phase", _phase));
+	switch (index) {
+	case 0: phase = intFromText(fieldText); break;
+	}
+}
+void Event_SetActivePhase::writeFields(QXmlStreamWriter *xml)
+{
+	if (phase != -1)
+		xml->writeTextElement("phase", QString::number(phase));
+}
+void Event_SetActivePhase::readBinaryFields(QDataStream &in)
+{
+	phase = readBinaryInt(in);
+}
+void Event_SetActivePhase::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) phase;
 }
 Event_DumpZone::Event_DumpZone(int _playerId, int _zoneOwnerId, const QString &_zone, int _numberCards)
-	: GameEvent("dump_zone", _playerId)
+	: GameEvent("dump_zone", _playerId), zoneOwnerId(_zoneOwnerId), zone(_zone), numberCards(_numberCards)
+{
+}
+int Event_DumpZone::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 1;
+		break;
+	case 12:
+		if (fieldName == QLatin1String("number_cards"))
+			return 2;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("zone_owner_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_DumpZone::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zoneOwnerId = intFromText(fieldText); break;
+	case 1: zone.append(fieldText); break;
+	case 2: numberCards = intFromText(fieldText); break;
+	}
+}
+void Event_DumpZone::writeFields(QXmlStreamWriter *xml)
+{
+	if (zoneOwnerId != -1)
+		xml->writeTextElement("zone_owner_id", QString::number(zoneOwnerId));
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+	if (numberCards != -1)
+		xml->writeTextElement("number_cards", QString::number(numberCards));
+}
+void Event_DumpZone::readBinaryFields(QDataStream &in)
+{
+	zoneOwnerId = readBinaryInt(in);
+	in >> zone;
+	numberCards = readBinaryInt(in);
+}
+void Event_DumpZone::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_Int("zone_owner_id", _zoneOwnerId));
-	insertItem(new SerializableItem_String("zone", _zone));
-	insertItem(new SerializableItem_Int("number_cards", _numberCards));
+	out << (qint32) zoneOwnerId;
+	out << zone;
+	out << (qint32) numberCards;
 }
 Event_StopDumpZone::Event_StopDumpZone(int _playerId, int _zoneOwnerId, const QString &_zone)
-	: GameEvent("stop_dump_zone", _playerId)
+	: GameEvent("stop_dump_zone", _playerId), zoneOwnerId(_zoneOwnerId), zone(_zone)
 {
-	insertItem(new SerializableItem_Int("zone_owner_id", _zoneOwnerId));
-	insertItem(new SerializableItem_String("zone", _zone));
+}
+int Event_StopDumpZone::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("zone"))
+			return 1;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("zone_owner_id"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_StopDumpZone::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: zoneOwnerId = intFromText(fieldText); break;
+	case 1: zone.append(fieldText); break;
+	}
+}
+void Event_StopDumpZone::writeFields(QXmlStreamWriter *xml)
+{
+	if (zoneOwnerId != -1)
+		xml->writeTextElement("zone_owner_id", QString::number(zoneOwnerId));
+	if (!zone.isEmpty())
+		xml->writeTextElement("zone", zone);
+}
+void Event_StopDumpZone::readBinaryFields(QDataStream &in)
+{
+	zoneOwnerId = readBinaryInt(in);
+	in >> zone;
+}
+void Event_StopDumpZone::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) zoneOwnerId;
+	out << zone;
 }
 Event_RemoveFromList::Event_RemoveFromList(const QString &_list, const QString &_userName)
-	: GenericEvent("remove_from_list")
+	: GenericEvent("remove_from_list"), list(_list), userName(_userName)
+{
+}
+int Event_RemoveFromList::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("list"))
+			return 0;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Event_RemoveFromList::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: list.append(fieldText); break;
+	case 1: userName.append(fieldText); break;
+	}
+}
+void Event_RemoveFromList::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("list", _list));
-	insertItem(new SerializableItem_String("user_name", _userName));
+	if (!list.isEmpty())
+		xml->writeTextElement("list", list);
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+}
+void Event_RemoveFromList::readBinaryFields(QDataStream &in)
+{
+	in >> list;
+	in >> userName;
+}
+void Event_RemoveFromList::writeBinaryFields(QDataStream &out)
+{
+	out << list;
+	out << userName;
 }
 Event_ServerMessage::Event_ServerMessage(const QString &_message)
-	: GenericEvent("server_message")
+	: GenericEvent("server_message"), message(_message)
+{
+}
+int Event_ServerMessage::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("message"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_ServerMessage::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("message", _message));
+	switch (index) {
+	case 0: message.append(fieldText); break;
+	}
+}
+void Event_ServerMessage::writeFields(QXmlStreamWriter *xml)
+{
+	if (!message.isEmpty())
+		xml->writeTextElement("message", message);
+}
+void Event_ServerMessage::readBinaryFields(QDataStream &in)
+{
+	in >> message;
+}
+void Event_ServerMessage::writeBinaryFields(QDataStream &out)
+{
+	out << message;
 }
 Event_ServerShutdown::Event_ServerShutdown(const QString &_reason, int _minutes)
-	: GenericEvent("server_shutdown")
+	: GenericEvent("server_shutdown"), reason(_reason), minutes(_minutes)
+{
+}
+int Event_ServerShutdown::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 6:
+		if (fieldName == QLatin1String("reason"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("minutes"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Event_ServerShutdown::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: reason.append(fieldText); break;
+	case 1: minutes = intFromText(fieldText); break;
+	}
+}
+void Event_ServerShutdown::writeFields(QXmlStreamWriter *xml)
+{
+	if (!reason.isEmpty())
+		xml->writeTextElement("reason", reason);
+	if (minutes != -1)
+		xml->writeTextElement("minutes", QString::number(minutes));
+}
+void Event_ServerShutdown::readBinaryFields(QDataStream &in)
+{
+	in >> reason;
+	minutes = readBinaryInt(in);
+}
+void Event_ServerShutdown::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_String("reason", _reason));
-	insertItem(new SerializableItem_Int("minutes", _minutes));
+	out << reason;
+	out << (qint32) minutes;
 }
 Event_ConnectionClosed::Event_ConnectionClosed(const QString &_reason)
-	: GenericEvent("connection_closed")
+	: GenericEvent("connection_closed"), reason(_reason)
+{
+}
+int Event_ConnectionClosed::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 6:
+		if (fieldName == QLatin1String("reason"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_ConnectionClosed::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: reason.append(fieldText); break;
+	}
+}
+void Event_ConnectionClosed::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("reason", _reason));
+	if (!reason.isEmpty())
+		xml->writeTextElement("reason", reason);
+}
+void Event_ConnectionClosed::readBinaryFields(QDataStream &in)
+{
+	in >> reason;
+}
+void Event_ConnectionClosed::writeBinaryFields(QDataStream &out)
+{
+	out << reason;
 }
 Event_Message::Event_Message(const QString &_senderName, const QString &_receiverName, const QString &_text)
-	: GenericEvent("message")
+	: GenericEvent("message"), senderName(_senderName), receiverName(_receiverName), text(_text)
 {
-	insertItem(new SerializableItem_String("sender_name", _senderName));
-	insertItem(new SerializableItem_String("receiver_name", _receiverName));
-	insertItem(new SerializableItem_String("text", _text));
 }
-Event_GameJoined::Event_GameJoined(int _gameId, const QString &_gameDescription, int _hostId, int _playerId, bool _spectator, bool _spectatorsCanTalk, bool _spectatorsSeeEverything, bool _resuming)
-	: GenericEvent("game_joined")
+int Event_Message::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 4:
+		if (fieldName == QLatin1String("text"))
+			return 2;
+		break;
+	case 11:
+		if (fieldName == QLatin1String("sender_name"))
+			return 0;
+		break;
+	case 13:
+		if (fieldName == QLatin1String("receiver_name"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Event_Message::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: senderName.append(fieldText); break;
+	case 1: receiverName.append(fieldText); break;
+	case 2: text.append(fieldText); break;
+	}
+}
+void Event_Message::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_Int("game_id", _gameId));
-	insertItem(new SerializableItem_String("game_description", _gameDescription));
-	insertItem(new SerializableItem_Int("host_id", _hostId));
-	insertItem(new SerializableItem_Int("player_id", _playerId));
-	insertItem(new SerializableItem_Bool("spectator", _spectator));
-	insertItem(new SerializableItem_Bool("spectators_can_talk", _spectatorsCanTalk));
-	insertItem(new SerializableItem_Bool("spectators_see_everything", _spectatorsSeeEverything));
-	insertItem(new SerializableItem_Bool("resuming", _resuming));
+	if (!senderName.isEmpty())
+		xml->writeTextElement("sender_name", senderName);
+	if (!receiverName.isEmpty())
+		xml->writeTextElement("receiver_name", receiverName);
+	if (!text.isEmpty())
+		xml->writeTextElement("text", text);
+}
+void Event_Message::readBinaryFields(QDataStream &in)
+{
+	in >> senderName;
+	in >> receiverName;
+	in >> text;
+}
+void Event_Message::writeBinaryFields(QDataStream &out)
+{
+	out << senderName;
+	out << receiverName;
+	out << text;
+}
+Event_GameJoined::Event_GameJoined(int _gameId, const QString &_gameDescription, int _hostId, int _playerId, bool _spectator, bool _spectatorsCanTalk, bool _spectatorsSeeEverything, bool _resuming)
+	: GenericEvent("game_joined"), gameId(_gameId), gameDescription(_gameDescription), hostId(_hostId), playerId(_playerId), spectator(_spectator), spectatorsCanTalk(_spectatorsCanTalk), spectatorsSeeEverything(_spectatorsSeeEverything), resuming(_resuming)
+{
+}
+int Event_GameJoined::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("game_id"))
+			return 0;
+		if (fieldName == QLatin1String("host_id"))
+			return 2;
+		break;
+	case 8:
+		if (fieldName == QLatin1String("resuming"))
+			return 7;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("player_id"))
+			return 3;
+		if (fieldName == QLatin1String("spectator"))
+			return 4;
+		break;
+	case 16:
+		if (fieldName == QLatin1String("game_description"))
+			return 1;
+		break;
+	case 19:
+		if (fieldName == QLatin1String("spectators_can_talk"))
+			return 5;
+		break;
+	case 25:
+		if (fieldName == QLatin1String("spectators_see_everything"))
+			return 6;
+		break;
+	}
+	return -1;
+}
+void Event_GameJoined::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: gameId = intFromText(fieldText); break;
+	case 1: gameDescription.append(fieldText); break;
+	case 2: hostId = intFromText(fieldText); break;
+	case 3: playerId = intFromText(fieldText); break;
+	case 4: spectator = boolFromText(fieldText); break;
+	case 5: spectatorsCanTalk = boolFromText(fieldText); break;
+	case 6: spectatorsSeeEverything = boolFromText(fieldText); break;
+	case 7: resuming = boolFromText(fieldText); break;
+	}
+}
+void Event_GameJoined::writeFields(QXmlStreamWriter *xml)
+{
+	if (gameId != -1)
+		xml->writeTextElement("game_id", QString::number(gameId));
+	if (!gameDescription.isEmpty())
+		xml->writeTextElement("game_description", gameDescription);
+	if (hostId != -1)
+		xml->writeTextElement("host_id", QString::number(hostId));
+	if (playerId != -1)
+		xml->writeTextElement("player_id", QString::number(playerId));
+	if (spectator)
+		xml->writeTextElement("spectator", "1");
+	if (spectatorsCanTalk)
+		xml->writeTextElement("spectators_can_talk", "1");
+	if (spectatorsSeeEverything)
+		xml->writeTextElement("spectators_see_everything", "1");
+	if (resuming)
+		xml->writeTextElement("resuming", "1");
+}
+void Event_GameJoined::readBinaryFields(QDataStream &in)
+{
+	gameId = readBinaryInt(in);
+	in >> gameDescription;
+	hostId = readBinaryInt(in);
+	playerId = readBinaryInt(in);
+	spectator = readBinaryBool(in);
+	spectatorsCanTalk = readBinaryBool(in);
+	spectatorsSeeEverything = readBinaryBool(in);
+	resuming = readBinaryBool(in);
+}
+void Event_GameJoined::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) gameId;
+	out << gameDescription;
+	out << (qint32) hostId;
+	out << (qint32) playerId;
+	out << (quint8) spectator;
+	out << (quint8) spectatorsCanTalk;
+	out << (quint8) spectatorsSeeEverything;
+	out << (quint8) resuming;
 }
 Event_UserLeft::Event_UserLeft(const QString &_userName)
-	: GenericEvent("user_left")
+	: GenericEvent("user_left"), userName(_userName)
+{
+}
+int Event_UserLeft::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_UserLeft::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: userName.append(fieldText); break;
+	}
+}
+void Event_UserLeft::writeFields(QXmlStreamWriter *xml)
+{
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+}
+void Event_UserLeft::readBinaryFields(QDataStream &in)
+{
+	in >> userName;
+}
+void Event_UserLeft::writeBinaryFields(QDataStream &out)
 {
-	insertItem(new SerializableItem_String("user_name", _userName));
+	out << userName;
 }
 Event_LeaveRoom::Event_LeaveRoom(int _roomId, const QString &_playerName)
-	: RoomEvent("leave_room", _roomId)
+	: RoomEvent("leave_room", _roomId), playerName(_playerName)
+{
+}
+int Event_LeaveRoom::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 11:
+		if (fieldName == QLatin1String("player_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_LeaveRoom::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: playerName.append(fieldText); break;
+	}
+}
+void Event_LeaveRoom::writeFields(QXmlStreamWriter *xml)
 {
-	insertItem(new SerializableItem_String("player_name", _playerName));
+	if (!playerName.isEmpty())
+		xml->writeTextElement("player_name", playerName);
+}
+void Event_LeaveRoom::readBinaryFields(QDataStream &in)
+{
+	in >> playerName;
+}
+void Event_LeaveRoom::writeBinaryFields(QDataStream &out)
+{
+	out << playerName;
 }
 Event_RoomSay::Event_RoomSay(int _roomId, const QString &_playerName, const QString &_message)
-	: RoomEvent("room_say", _roomId)
+	: RoomEvent("room_say", _roomId), playerName(_playerName), message(_message)
+{
+}
+int Event_RoomSay::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 7:
+		if (fieldName == QLatin1String("message"))
+			return 1;
+		break;
+	case 11:
+		if (fieldName == QLatin1String("player_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Event_RoomSay::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("player_name", _playerName));
-	insertItem(new SerializableItem_String("message", _message));
+	switch (index) {
+	case 0: playerName.append(fieldText); break;
+	case 1: message.append(fieldText); break;
+	}
+}
+void Event_RoomSay::writeFields(QXmlStreamWriter *xml)
+{
+	if (!playerName.isEmpty())
+		xml->writeTextElement("player_name", playerName);
+	if (!message.isEmpty())
+		xml->writeTextElement("message", message);
+}
+void Event_RoomSay::readBinaryFields(QDataStream &in)
+{
+	in >> playerName;
+	in >> message;
+}
+void Event_RoomSay::writeBinaryFields(QDataStream &out)
+{
+	out << playerName;
+	out << message;
 }
 Context_ReadyStart::Context_ReadyStart()
 	: GameEventContext("ready_start")
@@ -468,9 +2874,37 @@ Context_Concede::Context_Concede()
 {
 }
 Context_DeckSelect::Context_DeckSelect(const QString &_deckHash)
-	: GameEventContext("deck_select")
+	: GameEventContext("deck_select"), deckHash(_deckHash)
+{
+}
+int Context_DeckSelect::getFieldIndex(const QStringRef &fieldName) const
 {
-	insertItem(new SerializableItem_String("deck_hash", _deckHash));
+	switch (fieldName.size()) {
+	case 9:
+		if (fieldName == QLatin1String("deck_hash"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Context_DeckSelect::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: deckHash.append(fieldText); break;
+	}
+}
+void Context_DeckSelect::writeFields(QXmlStreamWriter *xml)
+{
+	if (!deckHash.isEmpty())
+		xml->writeTextElement("deck_hash", deckHash);
+}
+void Context_DeckSelect::readBinaryFields(QDataStream &in)
+{
+	in >> deckHash;
+}
+void Context_DeckSelect::writeBinaryFields(QDataStream &out)
+{
+	out << deckHash;
 }
 Context_UndoDraw::Context_UndoDraw()
 	: GameEventContext("undo_draw")
@@ -481,113 +2915,232 @@ Context_MoveCard::Context_MoveCard()
 {
 }
 Context_Mulligan::Context_Mulligan(int _number)
-	: GameEventContext("mulligan")
+	: GameEventContext("mulligan"), number(_number)
+{
+}
+int Context_Mulligan::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 6:
+		if (fieldName == QLatin1String("number"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Context_Mulligan::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: number = intFromText(fieldText); break;
+	}
+}
+void Context_Mulligan::writeFields(QXmlStreamWriter *xml)
+{
+	if (number != -1)
+		xml->writeTextElement("number", QString::number(number));
+}
+void Context_Mulligan::readBinaryFields(QDataStream &in)
+{
+	number = readBinaryInt(in);
+}
+void Context_Mulligan::writeBinaryFields(QDataStream &out)
+{
+	out << (qint32) number;
+}
+Context_StateReplay::Context_StateReplay()
+	: GameEventContext("state_replay")
 {
-	insertItem(new SerializableItem_Int("number", _number));
 }
 Command_UpdateServerMessage::Command_UpdateServerMessage()
 	: AdminCommand("update_server_message")
 {
 }
 Command_ShutdownServer::Command_ShutdownServer(const QString &_reason, int _minutes)
-	: AdminCommand("shutdown_server")
+	: AdminCommand("shutdown_server"), reason(_reason), minutes(_minutes)
 {
-	insertItem(new SerializableItem_String("reason", _reason));
-	insertItem(new SerializableItem_Int("minutes", _minutes));
 }
-Command_BanFromServer::Command_BanFromServer(const QString &_userName, const QString &_address, int _minutes, const QString &_reason)
-	: ModeratorCommand("ban_from_server")
+int Command_ShutdownServer::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 6:
+		if (fieldName == QLatin1String("reason"))
+			return 0;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("minutes"))
+			return 1;
+		break;
+	}
+	return -1;
+}
+void Command_ShutdownServer::readField(int index, const QStringRef &fieldText)
 {
-	insertItem(new SerializableItem_String("user_name", _userName));
-	insertItem(new SerializableItem_String("address", _address));
-	insertItem(new SerializableItem_Int("minutes", _minutes));
-	insertItem(new SerializableItem_String("reason", _reason));
+	switch (index) {
+	case 0: reason.append(fieldText); break;
+	case 1: minutes = intFromText(fieldText); break;
+	}
+}
+void Command_ShutdownServer::writeFields(QXmlStreamWriter *xml)
+{
+	if (!reason.isEmpty())
+		xml->writeTextElement("reason", reason);
+	if (minutes != -1)
+		xml->writeTextElement("minutes", QString::number(minutes));
+}
+void Command_ShutdownServer::readBinaryFields(QDataStream &in)
+{
+	in >> reason;
+	minutes = readBinaryInt(in);
+}
+void Command_ShutdownServer::writeBinaryFields(QDataStream &out)
+{
+	out << reason;
+	out << (qint32) minutes;
+}
+Command_BanFromServer::Command_BanFromServer(const QString &_userName, const QString &_address, int _minutes, const QString &_reason)
+	: ModeratorCommand("ban_from_server"), userName(_userName), address(_address), minutes(_minutes), reason(_reason)
+{
+}
+int Command_BanFromServer::getFieldIndex(const QStringRef &fieldName) const
+{
+	switch (fieldName.size()) {
+	case 6:
+		if (fieldName == QLatin1String("reason"))
+			return 3;
+		break;
+	case 7:
+		if (fieldName == QLatin1String("address"))
+			return 1;
+		if (fieldName == QLatin1String("minutes"))
+			return 2;
+		break;
+	case 9:
+		if (fieldName == QLatin1String("user_name"))
+			return 0;
+		break;
+	}
+	return -1;
+}
+void Command_BanFromServer::readField(int index, const QStringRef &fieldText)
+{
+	switch (index) {
+	case 0: userName.append(fieldText); break;
+	case 1: address.append(fieldText); break;
+	case 2: minutes = intFromText(fieldText); break;
+	case 3: reason.append(fieldText); break;
+	}
+}
+void Command_BanFromServer::writeFields(QXmlStreamWriter *xml)
+{
+	if (!userName.isEmpty())
+		xml->writeTextElement("user_name", userName);
+	if (!address.isEmpty())
+		xml->writeTextElement("address", address);
+	if (minutes != -1)
+		xml->writeTextElement("minutes", QString::number(minutes));
+	if (!reason.isEmpty())
+		xml->writeTextElement("reason", reason);
+}
+void Command_BanFromServer::readBinaryFields(QDataStream &in)
+{
+	in >> userName;
+	in >> address;
+	minutes = readBinaryInt(in);
+	in >> reason;
+}
+void Command_BanFromServer::writeBinaryFields(QDataStream &out)
+{
+	out << userName;
+	out << address;
+	out << (qint32) minutes;
+	out << reason;
 }
 void ProtocolItem::initializeHashAuto()
 {
-	itemNameHash.insert("cmdping", Command_Ping::newItem);
-	itemNameHash.insert("cmdlogin", Command_Login::newItem);
-	itemNameHash.insert("cmdmessage", Command_Message::newItem);
-	itemNameHash.insert("cmdlist_users", Command_ListUsers::newItem);
-	itemNameHash.insert("cmdget_games_of_user", Command_GetGamesOfUser::newItem);
-	itemNameHash.insert("cmdget_user_info", Command_GetUserInfo::newItem);
-	itemNameHash.insert("cmdadd_to_list", Command_AddToList::newItem);
-	itemNameHash.insert("cmdremove_from_list", Command_RemoveFromList::newItem);
-	itemNameHash.insert("cmddeck_list", Command_DeckList::newItem);
-	itemNameHash.insert("cmddeck_new_dir", Command_DeckNewDir::newItem);
-	itemNameHash.insert("cmddeck_del_dir", Command_DeckDelDir::newItem);
-	itemNameHash.insert("cmddeck_del", Command_DeckDel::newItem);
-	itemNameHash.insert("cmddeck_download", Command_DeckDownload::newItem);
-	itemNameHash.insert("cmdlist_rooms", Command_ListRooms::newItem);
-	itemNameHash.insert("cmdjoin_room", Command_JoinRoom::newItem);
-	itemNameHash.insert("cmdleave_room", Command_LeaveRoom::newItem);
-	itemNameHash.insert("cmdroom_say", Command_RoomSay::newItem);
-	itemNameHash.insert("cmdjoin_game", Command_JoinGame::newItem);
-	itemNameHash.insert("cmdkick_from_game", Command_KickFromGame::newItem);
-	itemNameHash.insert("cmdleave_game", Command_LeaveGame::newItem);
-	itemNameHash.insert("cmdsay", Command_Say::newItem);
-	itemNameHash.insert("cmdshuffle", Command_Shuffle::newItem);
-	itemNameHash.insert("cmdmulligan", Command_Mulligan::newItem);
-	itemNameHash.insert("cmdroll_die", Command_RollDie::newItem);
-	itemNameHash.insert("cmddraw_cards", Command_DrawCards::newItem);
-	itemNameHash.insert("cmdundo_draw", Command_UndoDraw::newItem);
-	itemNameHash.insert("cmdflip_card", Command_FlipCard::newItem);
-	itemNameHash.insert("cmdattach_card", Command_AttachCard::newItem);
-	itemNameHash.insert("cmdcreate_token", Command_CreateToken::newItem);
-	itemNameHash.insert("cmdcreate_arrow", Command_CreateArrow::newItem);
-	itemNameHash.insert("cmddelete_arrow", Command_DeleteArrow::newItem);
-	itemNameHash.insert("cmdset_card_attr", Command_SetCardAttr::newItem);
-	itemNameHash.insert("cmdset_card_counter", Command_SetCardCounter::newItem);
-	itemNameHash.insert("cmdinc_card_counter", Command_IncCardCounter::newItem);
-	itemNameHash.insert("cmdready_start", Command_ReadyStart::newItem);
-	itemNameHash.insert("cmdconcede", Command_Concede::newItem);
-	itemNameHash.insert("cmdinc_counter", Command_IncCounter::newItem);
-	itemNameHash.insert("cmdcreate_counter", Command_CreateCounter::newItem);
-	itemNameHash.insert("cmdset_counter", Command_SetCounter::newItem);
-	itemNameHash.insert("cmddel_counter", Command_DelCounter::newItem);
-	itemNameHash.insert("cmdnext_turn", Command_NextTurn::newItem);
-	itemNameHash.insert("cmdset_active_phase", Command_SetActivePhase::newItem);
-	itemNameHash.insert("cmddump_zone", Command_DumpZone::newItem);
-	itemNameHash.insert("cmdstop_dump_zone", Command_StopDumpZone::newItem);
-	itemNameHash.insert("cmdreveal_cards", Command_RevealCards::newItem);
-	itemNameHash.insert("game_eventconnection_state_changed", Event_ConnectionStateChanged::newItem);
-	itemNameHash.insert("game_eventsay", Event_Say::newItem);
-	itemNameHash.insert("game_eventleave", Event_Leave::newItem);
-	itemNameHash.insert("game_eventgame_closed", Event_GameClosed::newItem);
-	itemNameHash.insert("game_eventgame_host_changed", Event_GameHostChanged::newItem);
-	itemNameHash.insert("game_eventkicked", Event_Kicked::newItem);
-	itemNameHash.insert("game_eventshuffle", Event_Shuffle::newItem);
-	itemNameHash.insert("game_eventroll_die", Event_RollDie::newItem);
-	itemNameHash.insert("game_eventmove_card", Event_MoveCard::newItem);
-	itemNameHash.insert("game_eventflip_card", Event_FlipCard::newItem);
-	itemNameHash.insert("game_eventdestroy_card", Event_DestroyCard::newItem);
-	itemNameHash.insert("game_eventattach_card", Event_AttachCard::newItem);
-	itemNameHash.insert("game_eventcreate_token", Event_CreateToken::newItem);
-	itemNameHash.insert("game_eventdelete_arrow", Event_DeleteArrow::newItem);
-	itemNameHash.insert("game_eventset_card_attr", Event_SetCardAttr::newItem);
-	itemNameHash.insert("game_eventset_card_counter", Event_SetCardCounter::newItem);
-	itemNameHash.insert("game_eventset_counter", Event_SetCounter::newItem);
-	itemNameHash.insert("game_eventdel_counter", Event_DelCounter::newItem);
-	itemNameHash.insert("game_eventset_active_player", Event_SetActivePlayer::newItem);
-	itemNameHash.insert("game_eventset_active_phase", Event_SetActivePhase::newItem);
-	itemNameHash.insert("game_eventdump_zone", Event_DumpZone::newItem);
-	itemNameHash.insert("game_eventstop_dump_zone", Event_StopDumpZone::newItem);
-	itemNameHash.insert("generic_eventremove_from_list", Event_RemoveFromList::newItem);
-	itemNameHash.insert("generic_eventserver_message", Event_ServerMessage::newItem);
-	itemNameHash.insert("generic_eventserver_shutdown", Event_ServerShutdown::newItem);
-	itemNameHash.insert("generic_eventconnection_closed", Event_ConnectionClosed::newItem);
-	itemNameHash.insert("generic_eventmessage", Event_Message::newItem);
-	itemNameHash.insert("generic_eventgame_joined", Event_GameJoined::newItem);
-	itemNameHash.insert("generic_eventuser_left", Event_UserLeft::newItem);
-	itemNameHash.insert("room_eventleave_room", Event_LeaveRoom::newItem);
-	itemNameHash.insert("room_eventroom_say", Event_RoomSay::newItem);
-	itemNameHash.insert("game_event_contextready_start", Context_ReadyStart::newItem);
-	itemNameHash.insert("game_event_contextconcede", Context_Concede::newItem);
-	itemNameHash.insert("game_event_contextdeck_select", Context_DeckSelect::newItem);
-	itemNameHash.insert("game_event_contextundo_draw", Context_UndoDraw::newItem);
-	itemNameHash.insert("game_event_contextmove_card", Context_MoveCard::newItem);
-	itemNameHash.insert("game_event_contextmulligan", Context_Mulligan::newItem);
-	itemNameHash.insert("cmdupdate_server_message", Command_UpdateServerMessage::newItem);
-	itemNameHash.insert("cmdshutdown_server", Command_ShutdownServer::newItem);
-	itemNameHash.insert("cmdban_from_server", Command_BanFromServer::newItem);
+	registerSerializableItem("cmdping", Command_Ping::newItem);
+	registerSerializableItem("cmdlogin", Command_Login::newItem);
+	registerSerializableItem("cmdmessage", Command_Message::newItem);
+	registerSerializableItem("cmdlist_users", Command_ListUsers::newItem);
+	registerSerializableItem("cmdget_games_of_user", Command_GetGamesOfUser::newItem);
+	registerSerializableItem("cmdget_user_info", Command_GetUserInfo::newItem);
+	registerSerializableItem("cmdadd_to_list", Command_AddToList::newItem);
+	registerSerializableItem("cmdremove_from_list", Command_RemoveFromList::newItem);
+	registerSerializableItem("cmddeck_list", Command_DeckList::newItem);
+	registerSerializableItem("cmddeck_new_dir", Command_DeckNewDir::newItem);
+	registerSerializableItem("cmddeck_del_dir", Command_DeckDelDir::newItem);
+	registerSerializableItem("cmddeck_del", Command_DeckDel::newItem);
+	registerSerializableItem("cmddeck_download", Command_DeckDownload::newItem);
+	registerSerializableItem("cmdlist_rooms", Command_ListRooms::newItem);
+	registerSerializableItem("cmdjoin_room", Command_JoinRoom::newItem);
+	registerSerializableItem("cmdleave_room", Command_LeaveRoom::newItem);
+	registerSerializableItem("cmdroom_say", Command_RoomSay::newItem);
+	registerSerializableItem("cmdjoin_game", Command_JoinGame::newItem);
+	registerSerializableItem("cmdkick_from_game", Command_KickFromGame::newItem);
+	registerSerializableItem("cmdleave_game", Command_LeaveGame::newItem);
+	registerSerializableItem("cmdsay", Command_Say::newItem);
+	registerSerializableItem("cmdshuffle", Command_Shuffle::newItem);
+	registerSerializableItem("cmdmulligan", Command_Mulligan::newItem);
+	registerSerializableItem("cmdroll_die", Command_RollDie::newItem);
+	registerSerializableItem("cmddraw_cards", Command_DrawCards::newItem);
+	registerSerializableItem("cmdundo_draw", Command_UndoDraw::newItem);
+	registerSerializableItem("cmdflip_card", Command_FlipCard::newItem);
+	registerSerializableItem("cmdattach_card", Command_AttachCard::newItem);
+	registerSerializableItem("cmdcreate_token", Command_CreateToken::newItem);
+	registerSerializableItem("cmdcreate_arrow", Command_CreateArrow::newItem);
+	registerSerializableItem("cmddelete_arrow", Command_DeleteArrow::newItem);
+	registerSerializableItem("cmdset_card_attr", Command_SetCardAttr::newItem);
+	registerSerializableItem("cmdset_card_counter", Command_SetCardCounter::newItem);
+	registerSerializableItem("cmdinc_card_counter", Command_IncCardCounter::newItem);
+	registerSerializableItem("cmdready_start", Command_ReadyStart::newItem);
+	registerSerializableItem("cmdconcede", Command_Concede::newItem);
+	registerSerializableItem("cmdinc_counter", Command_IncCounter::newItem);
+	registerSerializableItem("cmdcreate_counter", Command_CreateCounter::newItem);
+	registerSerializableItem("cmdset_counter", Command_SetCounter::newItem);
+	registerSerializableItem("cmddel_counter", Command_DelCounter::newItem);
+	registerSerializableItem("cmdnext_turn", Command_NextTurn::newItem);
+	registerSerializableItem("cmdset_active_phase", Command_SetActivePhase::newItem);
+	registerSerializableItem("cmddump_zone", Command_DumpZone::newItem);
+	registerSerializableItem("cmdstop_dump_zone", Command_StopDumpZone::newItem);
+	registerSerializableItem("cmdreveal_cards", Command_RevealCards::newItem);
+	registerSerializableItem("game_eventconnection_state_changed", Event_ConnectionStateChanged::newItem);
+	registerSerializableItem("game_eventsay", Event_Say::newItem);
+	registerSerializableItem("game_eventleave", Event_Leave::newItem);
+	registerSerializableItem("game_eventgame_closed", Event_GameClosed::newItem);
+	registerSerializableItem("game_eventgame_host_changed", Event_GameHostChanged::newItem);
+	registerSerializableItem("game_eventkicked", Event_Kicked::newItem);
+	registerSerializableItem("game_eventshuffle", Event_Shuffle::newItem);
+	registerSerializableItem("game_eventroll_die", Event_RollDie::newItem);
+	registerSerializableItem("game_eventmove_card", Event_MoveCard::newItem);
+	registerSerializableItem("game_eventflip_card", Event_FlipCard::newItem);
+	registerSerializableItem("game_eventdestroy_card", Event_DestroyCard::newItem);
+	registerSerializableItem("game_eventattach_card", Event_AttachCard::newItem);
+	registerSerializableItem("game_eventcreate_token", Event_CreateToken::newItem);
+	registerSerializableItem("game_eventdelete_arrow", Event_DeleteArrow::newItem);
+	registerSerializableItem("game_eventset_card_attr", Event_SetCardAttr::newItem);
+	registerSerializableItem("game_eventset_card_counter", Event_SetCardCounter::newItem);
+	registerSerializableItem("game_eventset_counter", Event_SetCounter::newItem);
+	registerSerializableItem("game_eventdel_counter", Event_DelCounter::newItem);
+	registerSerializableItem("game_eventset_active_player", Event_SetActivePlayer::newItem);
+	registerSerializableItem("game_eventset_active_phase", Event_SetActivePhase::newItem);
+	registerSerializableItem("game_eventdump_zone", Event_DumpZone::newItem);
+	registerSerializableItem("game_eventstop_dump_zone", Event_StopDumpZone::newItem);
+	registerSerializableItem("generic_eventremove_from_list", Event_RemoveFromList::newItem);
+	registerSerializableItem("generic_eventserver_message", Event_ServerMessage::newItem);
+	registerSerializableItem("generic_eventserver_shutdown", Event_ServerShutdown::newItem);
+	registerSerializableItem("generic_eventconnection_closed", Event_ConnectionClosed::newItem);
+	registerSerializableItem("generic_eventmessage", Event_Message::newItem);
+	registerSerializableItem("generic_eventgame_joined", Event_GameJoined::newItem);
+	registerSerializableItem("generic_eventuser_left", Event_UserLeft::newItem);
+	registerSerializableItem("room_eventleave_room", Event_LeaveRoom::newItem);
+	registerSerializableItem("room_eventroom_say", Event_RoomSay::newItem);
+	registerSerializableItem("game_event_contextready_start", Context_ReadyStart::newItem);
+	registerSerializableItem("game_event_contextconcede", Context_Concede::newItem);
+	registerSerializableItem("game_event_contextdeck_select", Context_DeckSelect::newItem);
+	registerSerializableItem("game_event_contextundo_draw", Context_UndoDraw::newItem);
+	registerSerializableItem("game_event_contextmove_card", Context_MoveCard::newItem);
+	registerSerializableItem("game_event_contextmulligan", Context_Mulligan::newItem);
+	registerSerializableItem("game_event_contextstate_replay", Context_StateReplay::newItem);
+	registerSerializableItem("cmdupdate_server_message", Command_UpdateServerMessage::newItem);
+	registerSerializableItem("cmdshutdown_server", Command_ShutdownServer::newItem);
+	registerSerializableItem("cmdban_from_server", Command_BanFromServer::newItem);
 }
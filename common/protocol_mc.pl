@@ -13,7 +13,9 @@ print headerfile "#ifndef PROTOCOL_ITEMS_H\n"
 	. "#include \"protocol.h\"\n\n";
 
 open(cppfile, ">protocol_items.cpp");
-print cppfile "#include \"protocol.h\"\n"
+print cppfile "#include <QXmlStreamWriter>\n"
+	. "#include <QDataStream>\n"
+	. "#include \"protocol.h\"\n"
 	. "#include \"protocol_items.h\"\n\n";
 
 open(file, "protocol_items.dat");
@@ -92,8 +94,16 @@ while (<file>) {
 	$itemEnum .= "ItemId_$className = " . ++$itemId . ",\n";
 	$headerfileBuffer .= "class $className : public $baseClass {\n"
 		. "\tQ_OBJECT\n";
-	$constructorCode = '';
+	$constructorInitializers = '';
 	$getFunctionCode = '';
+	$memberCode = '';
+	$fieldIndexCode = '';
+	%fieldsByLength = ();
+	$readFieldCode = '';
+	$writeFieldsCode = '';
+	$readBinaryFieldsCode = '';
+	$writeBinaryFieldsCode = '';
+	$fieldIndex = 0;
 	while ($param = shift(@line)) {
 		($key, $value) = split(/,/, $param);
 		($prettyVarName = $value) =~ s/_(.)/\U$1\E/g;
@@ -108,27 +118,60 @@ while (<file>) {
 			$dataType = 'bool';
 			$constructorParamsH .= "bool _$prettyVarName = false";
 			$constructorParamsCpp .= "bool _$prettyVarName";
-			$constructorCode .= "\tinsertItem(new SerializableItem_Bool(\"$value\", _$prettyVarName));\n";
-			$getFunctionCode .= "\t$dataType get$prettyVarName2() const { return static_cast<SerializableItem_Bool *>(itemMap.value(\"$value\"))->getData(); };\n";
+			$readFieldCode .= "\tcase $fieldIndex: $prettyVarName = boolFromText(fieldText); break;\n";
+			$writeFieldsCode .= "\tif ($prettyVarName)\n\t\txml->writeTextElement(\"$value\", \"1\");\n";
+			$readBinaryFieldsCode .= "\t$prettyVarName = readBinaryBool(in);\n";
+			$writeBinaryFieldsCode .= "\tout << (quint8) $prettyVarName;\n";
 		} elsif ($key eq 's') {
 			$dataType = 'QString';
 			$constructorParamsH .= "const QString &_$prettyVarName = QString()";
 			$constructorParamsCpp .= "const QString &_$prettyVarName";
-			$constructorCode .= "\tinsertItem(new SerializableItem_String(\"$value\", _$prettyVarName));\n";
-			$getFunctionCode .= "\t$dataType get$prettyVarName2() const { return static_cast<SerializableItem_String *>(itemMap.value(\"$value\"))->getData(); };\n";
+			$readFieldCode .= "\tcase $fieldIndex: $prettyVarName.append(fieldText); break;\n";
+			$writeFieldsCode .= "\tif (!$prettyVarName.isEmpty())\n\t\txml->writeTextElement(\"$value\", $prettyVarName);\n";
+			$readBinaryFieldsCode .= "\tin >> $prettyVarName;\n";
+			$writeBinaryFieldsCode .= "\tout << $prettyVarName;\n";
 		} elsif ($key eq 'i') {
 			$dataType = 'int';
 			$constructorParamsH .= "int _$prettyVarName = -1";
 			$constructorParamsCpp .= "int _$prettyVarName";
-			$constructorCode .= "\tinsertItem(new SerializableItem_Int(\"$value\", _$prettyVarName));\n";
-			$getFunctionCode .= "\t$dataType get$prettyVarName2() const { return static_cast<SerializableItem_Int *>(itemMap.value(\"$value\"))->getData(); };\n";
+			$readFieldCode .= "\tcase $fieldIndex: $prettyVarName = intFromText(fieldText); break;\n";
+			$writeFieldsCode .= "\tif ($prettyVarName != -1)\n\t\txml->writeTextElement(\"$value\", QString::number($prettyVarName));\n";
+			$readBinaryFieldsCode .= "\t$prettyVarName = readBinaryInt(in);\n";
+			$writeBinaryFieldsCode .= "\tout << (qint32) $prettyVarName;\n";
 		} elsif ($key eq 'c') {
 			$dataType = 'Color';
 			$constructorParamsH .= "const Color &_$prettyVarName = Color()";
 			$constructorParamsCpp .= "const Color &_$prettyVarName";
-			$constructorCode .= "\tinsertItem(new SerializableItem_Color(\"$value\", _$prettyVarName));\n";
-			$getFunctionCode .= "\t$dataType get$prettyVarName2() const { return static_cast<SerializableItem_Color *>(itemMap.value(\"$value\"))->getData(); };\n";
+			$readFieldCode .= "\tcase $fieldIndex: $prettyVarName = colorFromText(fieldText); break;\n";
+			$writeFieldsCode .= "\tif ($prettyVarName.getValue() != 0)\n\t\txml->writeTextElement(\"$value\", QString::number($prettyVarName.getValue()));\n";
+			$readBinaryFieldsCode .= "\t$prettyVarName = Color(readBinaryInt(in));\n";
+			$writeBinaryFieldsCode .= "\tout << (qint32) $prettyVarName.getValue();\n";
 		}
+		$memberCode .= "\t$dataType $prettyVarName;\n";
+		$constructorInitializers .= ", $prettyVarName(_$prettyVarName)";
+		$getFunctionCode .= "\t$dataType get$prettyVarName2() const { return $prettyVarName; }\n";
+		$fieldsByLength{length($value)} .= "\t\tif (fieldName == QLatin1String(\"$value\"))\n\t\t\treturn $fieldIndex;\n";
+		++$fieldIndex;
+	}
+	# Dispatching on the length leaves at most a few string comparisons.
+	if ($fieldIndex > 0) {
+		$fieldIndexCode = "\tswitch (fieldName.size()) {\n";
+		foreach $length (sort { $a <=> $b } keys %fieldsByLength) {
+			$fieldIndexCode .= "\tcase $length:\n"
+				. $fieldsByLength{$length}
+				. "\t\tbreak;\n";
+		}
+		$fieldIndexCode .= "\t}\n";
+	}
+	if ($fieldIndex > 0) {
+		$headerfileBuffer .= "private:\n"
+			. $memberCode
+			. "protected:\n"
+			. "\tint getFieldIndex(const QStringRef &fieldName) const;\n"
+			. "\tvoid readField(int index, const QStringRef &fieldText);\n"
+			. "\tvoid writeFields(QXmlStreamWriter *xml);\n"
+			. "\tvoid readBinaryFields(QDataStream &in);\n"
+			. "\tvoid writeBinaryFields(QDataStream &out);\n";
 	}
 	$headerfileBuffer .= "public:\n"
 		. "\t$className($constructorParamsH);\n"
@@ -137,11 +180,35 @@ while (<file>) {
 		. "\tint getItemId() const { return ItemId_$className; }\n"
 		. "};\n";
 	print cppfile $className . "::$className($constructorParamsCpp)\n"
-		. "\t: $parentConstructorCall\n"
+		. "\t: $parentConstructorCall$constructorInitializers\n"
 		. "{\n"
-		. $constructorCode
 		. "}\n";
-	$initializeHash .= "\titemNameHash.insert(\"$type$name1\", $className" . "::newItem);\n";
+	if ($fieldIndex > 0) {
+		print cppfile "int $className" . "::getFieldIndex(const QStringRef &fieldName) const\n"
+			. "{\n"
+			. $fieldIndexCode
+			. "\treturn -1;\n"
+			. "}\n"
+			. "void $className" . "::readField(int index, const QStringRef &fieldText)\n"
+			. "{\n"
+			. "\tswitch (index) {\n"
+			. $readFieldCode
+			. "\t}\n"
+			. "}\n"
+			. "void $className" . "::writeFields(QXmlStreamWriter *xml)\n"
+			. "{\n"
+			. $writeFieldsCode
+			. "}\n"
+			. "void $className" . "::readBinaryFields(QDataStream &in)\n"
+			. "{\n"
+			. $readBinaryFieldsCode
+			. "}\n"
+			. "void $className" . "::writeBinaryFields(QDataStream &out)\n"
+			. "{\n"
+			. $writeBinaryFieldsCode
+			. "}\n";
+	}
+	$initializeHash .= "\tregisterSerializableItem(\"$type$name1\", $className" . "::newItem);\n";
 }
 close(file);
 
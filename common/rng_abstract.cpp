@@ -1,6 +1,33 @@
 #include "rng_abstract.h"
 #include <QDebug>
 
+unsigned int RNG_Abstract::getBoundedNumber(uint64_t range)
+{
+	if (range == 0)
+		return 0;
+	
+	// Reject the lowest (2^64 mod range) values so that every remainder is
+	// equally likely. For the ranges we use, this practically never loops.
+	const uint64_t threshold = (0 - range) % range;
+	uint64_t r;
+	do
+		r = nextRandom();
+	while (r < threshold);
+	return (unsigned int) (r % range);
+}
+
+unsigned int RNG_Abstract::getNumber(unsigned int min, unsigned int max)
+{
+	if (max <= min)
+		return min;
+	return min + getBoundedNumber((uint64_t) max - min + 1);
+}
+
+void RNG_Abstract::getShuffleIndices(unsigned int *indices, int size)
+{
+	for (int i = 0; i < size; ++i)
+		indices[i] = getBoundedNumber((uint64_t) i + 1);
+}
 
 QVector<int> RNG_Abstract::makeNumbersVector(int n, int min, int max)
 {
@@ -3,14 +3,36 @@
 
 #include <QObject>
 #include <QVector>
+#include <QList>
+#include <stdint.h>
 
 class RNG_Abstract : public QObject {
 	Q_OBJECT
+protected:
+	// Returns 64 uniformly distributed random bits.
+	virtual uint64_t nextRandom() = 0;
+	// Returns a uniformly chosen number in [0, range), or 0 if range is 0.
+	unsigned int getBoundedNumber(uint64_t range);
 public:
 	RNG_Abstract(QObject *parent = 0) : QObject(parent) { }
-	virtual unsigned int getNumber(unsigned int min, unsigned int max) = 0;
+	// Returns min if max <= min.
+	virtual unsigned int getNumber(unsigned int min, unsigned int max);
+	// Sets indices[i] to a uniformly chosen number in [0, i] for every i < size.
+	virtual void getShuffleIndices(unsigned int *indices, int size);
 	QVector<int> makeNumbersVector(int n, int min, int max);
 	double testRandom(const QVector<int> &numbers) const;
+	
+	// In-place Fisher-Yates shuffle.
+	template<typename T> void shuffle(QList<T> &list)
+	{
+		const int size = list.size();
+		if (size < 2)
+			return;
+		QVector<unsigned int> indices(size);
+		getShuffleIndices(indices.data(), size);
+		for (int i = size - 1; i > 0; --i)
+			list.swap(i, indices[i]);
+	}
 };
 
 extern RNG_Abstract *rng;
@@ -9,8 +9,11 @@ RNG_Qt::RNG_Qt(QObject *parent)
 	qsrand(seed);
 }
 
-unsigned int RNG_Qt::getNumber(unsigned int min, unsigned int max)
+uint64_t RNG_Qt::nextRandom()
 {
-	int r = qrand();
-	return min + (unsigned int) (((double) (max + 1 - min)) * r / (RAND_MAX + 1.0));
+	// RAND_MAX is only guaranteed to be at least 0x7FFF, so take 15 bits at a time.
+	uint64_t result = 0;
+	for (int i = 0; i < 5; ++i)
+		result = (result << 15) | (qrand() & 0x7FFF);
+	return result;
 }
@@ -5,9 +5,10 @@
 
 class RNG_Qt : public RNG_Abstract {
 	Q_OBJECT
+protected:
+	uint64_t nextRandom();
 public:
 	RNG_Qt(QObject *parent = 0);
-	unsigned int getNumber(unsigned int min, unsigned int max);
 };
 
 #endif
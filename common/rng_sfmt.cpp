@@ -5,18 +5,32 @@
 #include <iostream>
 
 RNG_SFMT::RNG_SFMT(QObject *parent)
-	: RNG_Abstract(parent)
+	: RNG_Abstract(parent), bufferPos(bufferSize)
 {
 	std::cerr << "Using SFMT random number generator." << std::endl;
 	
 	int seed = QDateTime::currentDateTime().toTime_t();
 	init_gen_rand(seed);
-	for (int i = 0; i < 100000; ++i)
-		gen_rand64();
+	for (int i = 0; i < 100000 / bufferSize; ++i)
+		refillBuffer();
+}
+
+void RNG_SFMT::refillBuffer()
+{
+	fill_array64(buffer, bufferSize);
+	bufferPos = 0;
 }
 
 unsigned int RNG_SFMT::getNumber(unsigned int min, unsigned int max)
 {
-	uint64_t r = gen_rand64();
-	return min + (unsigned int) (((double) (max + 1 - min)) * r / (18446744073709551616.0 + 1.0));
+	QMutexLocker locker(&mutex);
+	
+	return RNG_Abstract::getNumber(min, max);
+}
+
+void RNG_SFMT::getShuffleIndices(unsigned int *indices, int size)
+{
+	QMutexLocker locker(&mutex);
+	
+	RNG_Abstract::getShuffleIndices(indices, size);
 }
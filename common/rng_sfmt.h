@@ -2,13 +2,33 @@
 #define RNG_SFMT_H
 
 #include "rng_abstract.h"
+#include <QMutex>
+#include <stdint.h>
 
 class RNG_SFMT : public RNG_Abstract {
 	Q_OBJECT
+private:
+	// Random numbers are generated in blocks with fill_array64(), which is
+	// considerably faster than calling gen_rand64() for each of them.
+	// bufferSize has to be even and at least get_min_array_size64().
+	static const int bufferSize = 1024;
+	uint64_t buffer[bufferSize];
+	int bufferPos;
+	QMutex mutex;
+	
+	void refillBuffer();
+protected:
+	// Only called with the mutex held.
+	uint64_t nextRandom()
+	{
+		if (bufferPos == bufferSize)
+			refillBuffer();
+		return buffer[bufferPos++];
+	}
 public:
 	RNG_SFMT(QObject *parent = 0);
 	unsigned int getNumber(unsigned int min, unsigned int max);
+	void getShuffleIndices(unsigned int *indices, int size);
 };
 
 #endif
- 
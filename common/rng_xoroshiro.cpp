@@ -0,0 +1,51 @@
+#include "rng_xoroshiro.h"
+#include <QFile>
+#include <QDateTime>
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitMix64(uint64_t &x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+RNG_Xoroshiro::RNG_Xoroshiro(uint64_t _seed, QObject *parent)
+	: RNG_Abstract(parent), seed(_seed)
+{
+	// The state must not be all zero; two consecutive splitmix64 outputs never both are.
+	uint64_t x = seed;
+	state[0] = splitMix64(x);
+	state[1] = splitMix64(x);
+}
+
+uint64_t RNG_Xoroshiro::nextRandom()
+{
+	const uint64_t s0 = state[0];
+	uint64_t s1 = state[1];
+	const uint64_t result = rotl(s0 * 5, 7) * 9;
+	
+	s1 ^= s0;
+	state[0] = rotl(s0, 24) ^ s1 ^ (s1 << 16);
+	state[1] = rotl(s1, 37);
+	
+	return result;
+}
+
+uint64_t RNG_Xoroshiro::generateSeed()
+{
+	uint64_t result = 0;
+	QFile urandom("/dev/urandom");
+	if (urandom.open(QIODevice::ReadOnly))
+		urandom.read(reinterpret_cast<char *>(&result), sizeof(result));
+	
+	// Still good enough where there is no /dev/urandom.
+	result ^= ((uint64_t) rng->getNumber(0, 0xFFFFFFFF) << 32) | rng->getNumber(0, 0xFFFFFFFF);
+	result ^= (uint64_t) QDateTime::currentDateTime().toTime_t();
+	return result;
+}
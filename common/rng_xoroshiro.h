@@ -0,0 +1,25 @@
+#ifndef RNG_XOROSHIRO_H
+#define RNG_XOROSHIRO_H
+
+#include "rng_abstract.h"
+#include <stdint.h>
+
+// xoroshiro128** keeps its whole state in the object, so every game can have
+// its own independent stream without any locking. The same seed always gives
+// the same sequence.
+class RNG_Xoroshiro : public RNG_Abstract {
+	Q_OBJECT
+private:
+	uint64_t seed;
+	uint64_t state[2];
+protected:
+	uint64_t nextRandom();
+public:
+	RNG_Xoroshiro(uint64_t _seed, QObject *parent = 0);
+	uint64_t getSeed() const { return seed; }
+	
+	// Returns a seed from the operating system's entropy source, mixed with the global rng.
+	static uint64_t generateSeed();
+};
+
+#endif
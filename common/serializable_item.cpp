@@ -2,8 +2,13 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
 
 QHash<QString, SerializableItem::NewItemFunction> SerializableItem::itemNameHash;
+QHash<QString, int> SerializableItem::itemTagHash;
+QHash<int, QString> SerializableItem::itemTagNames;
+int SerializableItem::nextFreeItemTag = 0x4000;
 
 SerializableItem *SerializableItem::getNewItem(const QString &name)
 {
@@ -12,9 +17,26 @@ SerializableItem *SerializableItem::getNewItem(const QString &name)
 	return itemNameHash.value(name)();
 }
 
+SerializableItem *SerializableItem::getNewItem(int tag)
+{
+	if (!itemTagNames.contains(tag))
+		return 0;
+	return getNewItem(itemTagNames.value(tag));
+}
+
 void SerializableItem::registerSerializableItem(const QString &name, NewItemFunction func)
 {
 	itemNameHash.insert(name, func);
+	if (itemTagHash.contains(name))
+		return;
+	
+	SerializableItem *item = func();
+	int tag = item->getItemId();
+	delete item;
+	if ((tag < 0) || itemTagNames.contains(tag))
+		tag = nextFreeItemTag++;
+	itemTagHash.insert(name, tag);
+	itemTagNames.insert(tag, name);
 }
 
 bool SerializableItem::read(QXmlStreamReader *xml)
@@ -43,6 +65,36 @@ bool SerializableItem::read(QXmlStreamReader *xml)
 	}
 }
 
+bool SerializableItem::parseInt(const QStringRef &text, int &value)
+{
+	const QChar *data = text.unicode();
+	int size = text.size();
+	int i = 0;
+	bool negative = false;
+	if ((size > 0) && ((data[0] == QLatin1Char('-')) || (data[0] == QLatin1Char('+')))) {
+		negative = data[0] == QLatin1Char('-');
+		++i;
+	}
+	if (i == size)
+		return false;
+	
+	qint64 result = 0;
+	for (; i < size; ++i) {
+		ushort digit = data[i].unicode() - '0';
+		if (digit > 9)
+			return false;
+		result = result * 10 + digit;
+		if (result > (qint64) 2147483648LL)
+			return false;
+	}
+	if (negative)
+		result = -result;
+	else if (result > 2147483647)
+		return false;
+	value = (int) result;
+	return true;
+}
+
 bool SerializableItem::readElement(QXmlStreamReader *xml)
 {
 	if (xml->isEndElement() && (xml->name() == itemType))
@@ -74,6 +126,89 @@ void SerializableItem::write(QXmlStreamWriter *xml)
 	xml->writeEndElement();
 }
 
+bool SerializableItem::readBinaryElement(QDataStream &in)
+{
+	// Items without a binary representation are carried as an XML blob.
+	QByteArray data;
+	in >> data;
+	if (in.status() != QDataStream::Ok)
+		return false;
+	
+	QXmlStreamReader xml(data);
+	bool started = false;
+	while (!xml.atEnd()) {
+		xml.readNext();
+		if (!started) {
+			if (!xml.isStartElement())
+				continue;
+			started = true;
+		}
+		if (readElement(&xml))
+			return true;
+	}
+	return false;
+}
+
+bool SerializableItem::writeBinaryElement(QDataStream &out)
+{
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	QXmlStreamWriter xml(&buffer);
+	xml.writeStartElement(itemType);
+	writeElement(&xml);
+	xml.writeEndElement();
+	buffer.close();
+	
+	out << buffer.data();
+	return true;
+}
+
+SerializableItem *SerializableItem::readBinary(QDataStream &in)
+{
+	quint16 tag;
+	in >> tag;
+	if (tag == xmlItemTag) {
+		QString type, subType;
+		in >> type >> subType;
+		if (in.status() != QDataStream::Ok)
+			return 0;
+		SerializableItem *item = getNewItem(type + subType);
+		if (!item)
+			item = new SerializableItem_Invalid(type);
+		if (!item->SerializableItem::readBinaryElement(in)) {
+			in.setStatus(QDataStream::ReadCorruptData);
+			delete item;
+			return 0;
+		}
+		return item;
+	}
+	
+	SerializableItem *item = getNewItem(tag);
+	if (!item) {
+		in.setStatus(QDataStream::ReadCorruptData);
+		return 0;
+	}
+	if (!item->readBinaryElement(in)) {
+		in.setStatus(QDataStream::ReadCorruptData);
+		delete item;
+		return 0;
+	}
+	return item;
+}
+
+bool SerializableItem::writeBinary(QDataStream &out)
+{
+	QHash<QString, int>::const_iterator tag = itemTagHash.constFind(itemType + itemSubType);
+	if (tag == itemTagHash.constEnd()) {
+		// Slower and larger, but the peer can still read it.
+		qDebug() << "SerializableItem: no binary tag for item type" << itemType << itemSubType << "- sending it as XML";
+		out << xmlItemTag << itemType << itemSubType;
+		return SerializableItem::writeBinaryElement(out);
+	}
+	out << (quint16) tag.value();
+	return writeBinaryElement(out);
+}
+
 SerializableItem_Map::~SerializableItem_Map()
 {
 	QMapIterator<QString, SerializableItem *> mapIterator(itemMap);
@@ -89,20 +224,32 @@ bool SerializableItem_Map::readElement(QXmlStreamReader *xml)
 		if (currentItem->read(xml))
 			currentItem = 0;
 		return false;
+	} else if (currentField != -1) {
+		// Strings containing entities arrive in several chunks; the
+		// generated string fields append, all others are parsed in place.
+		if (xml->isCharacters() && !xml->isWhitespace())
+			readField(currentField, xml->text());
+		else if (xml->isEndElement())
+			currentField = -1;
+		return false;
 	} else if (firstItem)
 		firstItem = false;
 	else if (xml->isEndElement() && (xml->name() == itemType))
 		extractData();
 	else if (xml->isStartElement()) {
-		QString childName = xml->name().toString();
-		QString childSubType = xml->attributes().value("type").toString();
-		bool childCompressed = xml->attributes().value("comp").toString().toInt() == 1;
-		currentItem = itemMap.value(childName);
+		const QStringRef childName = xml->name();
+		currentField = getFieldIndex(childName);
+		if (currentField != -1)
+			return false;
+		
+		const QXmlStreamAttributes attributes = xml->attributes();
+		bool childCompressed = attributes.value(QLatin1String("comp")) == QLatin1String("1");
+		currentItem = findMapItem(childName);
 		if (!currentItem) {
-			currentItem = getNewItem(childName + childSubType);
+			currentItem = getNewItem(childName.toString() + attributes.value(QLatin1String("type")).toString());
 			itemList.append(currentItem);
 			if (!currentItem)
-				currentItem = new SerializableItem_Invalid(childName);
+				currentItem = new SerializableItem_Invalid(childName.toString());
 		}
 		currentItem->setCompressed(childCompressed);
 		if (currentItem->read(xml))
@@ -116,10 +263,94 @@ void SerializableItem_Map::writeElement(QXmlStreamWriter *xml)
 	QMapIterator<QString, SerializableItem *> mapIterator(itemMap);
 	while (mapIterator.hasNext())
 		mapIterator.next().value()->write(xml);
+	writeFields(xml);
 	for (int i = 0; i < itemList.size(); ++i)
 		itemList[i]->write(xml);
 }
 
+SerializableItem *SerializableItem_Map::findMapItem(const QStringRef &name) const
+{
+	// The maps are small, so a scan is cheaper than building a key.
+	QMapIterator<QString, SerializableItem *> mapIterator(itemMap);
+	while (mapIterator.hasNext()) {
+		mapIterator.next();
+		if (mapIterator.key() == name)
+			return mapIterator.value();
+	}
+	return 0;
+}
+
+int SerializableItem_Map::intFromText(const QStringRef &text)
+{
+	int value;
+	return parseInt(text, value) ? value : -1;
+}
+
+Color SerializableItem_Map::colorFromText(const QStringRef &text)
+{
+	int colorValue;
+	return parseInt(text, colorValue) ? Color(colorValue) : Color();
+}
+
+int SerializableItem_Map::readBinaryInt(QDataStream &in)
+{
+	qint32 value;
+	in >> value;
+	return value;
+}
+
+bool SerializableItem_Map::readBinaryBool(QDataStream &in)
+{
+	quint8 value;
+	in >> value;
+	return value;
+}
+
+bool SerializableItem_Map::readBinaryElement(QDataStream &in)
+{
+	// Both ends construct the same fields for a given item type, so the
+	// map entries are sent in key order without their names.
+	quint16 mapSize;
+	in >> mapSize;
+	if (mapSize != itemMap.size())
+		return false;
+	QMapIterator<QString, SerializableItem *> mapIterator(itemMap);
+	while (mapIterator.hasNext())
+		if (!mapIterator.next().value()->readBinaryElement(in))
+			return false;
+	readBinaryFields(in);
+	
+	quint32 listSize;
+	in >> listSize;
+	for (quint32 i = 0; (i < listSize) && (in.status() == QDataStream::Ok); ++i) {
+		SerializableItem *item = readBinary(in);
+		if (!item)
+			return false;
+		itemList.append(item);
+	}
+	if (in.status() != QDataStream::Ok)
+		return false;
+	
+	extractData();
+	return true;
+}
+
+bool SerializableItem_Map::writeBinaryElement(QDataStream &out)
+{
+	out << (quint16) itemMap.size();
+	QMapIterator<QString, SerializableItem *> mapIterator(itemMap);
+	while (mapIterator.hasNext())
+		if (!mapIterator.next().value()->writeBinaryElement(out))
+			return false;
+	writeBinaryFields(out);
+	
+	out << (quint32) itemList.size();
+	for (int i = 0; i < itemList.size(); ++i)
+		if (!itemList[i]->writeBinary(out))
+			return false;
+	return true;
+}
+
 bool SerializableItem_String::readElement(QXmlStreamReader *xml)
 {
 	// This function is sometimes called multiple times if there are
@@ -135,14 +366,23 @@ void SerializableItem_String::writeElement(QXmlStreamWriter *xml)
 	xml->writeCharacters(data);
 }
 
+bool SerializableItem_String::readBinaryElement(QDataStream &in)
+{
+	in >> data;
+	return in.status() == QDataStream::Ok;
+}
+
+bool SerializableItem_String::writeBinaryElement(QDataStream &out)
+{
+	out << data;
+	return true;
+}
+
 bool SerializableItem_Int::readElement(QXmlStreamReader *xml)
 {
-	if (xml->isCharacters() && !xml->isWhitespace()) {
-		bool ok;
-		data = xml->text().toString().toInt(&ok);
-		if (!ok)
+	if (xml->isCharacters() && !xml->isWhitespace())
+		if (!parseInt(xml->text(), data))
 			data = -1;
-	}
 	return SerializableItem::readElement(xml);
 }
 
@@ -151,10 +391,24 @@ void SerializableItem_Int::writeElement(QXmlStreamWriter *xml)
 	xml->writeCharacters(QString::number(data));
 }
 
+bool SerializableItem_Int::readBinaryElement(QDataStream &in)
+{
+	qint32 value;
+	in >> value;
+	data = value;
+	return in.status() == QDataStream::Ok;
+}
+
+bool SerializableItem_Int::writeBinaryElement(QDataStream &out)
+{
+	out << (qint32) data;
+	return true;
+}
+
 bool SerializableItem_Bool::readElement(QXmlStreamReader *xml)
 {
 	if (xml->isCharacters() && !xml->isWhitespace())
-		data = xml->text().toString() == "1";
+		data = xml->text() == QLatin1String("1");
 	return SerializableItem::readElement(xml);
 }
 
@@ -163,12 +417,25 @@ void SerializableItem_Bool::writeElement(QXmlStreamWriter *xml)
 	xml->writeCharacters(data ? "1" : "0");
 }
 
+bool SerializableItem_Bool::readBinaryElement(QDataStream &in)
+{
+	quint8 value;
+	in >> value;
+	data = value;
+	return in.status() == QDataStream::Ok;
+}
+
+bool SerializableItem_Bool::writeBinaryElement(QDataStream &out)
+{
+	out << (quint8) data;
+	return true;
+}
+
 bool SerializableItem_Color::readElement(QXmlStreamReader *xml)
 {
 	if (xml->isCharacters() && !xml->isWhitespace()) {
-		bool ok;
-		int colorValue = xml->text().toString().toInt(&ok);
-		data = ok ? Color(colorValue) : Color();
+		int colorValue;
+		data = parseInt(xml->text(), colorValue) ? Color(colorValue) : Color();
 	}
 	return SerializableItem::readElement(xml);
 }
@@ -178,6 +445,20 @@ void SerializableItem_Color::writeElement(QXmlStreamWriter *xml)
 	xml->writeCharacters(QString::number(data.getValue()));
 }
 
+bool SerializableItem_Color::readBinaryElement(QDataStream &in)
+{
+	qint32 colorValue;
+	in >> colorValue;
+	data = Color(colorValue);
+	return in.status() == QDataStream::Ok;
+}
+
+bool SerializableItem_Color::writeBinaryElement(QDataStream &out)
+{
+	out << (qint32) data.getValue();
+	return true;
+}
+
 bool SerializableItem_DateTime::readElement(QXmlStreamReader *xml)
 {
 	if (xml->isCharacters() && !xml->isWhitespace()) {
@@ -193,6 +474,20 @@ void SerializableItem_DateTime::writeElement(QXmlStreamWriter *xml)
 	xml->writeCharacters(QString::number(data.toTime_t()));
 }
 
+bool SerializableItem_DateTime::readBinaryElement(QDataStream &in)
+{
+	quint32 dateTimeValue;
+	in >> dateTimeValue;
+	data = dateTimeValue == 0xffffffff ? QDateTime() : QDateTime::fromTime_t(dateTimeValue);
+	return in.status() == QDataStream::Ok;
+}
+
+bool SerializableItem_DateTime::writeBinaryElement(QDataStream &out)
+{
+	out << (quint32) data.toTime_t();
+	return true;
+}
+
 bool SerializableItem_ByteArray::readElement(QXmlStreamReader *xml)
 {
 	if (xml->isCharacters() && !xml->isWhitespace())
@@ -205,3 +500,15 @@ void SerializableItem_ByteArray::writeElement(QXmlStreamWriter *xml)
 {
 	xml->writeCharacters(QString(qCompress(data).toBase64()));
 }
+
+bool SerializableItem_ByteArray::readBinaryElement(QDataStream &in)
+{
+	in >> data;
+	return in.status() == QDataStream::Ok;
+}
+
+bool SerializableItem_ByteArray::writeBinaryElement(QDataStream &out)
+{
+	out << data;
+	return true;
+}
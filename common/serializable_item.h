@@ -12,6 +12,7 @@
 
 class QXmlStreamReader;
 class QXmlStreamWriter;
+class QDataStream;
 
 class SerializableItem : public QObject {
 	Q_OBJECT
@@ -23,21 +24,39 @@ protected:
 	typedef SerializableItem *(*NewItemFunction)();
 	static QHash<QString, NewItemFunction> itemNameHash;
 	
+	// Numeric tags used in binary mode. Protocol items are tagged with
+	// their item id, everything else gets a tag in order of registration.
+	static QHash<QString, int> itemTagHash;
+	static QHash<int, QString> itemTagNames;
+	static int nextFreeItemTag;
+	// Followed by the item type, subtype and XML, for items without a tag.
+	static const quint16 xmlItemTag = 0xFFFF;
+	
 	QString itemType, itemSubType;
 	bool firstItem;
+	
+	// Parses without going through a temporary QString.
+	static bool parseInt(const QStringRef &text, int &value);
 public:
 	SerializableItem(const QString &_itemType, const QString &_itemSubType = QString())
 		: QObject(), compressed(false), itemType(_itemType), itemSubType(_itemSubType), firstItem(true) { }
 	static void registerSerializableItem(const QString &name, NewItemFunction func);
 	static SerializableItem *getNewItem(const QString &name);
+	static SerializableItem *getNewItem(int tag);
 	const QString &getItemType() const { return itemType; }
 	const QString &getItemSubType() const { return itemSubType; }
+	virtual int getItemId() const { return -1; }
 	virtual bool readElement(QXmlStreamReader *xml);
 	virtual void writeElement(QXmlStreamWriter *xml) = 0;
+	virtual bool readBinaryElement(QDataStream &in);
+	virtual bool writeBinaryElement(QDataStream &out);
 	virtual bool isEmpty() const = 0;
 	void setCompressed(bool _compressed) { compressed = _compressed; }
 	bool read(QXmlStreamReader *xml);
 	void write(QXmlStreamWriter *xml);
+	static SerializableItem *readBinary(QDataStream &in);
+	// Item types without a binary tag are written as XML.
+	bool writeBinary(QDataStream &out);
 };
 
 class SerializableItem_Invalid : public SerializableItem {
@@ -50,10 +69,26 @@ public:
 class SerializableItem_Map : public SerializableItem {
 private:
 	SerializableItem *currentItem;
+	int currentField;
+	SerializableItem *findMapItem(const QStringRef &name) const;
 protected:
 	QMap<QString, SerializableItem *> itemMap;
 	QList<SerializableItem *> itemList;
 	virtual void extractData() { }
+	
+	// Plain typed fields, implemented by the classes generated from
+	// protocol_items.dat. They are not part of itemMap.
+	virtual int getFieldIndex(const QStringRef & /*name*/) const { return -1; }
+	virtual void readField(int /*index*/, const QStringRef & /*text*/) { }
+	virtual void writeFields(QXmlStreamWriter * /*xml*/) { }
+	virtual void readBinaryFields(QDataStream & /*in*/) { }
+	virtual void writeBinaryFields(QDataStream & /*out*/) { }
+	static int intFromText(const QStringRef &text);
+	static bool boolFromText(const QStringRef &text) { return text == QLatin1String("1"); }
+	static Color colorFromText(const QStringRef &text);
+	static int readBinaryInt(QDataStream &in);
+	static bool readBinaryBool(QDataStream &in);
+	
 	void insertItem(SerializableItem *item)
 	{
 		itemMap.insert(item->getItemType(), item);
@@ -70,12 +105,14 @@ protected:
 	}
 public:
 	SerializableItem_Map(const QString &_itemType, const QString &_itemSubType = QString())
-		: SerializableItem(_itemType, _itemSubType), currentItem(0)
+		: SerializableItem(_itemType, _itemSubType), currentItem(0), currentField(-1)
 	{
 	}
 	~SerializableItem_Map();
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 	bool isEmpty() const { return itemMap.isEmpty() && itemList.isEmpty(); }
 	void appendItem(SerializableItem *item) { itemList.append(item); }
 };
@@ -86,6 +123,8 @@ private:
 protected:
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 public:
 	SerializableItem_String(const QString &_itemType, const QString &_data = QString())
 		: SerializableItem(_itemType), data(_data) { }
@@ -100,6 +139,8 @@ private:
 protected:
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 public:
 	SerializableItem_Int(const QString &_itemType, int _data = -1)
 		: SerializableItem(_itemType), data(_data) { }
@@ -114,6 +155,8 @@ private:
 protected:
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 public:
 	SerializableItem_Bool(const QString &_itemType, bool _data = false)
 		: SerializableItem(_itemType), data(_data) { }
@@ -128,6 +171,8 @@ private:
 protected:
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 public:
 	SerializableItem_Color(const QString &_itemType, const Color &_data = Color())
 		: SerializableItem(_itemType), data(_data) { }
@@ -142,6 +187,8 @@ private:
 protected:
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 public:
 	SerializableItem_DateTime(const QString &_itemType, const QDateTime &_data = QDateTime())
 		: SerializableItem(_itemType), data(_data) { }
@@ -156,6 +203,8 @@ private:
 protected:
 	bool readElement(QXmlStreamReader *xml);
 	void writeElement(QXmlStreamWriter *xml);
+	bool readBinaryElement(QDataStream &in);
+	bool writeBinaryElement(QDataStream &out);
 public:
 	SerializableItem_ByteArray(const QString &_itemType, const QByteArray &_data = QByteArray())
 		: SerializableItem(_itemType), data(_data) { }
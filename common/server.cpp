@@ -24,10 +24,11 @@
 #include "server_protocolhandler.h"
 #include "protocol_datastructures.h"
 #include <QCoreApplication>
+#include <QThread>
 #include <QDebug>
 
 Server::Server(QObject *parent)
-	: QObject(parent), serverMutex(QMutex::Recursive), nextGameId(0)
+	: QObject(parent), serverMutex(QMutex::Recursive), clientsLock(QReadWriteLock::Recursive), nextGameId(0)
 {
 }
 
@@ -37,21 +38,86 @@ Server::~Server()
 
 void Server::prepareDestroy()
 {
+	// Game threads must not run commands while the games are torn down.
+	stopGameThreads();
+	
 	QMutexLocker locker(&serverMutex);
 	
-	while (!clients.isEmpty())
-		delete clients.takeFirst();
+	clientsLock.lockForWrite();
+	QList<Server_ProtocolHandler *> clientsCopy = clients;
+	clients.clear();
+	clientsLock.unlock();
+	for (int i = 0; i < clientsCopy.size(); ++i)
+		delete clientsCopy[i];
 	
 	QMapIterator<int, Server_Room *> roomIterator(rooms);
 	while (roomIterator.hasNext())
 		delete roomIterator.next().value();
 }
 
+void Server::startGameThreads(int numberOfThreads)
+{
+	for (int i = 0; i < numberOfThreads; ++i) {
+		QThread *thread = new QThread(this);
+		thread->start();
+		gameThreads.append(thread);
+	}
+}
+
+void Server::stopGameThreads()
+{
+	for (int i = 0; i < gameThreads.size(); ++i) {
+		gameThreads[i]->quit();
+		gameThreads[i]->wait();
+		delete gameThreads[i];
+	}
+	gameThreads.clear();
+}
+
+QThread *Server::getNextGameThread()
+{
+	if (gameThreads.isEmpty())
+		return 0;
+	
+	unsigned int index = nextGameThread.fetchAndAddRelaxed(1);
+	return gameThreads[index % gameThreads.size()];
+}
+
+bool Server::insertUser(const QString &name, Server_ProtocolHandler *session)
+{
+	UserShard &shard = getUserShard(name);
+	QWriteLocker locker(&shard.lock);
+	if (shard.users.contains(name))
+		return false;
+	shard.users.insert(name, session);
+	usersCount.ref();
+	return true;
+}
+
+Server_ProtocolHandler *Server::getUser(const QString &name) const
+{
+	const UserShard &shard = getUserShard(name);
+	QReadLocker locker(&shard.lock);
+	return shard.users.value(name);
+}
+
+QList<Server_ProtocolHandler *> Server::getUserList() const
+{
+	QList<Server_ProtocolHandler *> result;
+	for (int i = 0; i < userShardCount; ++i) {
+		QReadLocker locker(&userShards[i].lock);
+		result << userShards[i].users.values();
+	}
+	return result;
+}
+
 AuthenticationResult Server::loginUser(Server_ProtocolHandler *session, QString &name, const QString &password)
 {
-	QMutexLocker locker(&serverMutex);
 	if (name.size() > 35)
 		name = name.left(35);
+	
+	// This may block on the database for a while, so it must not hold any
+	// lock that other connections need.
 	AuthenticationResult authState = checkUserPassword(session, name, password);
 	if (authState == PasswordWrong)
 		return authState;
@@ -60,9 +126,12 @@ AuthenticationResult Server::loginUser(Server_ProtocolHandler *session, QString
 	data->setAddress(session->getAddress());
 	name = data->getName(); // Compensate for case indifference
 	
+	// The session becomes visible to other threads as soon as it is inserted.
+	session->setUserInfo(data);
 	if (authState == PasswordRight) {
-		if (users.contains(name)) {
+		if (!insertUser(name, session)) {
 			qDebug("Login denied: would overwrite old session");
+			session->setUserInfo(0);
 			delete data;
 			return WouldOverwriteOldSession;
 		}
@@ -71,24 +140,24 @@ AuthenticationResult Server::loginUser(Server_ProtocolHandler *session, QString
 		// don't interfere with registered user names though.
 		QString tempName = name;
 		int i = 0;
-		while (users.contains(tempName) || userExists(tempName))
+		while (userExists(tempName) || !insertUser(tempName, session)) {
 			tempName = name + "_" + QString::number(++i);
+			data->setName(tempName);
+		}
 		name = tempName;
-		data->setName(name);
 	}
-	
-	session->setUserInfo(data);
-	
-	users.insert(name, session);
 	qDebug() << "Server::loginUser: name=" << name;
 	
 	session->setSessionId(startSession(name, session->getAddress()));
 	qDebug() << "session id:" << session->getSessionId();
 	
 	Event_UserJoined *event = new Event_UserJoined(new ServerInfo_User(data, false));
+	EncodedProtocolItem encodedEvent(event);
+	clientsLock.lockForRead();
 	for (int i = 0; i < clients.size(); ++i)
 		if (clients[i]->getAcceptsUserListChanges())
-			clients[i]->sendProtocolItem(event, false);
+			clients[i]->sendEncodedItem(encodedEvent);
+	clientsLock.unlock();
 	delete event;
 	
 	return authState;
@@ -96,45 +165,122 @@ AuthenticationResult Server::loginUser(Server_ProtocolHandler *session, QString
 
 void Server::addClient(Server_ProtocolHandler *client)
 {
-	QMutexLocker locker(&serverMutex);
+	QWriteLocker locker(&clientsLock);
 	clients << client;
+	const QHostAddress address = client->getPeerAddress();
+	if (!address.isNull())
+		++clientsPerAddress[address];
+	timerWheel.schedule(client, getMaxPlayerInactivityTime() + 1);
 }
 
 void Server::removeClient(Server_ProtocolHandler *client)
 {
-	QMutexLocker locker(&serverMutex);
+	clientsLock.lockForWrite();
 	clients.removeAt(clients.indexOf(client));
+	const QHostAddress address = client->getPeerAddress();
+	if (!address.isNull()) {
+		QHash<QHostAddress, int>::iterator addressCount = clientsPerAddress.find(address);
+		if ((addressCount != clientsPerAddress.end()) && (--addressCount.value() == 0))
+			clientsPerAddress.erase(addressCount);
+	}
+	timerWheel.cancel(client);
 	ServerInfo_User *data = client->getUserInfo();
+	if (data) {
+		UserShard &shard = getUserShard(data->getName());
+		shard.lock.lockForWrite();
+		if (shard.users.value(data->getName()) == client) {
+			shard.users.remove(data->getName());
+			usersCount.deref();
+		}
+		shard.lock.unlock();
+	}
+	int clientsCount = clients.size();
+	clientsLock.unlock();
+	
 	if (data) {
 		Event_UserLeft *event = new Event_UserLeft(data->getName());
+		EncodedProtocolItem encodedEvent(event);
+		clientsLock.lockForRead();
 		for (int i = 0; i < clients.size(); ++i)
 			if (clients[i]->getAcceptsUserListChanges())
-				clients[i]->sendProtocolItem(event, false);
+				clients[i]->sendEncodedItem(encodedEvent);
+		clientsLock.unlock();
 		delete event;
 		
-		users.remove(data->getName());
 		qDebug() << "Server::removeClient: name=" << data->getName();
 		
 		if (client->getSessionId() != -1)
 			endSession(client->getSessionId());
 		qDebug() << "closed session id:" << client->getSessionId();
 	}
-	qDebug() << "Server::removeClient:" << clients.size() << "clients; " << users.size() << "users left";
+	qDebug() << "Server::removeClient:" << clientsCount << "clients; " << getUsersCount() << "users left";
 }
 
-void Server::broadcastRoomUpdate()
+int Server::getUsersWithAddress(const QHostAddress &address) const
 {
+	QReadLocker locker(&clientsLock);
+	return clientsPerAddress.value(address);
+}
+
+static bool compareAddressCounts(const QPair<QHostAddress, int> &a, const QPair<QHostAddress, int> &b)
+{
+	return a.second > b.second;
+}
+
+QList<QPair<QHostAddress, int> > Server::getTopAddresses(int count) const
+{
+	QList<QPair<QHostAddress, int> > result;
+	clientsLock.lockForRead();
+	QHashIterator<QHostAddress, int> addressIterator(clientsPerAddress);
+	while (addressIterator.hasNext()) {
+		addressIterator.next();
+		result.append(QPair<QHostAddress, int>(addressIterator.key(), addressIterator.value()));
+	}
+	clientsLock.unlock();
+	
+	qSort(result.begin(), result.end(), compareAddressCounts);
+	return result.mid(0, count);
+}
+
+void Server::pingClockTimeout()
+{
+	// Clients are only cancelled with clientsLock held for writing, so
+	// everything tick() returns stays alive while we hold it for reading.
+	clientsLock.lockForRead();
+	QList<Server_TimerWheelClient *> expired = timerWheel.tick();
+	for (int i = 0; i < expired.size(); ++i)
+		expired[i]->timerWheelExpired();
+	clientsLock.unlock();
+	
+	if (!getGameShouldPing())
+		return;
+	
 	QMutexLocker locker(&serverMutex);
+	QMapIterator<int, Server_Room *> roomIterator(rooms);
+	while (roomIterator.hasNext()) {
+		Server_Room *room = roomIterator.next().value();
+		QMutexLocker roomLocker(&room->roomMutex);
+		QMapIterator<int, Server_Game *> gameIterator(room->getGames());
+		while (gameIterator.hasNext())
+			QMetaObject::invokeMethod(gameIterator.next().value(), "pingClockTimeout", Qt::QueuedConnection);
+	}
+}
+
+void Server::broadcastRoomUpdate()
+{
 	Server_Room *room = static_cast<Server_Room *>(sender());
 	QList<ServerInfo_Room *> eventRoomList;
 	room->roomMutex.lock();
 	eventRoomList.append(new ServerInfo_Room(room->getId(), room->getName(), room->getDescription(), room->getGames().size(), room->size(), room->getAutoJoin()));
 	room->roomMutex.unlock();
 	Event_ListRooms *event = new Event_ListRooms(eventRoomList);
+	EncodedProtocolItem encodedEvent(event);
 
+	clientsLock.lockForRead();
 	for (int i = 0; i < clients.size(); ++i)
 	  	if (clients[i]->getAcceptsRoomListChanges())
-			clients[i]->sendProtocolItem(event, false);
+			clients[i]->sendEncodedItem(encodedEvent);
+	clientsLock.unlock();
 	delete event;
 }
 
@@ -147,8 +293,7 @@ void Server::addRoom(Server_Room *newRoom)
 
 int Server::getUsersCount() const
 {
-	QMutexLocker locker(&serverMutex);
-	return users.size();
+	return usersCount;
 }
 
 int Server::getGamesCount() const
@@ -4,8 +4,15 @@
 #include <QObject>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+#include <QHostAddress>
+#include <QPair>
+#include "server_timerwheel.h"
 
+class QThread;
 class Server_Game;
 class Server_Room;
 class Server_ProtocolHandler;
@@ -16,21 +23,34 @@ enum AuthenticationResult { PasswordWrong = 0, PasswordRight = 1, UnknownUser =
 class Server : public QObject
 {
 	Q_OBJECT
-signals:
-	void pingClockTimeout();
 private slots:
 	void broadcastRoomUpdate();
+protected slots:
+	// Drives every per-second timer of the server. Subclasses connect a one
+	// second QTimer to this.
+	void pingClockTimeout();
 public:
 	mutable QMutex serverMutex;
+	// Guards the client list. Holding it for reading also keeps every
+	// handler returned by getUser() and getUserList() alive.
+	mutable QReadWriteLock clientsLock;
 	Server(QObject *parent = 0);
 	~Server();
 	AuthenticationResult loginUser(Server_ProtocolHandler *session, QString &name, const QString &password);
 	const QMap<int, Server_Room *> &getRooms() { return rooms; }
 	int getNextGameId() { return nextGameId++; }
+	QThread *getNextGameThread();
+	// Seconds since the server started, in pingClockTimeout() steps.
+	int getTickCount() const { return timerWheel.getCurrentTick(); }
+	Server_TimerWheel &getTimerWheel() { return timerWheel; }
 	
-	const QMap<QString, Server_ProtocolHandler *> &getUsers() const { return users; }
+	Server_ProtocolHandler *getUser(const QString &name) const;
+	QList<Server_ProtocolHandler *> getUserList() const;
 	void addClient(Server_ProtocolHandler *player);
 	void removeClient(Server_ProtocolHandler *player);
+	int getUsersWithAddress(const QHostAddress &address) const;
+	// The addresses with the most connections, most first.
+	QList<QPair<QHostAddress, int> > getTopAddresses(int count) const;
 	virtual QString getLoginMessage() const = 0;
 	
 	virtual bool getGameShouldPing() const = 0;
@@ -44,10 +64,30 @@ public:
 	
 	virtual QMap<QString, ServerInfo_User *> getBuddyList(const QString &name) = 0;
 	virtual QMap<QString, ServerInfo_User *> getIgnoreList(const QString &name) = 0;
+private:
+	QList<QThread *> gameThreads;
+	QAtomicInt nextGameThread;
+	Server_TimerWheel timerWheel;
+	
+	// Logged in users, sharded by name so that logins and lookups of
+	// different users do not contend for the same lock.
+	static const int userShardCount = 16;
+	struct UserShard {
+		mutable QReadWriteLock lock;
+		QMap<QString, Server_ProtocolHandler *> users;
+	};
+	UserShard userShards[userShardCount];
+	QAtomicInt usersCount;
+	UserShard &getUserShard(const QString &name) { return userShards[qHash(name) % userShardCount]; }
+	const UserShard &getUserShard(const QString &name) const { return userShards[qHash(name) % userShardCount]; }
+	bool insertUser(const QString &name, Server_ProtocolHandler *session);
 protected:
 	void prepareDestroy();
+	void startGameThreads(int numberOfThreads);
+	void stopGameThreads();
 	QList<Server_ProtocolHandler *> clients;
-	QMap<QString, Server_ProtocolHandler *> users;
+	// Number of clients per peer address, guarded by clientsLock.
+	QHash<QHostAddress, int> clientsPerAddress;
 	QMap<int, Server_Room *> rooms;
 	
 	virtual int startSession(const QString &userName, const QString &address) = 0;
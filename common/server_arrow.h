@@ -2,20 +2,43 @@
 #define SERVER_ARROW_H
 
 #include "color.h"
+#include "server_arrowtarget.h"
+#include "server_card.h"
 
-class Server_Card;
-class Server_ArrowTarget;
+class Server_Player;
 
 class Server_Arrow {
+	friend class Server_ArrowTarget;
 private:
 	int id;
+	Server_Player *player;
 	Server_Card *startCard;
 	Server_ArrowTarget *targetItem;
 	Color color;
+	
+	void unlinkItem(Server_ArrowTarget *item)
+	{
+		if (startCard == item)
+			startCard = 0;
+		if (targetItem == item)
+			targetItem = 0;
+	}
 public:
-	Server_Arrow(int _id, Server_Card *_startCard, Server_ArrowTarget *_targetItem, const Color &_color)
-		: id(_id), startCard(_startCard), targetItem(_targetItem), color(_color) { }
+	Server_Arrow(int _id, Server_Player *_player, Server_Card *_startCard, Server_ArrowTarget *_targetItem, const Color &_color)
+		: id(_id), player(_player), startCard(_startCard), targetItem(_targetItem), color(_color)
+	{
+		startCard->addRelatedArrow(this);
+		targetItem->addRelatedArrow(this);
+	}
+	~Server_Arrow()
+	{
+		if (startCard)
+			startCard->removeRelatedArrow(this);
+		if (targetItem)
+			targetItem->removeRelatedArrow(this);
+	}
 	int getId() const { return id; }
+	Server_Player *getPlayer() const { return player; }
 	Server_Card *getStartCard() const { return startCard; }
 	Server_ArrowTarget *getTargetItem() const { return targetItem; }
 	const Color &getColor() const { return color; }
@@ -0,0 +1,11 @@
+#include "server_arrowtarget.h"
+#include "server_arrow.h"
+
+Server_ArrowTarget::~Server_ArrowTarget()
+{
+	// Arrows normally die before their ends do, except when several players'
+	// zones are cleared at once. Make sure they don't touch us afterwards.
+	QSetIterator<Server_Arrow *> arrowIterator(relatedArrows);
+	while (arrowIterator.hasNext())
+		arrowIterator.next()->unlinkItem(this);
+}
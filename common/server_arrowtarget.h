@@ -2,9 +2,20 @@
 #define SERVER_ARROWTARGET_H
 
 #include <QObject>
+#include <QSet>
+
+class Server_Arrow;
 
 class Server_ArrowTarget : public QObject {
 	Q_OBJECT
+private:
+	// All arrows starting at or pointing to this item, maintained by Server_Arrow.
+	QSet<Server_Arrow *> relatedArrows;
+public:
+	~Server_ArrowTarget();
+	const QSet<Server_Arrow *> &getRelatedArrows() const { return relatedArrows; }
+	void addRelatedArrow(Server_Arrow *arrow) { relatedArrows.insert(arrow); }
+	void removeRelatedArrow(Server_Arrow *arrow) { relatedArrows.remove(arrow); }
 };
 
-#endif
\ No newline at end of file
+#endif
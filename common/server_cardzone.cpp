@@ -20,7 +20,7 @@
 #include "server_cardzone.h"
 #include "server_card.h"
 #include "server_player.h"
-#include "rng_abstract.h"
+#include "rng_xoroshiro.h"
 #include <QSet>
 #include <QDebug>
 #include "server_game.h"
@@ -40,10 +40,7 @@ void Server_CardZone::shuffle()
 {
 	QMutexLocker locker(&player->getGame()->gameMutex);
 	
-	QList<Server_Card *> temp;
-	for (int i = cards.size(); i; i--)
-		temp.append(cards.takeAt(rng->getNumber(0, i - 1)));
-	cards = temp;
+	player->getGame()->getRNG()->shuffle(cards);
 }
 
 int Server_CardZone::removeCard(Server_Card *card)
@@ -52,6 +49,9 @@ int Server_CardZone::removeCard(Server_Card *card)
 	
 	int index = cards.indexOf(card);
 	cards.removeAt(index);
+	cardIndex.remove(card->getId());
+	if (has_coords)
+		coordIndex.remove(coordKey(card->getX(), card->getY()), card);
 	card->setZone(0);
 	
 	return index;
@@ -62,18 +62,10 @@ Server_Card *Server_CardZone::getCard(int id, int *position)
 	QMutexLocker locker(&player->getGame()->gameMutex);
 	
 	if (type != HiddenZone) {
-		QListIterator<Server_Card *> CardIterator(cards);
-		int i = 0;
-		while (CardIterator.hasNext()) {
-			Server_Card *tmp = CardIterator.next();
-			if (tmp->getId() == id) {
-				if (position)
-					*position = i;
-				return tmp;
-			}
-			i++;
-		}
-		return NULL;
+		Server_Card *tmp = cardIndex.value(id);
+		if (tmp && position)
+			*position = cards.indexOf(tmp);
+		return tmp;
 	} else {
 		if ((id >= cards.size()) || (id < 0))
 			return NULL;
@@ -88,33 +80,29 @@ int Server_CardZone::getFreeGridColumn(int x, int y, const QString &cardName) co
 {
 	QMutexLocker locker(&player->getGame()->gameMutex);
 	
-	QMap<int, Server_Card *> coordMap;
-	for (int i = 0; i < cards.size(); ++i)
-		if (cards[i]->getY() == y)
-			coordMap.insert(cards[i]->getX(), cards[i]);
-	
 	int resultX = 0;
 	if (x == -1) {
 		for (int i = 0; i < cards.size(); ++i)
 			if ((cards[i]->getName() == cardName) && !(cards[i]->getX() % 3) && (cards[i]->getY() == y)) {
 				if (!cards[i]->getAttachedCards().isEmpty())
 					continue;
-				if (!coordMap.value(cards[i]->getX() + 1))
+				if (!getCardAt(cards[i]->getX() + 1, y))
 					return cards[i]->getX() + 1;
-				if (!coordMap.value(cards[i]->getX() + 2))
+				if (!getCardAt(cards[i]->getX() + 2, y))
 					return cards[i]->getX() + 2;
 			}
 	} else if (x == -2) {
 	} else {
 		x = (x / 3) * 3;
-		if (!coordMap.contains(x))
+		Server_Card *baseCard = getCardAt(x, y);
+		if (!baseCard)
 			resultX = x;
-		else if (!coordMap.value(x)->getAttachedCards().isEmpty()) {
+		else if (!baseCard->getAttachedCards().isEmpty()) {
 			resultX = x;
 			x = -1;
-		} else if (!coordMap.contains(x + 1))
+		} else if (!getCardAt(x + 1, y))
 			resultX = x + 1;
-		else if (!coordMap.contains(x + 2))
+		else if (!getCardAt(x + 2, y))
 			resultX = x + 2;
 		else {
 			resultX = x;
@@ -123,7 +111,7 @@ int Server_CardZone::getFreeGridColumn(int x, int y, const QString &cardName) co
 	}
 	
 	if (x < 0)
-		while (coordMap.value(resultX))
+		while (getCardAt(resultX, y))
 			resultX += 3;
 
 	return resultX;
@@ -136,12 +124,7 @@ bool Server_CardZone::isColumnStacked(int x, int y) const
 	
 	QMutexLocker locker(&player->getGame()->gameMutex);
 	
-	QMap<int, Server_Card *> coordMap;
-	for (int i = 0; i < cards.size(); ++i)
-		if (cards[i]->getY() == y)
-			coordMap.insert(cards[i]->getX(), cards[i]);
-	
-	return coordMap.contains((x / 3) * 3 + 1);
+	return getCardAt((x / 3) * 3 + 1, y);
 }
 
 bool Server_CardZone::isColumnEmpty(int x, int y) const
@@ -151,55 +134,41 @@ bool Server_CardZone::isColumnEmpty(int x, int y) const
 	
 	QMutexLocker locker(&player->getGame()->gameMutex);
 	
-	QMap<int, Server_Card *> coordMap;
-	for (int i = 0; i < cards.size(); ++i)
-		if (cards[i]->getY() == y)
-			coordMap.insert(cards[i]->getX(), cards[i]);
-	
-	return !coordMap.contains((x / 3) * 3);
+	return !getCardAt((x / 3) * 3, y);
 }
 
-void Server_CardZone::moveCard(CommandContainer *cont, QMap<int, Server_Card *> &coordMap, Server_Card *card, int x, int y)
+void Server_CardZone::moveCard(CommandContainer *cont, Server_Card *card, int x, int y)
 {
-	QMutexLocker locker(&player->getGame()->gameMutex);
-	
-	coordMap.remove(card->getY() * 10000 + card->getX());
-	
 	CardToMove *cardToMove = new CardToMove(card->getId());
 	player->moveCard(cont, this, QList<CardToMove *>() << cardToMove, this, x, y, card->getFaceDown(), false);
 	delete cardToMove;
-	
-	coordMap.insert(y * 10000 + x, card);
 }
 
 void Server_CardZone::fixFreeSpaces(CommandContainer *cont)
 {
 	QMutexLocker locker(&player->getGame()->gameMutex);
 	
-	QMap<int, Server_Card *> coordMap;
-	QSet<int> placesToLook;
-	for (int i = 0; i < cards.size(); ++i) {
-		coordMap.insert(cards[i]->getY() * 10000 + cards[i]->getX(), cards[i]);
-		placesToLook.insert(cards[i]->getY() * 10000 + (cards[i]->getX() / 3) * 3);
-	}
+	QSet<QPair<int, int> > placesToLook;
+	for (int i = 0; i < cards.size(); ++i)
+		placesToLook.insert(coordKey((cards[i]->getX() / 3) * 3, cards[i]->getY()));
 	
-	QSetIterator<int> placeIterator(placesToLook);
+	QSetIterator<QPair<int, int> > placeIterator(placesToLook);
 	while (placeIterator.hasNext()) {
-		int foo = placeIterator.next();
-		int y = foo / 10000;
-		int baseX = foo - y * 10000;
+		const QPair<int, int> place = placeIterator.next();
+		int baseX = place.first;
+		int y = place.second;
 		
-		if (!coordMap.contains(y * 10000 + baseX)) {
-			if (coordMap.contains(y * 10000 + baseX + 1))
-				moveCard(cont, coordMap, coordMap.value(y * 10000 + baseX + 1), baseX, y);
-			else if (coordMap.contains(y * 10000 + baseX + 2)) {
-				moveCard(cont, coordMap, coordMap.value(y * 10000 + baseX + 2), baseX, y);
+		if (!getCardAt(baseX, y)) {
+			if (getCardAt(baseX + 1, y))
+				moveCard(cont, getCardAt(baseX + 1, y), baseX, y);
+			else if (getCardAt(baseX + 2, y)) {
+				moveCard(cont, getCardAt(baseX + 2, y), baseX, y);
 				continue;
 			} else
 				continue;
 		}
-		if (!coordMap.contains(y * 10000 + baseX + 1) && coordMap.contains(y * 10000 + baseX + 2))
-			moveCard(cont, coordMap, coordMap.value(y * 10000 + baseX + 2), baseX + 1, y);
+		if (!getCardAt(baseX + 1, y) && getCardAt(baseX + 2, y))
+			moveCard(cont, getCardAt(baseX + 2, y), baseX + 1, y);
 	}
 }
 
@@ -210,13 +179,28 @@ void Server_CardZone::insertCard(Server_Card *card, int x, int y)
 	if (hasCoords()) {
 		card->setCoords(x, y);
 		cards.append(card);
+		if (x >= 0)
+			coordIndex.insert(coordKey(x, y), card);
 	} else {
 		card->setCoords(0, 0);
 		cards.insert(x, card);
 	}
+	cardIndex.insert(card->getId(), card);
 	card->setZone(this);
 }
 
+void Server_CardZone::updateCardCoords(Server_Card *card, int x, int y)
+{
+	QMutexLocker locker(&player->getGame()->gameMutex);
+	
+	if (hasCoords()) {
+		coordIndex.remove(coordKey(card->getX(), card->getY()), card);
+		if (x >= 0)
+			coordIndex.insert(coordKey(x, y), card);
+	}
+	card->setCoords(x, y);
+}
+
 void Server_CardZone::clear()
 {
 	QMutexLocker locker(&player->getGame()->gameMutex);
@@ -224,4 +208,6 @@ void Server_CardZone::clear()
 	for (int i = 0; i < cards.size(); i++)
 		delete cards.at(i);
 	cards.clear();
+	cardIndex.clear();
+	coordIndex.clear();
 }
@@ -21,6 +21,8 @@
 #define SERVER_CARDZONE_H
 
 #include <QList>
+#include <QHash>
+#include <QPair>
 #include <QString>
 #include "protocol_datastructures.h"
 
@@ -36,6 +38,18 @@ private:
 	bool has_coords;
 	ZoneType type;
 	int cardsBeingLookedAt;
+	QList<Server_Card *> cards;
+	// Maps card ids to cards for constant time lookups. Must be kept in
+	// sync with the list, so cards are only added and removed through
+	// insertCard() and removeCard().
+	QHash<int, Server_Card *> cardIndex;
+	// Grid occupancy of zones with coordinates. The coordinates come from
+	// the clients, so cards may share a cell; the last one added is on top.
+	// Attached cards (x == -1) are not on the grid.
+	QMultiHash<QPair<int, int>, Server_Card *> coordIndex;
+	static QPair<int, int> coordKey(int x, int y) { return QPair<int, int>(x, y); }
+	Server_Card *getCardAt(int x, int y) const { return coordIndex.value(coordKey(x, y)); }
+	void moveCard(CommandContainer *cont, Server_Card *card, int x, int y);
 public:
 	Server_CardZone(Server_Player *_player, const QString &_name, bool _has_coords, ZoneType _type);
 	~Server_CardZone();
@@ -54,8 +68,8 @@ public:
 	bool isColumnEmpty(int x, int y) const;
 	bool isColumnStacked(int x, int y) const;
 	void fixFreeSpaces(CommandContainer *cont);
-	void moveCard(CommandContainer *cont, QMap<int, Server_Card *> &coordMap, Server_Card *card, int x, int y);
-	QList<Server_Card *> cards;
+	void updateCardCoords(Server_Card *card, int x, int y);
+	const QList<Server_Card *> &getCards() const { return cards; }
 	void insertCard(Server_Card *card, int x, int y);
 	void shuffle();
 	void clear();
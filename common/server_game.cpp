@@ -25,21 +25,18 @@
 #include "server_card.h"
 #include "server_cardzone.h"
 #include "server_counter.h"
-#include <QTimer>
+#include "rng_xoroshiro.h"
 #include <QDebug>
 
 Server_Game::Server_Game(Server_ProtocolHandler *_creator, int _gameId, const QString &_description, const QString &_password, int _maxPlayers, const QList<int> &_gameTypes, bool _onlyBuddies, bool _onlyRegistered, bool _spectatorsAllowed, bool _spectatorsNeedPassword, bool _spectatorsCanTalk, bool _spectatorsSeeEverything, Server_Room *_room)
-	: QObject(), room(_room), hostId(0), creatorInfo(new ServerInfo_User(_creator->getUserInfo())), gameStarted(false), gameId(_gameId), description(_description), password(_password), maxPlayers(_maxPlayers), gameTypes(_gameTypes), activePlayer(-1), activePhase(-1), onlyBuddies(_onlyBuddies), onlyRegistered(_onlyRegistered), spectatorsAllowed(_spectatorsAllowed), spectatorsNeedPassword(_spectatorsNeedPassword), spectatorsCanTalk(_spectatorsCanTalk), spectatorsSeeEverything(_spectatorsSeeEverything), inactivityCounter(0), secondsElapsed(0), gameMutex(QMutex::Recursive)
+	: QObject(), room(_room), hostId(0), creatorInfo(new ServerInfo_User(_creator->getUserInfo())), gameStarted(false), gameId(_gameId), description(_description), password(_password), maxPlayers(_maxPlayers), gameTypes(_gameTypes), activePlayer(-1), activePhase(-1), onlyBuddies(_onlyBuddies), onlyRegistered(_onlyRegistered), spectatorsAllowed(_spectatorsAllowed), spectatorsNeedPassword(_spectatorsNeedPassword), spectatorsCanTalk(_spectatorsCanTalk), spectatorsSeeEverything(_spectatorsSeeEverything), inactivityCounter(0), secondsElapsed(0), rng(new RNG_Xoroshiro(RNG_Xoroshiro::generateSeed(), this)), gameMutex(QMutex::Recursive)
 {
+	// Together with the command log, the seed makes every shuffle and die roll reproducible.
+	qDebug() << "Game" << gameId << "random seed:" << (quint64) rng->getSeed();
+	
 	connect(this, SIGNAL(sigStartGameIfReady()), this, SLOT(doStartGameIfReady()), Qt::QueuedConnection);
 	
 	addPlayer(_creator, false, false);
-
-	if (room->getServer()->getGameShouldPing()) {
-		pingClock = new QTimer(this);
-		connect(pingClock, SIGNAL(timeout()), this, SLOT(pingClockTimeout()));
-		pingClock->start(1000);
-	}
 }
 
 Server_Game::~Server_Game()
@@ -56,15 +53,75 @@ Server_Game::~Server_Game()
 	
 	room->removeGame(this);
 	delete creatorInfo;
+	
+	commandQueueMutex.lock();
+	for (int i = 0; i < commandQueue.size(); ++i)
+		if (commandQueue[i].cont->getReceiverMayDelete())
+			delete commandQueue[i].cont;
+	commandQueue.clear();
+	commandQueueMutex.unlock();
+	
 	qDebug() << "Server_Game destructor: gameId=" << gameId;
 }
 
+void Server_Game::moveToThread(QThread *thread)
+{
+	QObject::moveToThread(thread);
+	
+	QMapIterator<int, Server_Player *> playerIterator(players);
+	while (playerIterator.hasNext())
+		playerIterator.next().value()->moveToThread(thread);
+}
+
+void Server_Game::postCommandContainer(Server_ProtocolHandler *handler, int playerId, CommandContainer *cont)
+{
+	QueuedCommandContainer item;
+	item.handler = handler;
+	item.playerId = playerId;
+	item.cont = cont;
+	
+	QMutexLocker locker(&commandQueueMutex);
+	commandQueue.append(item);
+	if (commandQueue.size() == 1)
+		QMetaObject::invokeMethod(this, "processCommandQueue", Qt::QueuedConnection);
+}
+
+void Server_Game::processCommandQueue()
+{
+	forever {
+		commandQueueMutex.lock();
+		if (commandQueue.isEmpty()) {
+			commandQueueMutex.unlock();
+			break;
+		}
+		QueuedCommandContainer item = commandQueue.takeFirst();
+		commandQueueMutex.unlock();
+		
+		QMutexLocker locker(&gameMutex);
+		
+		// The handler may have disconnected while the container was queued.
+		// prepareDestroy() needs gameMutex to detach from the game, so the
+		// handler stays valid for as long as we hold the lock.
+		Server_Player *player = players.value(item.playerId, 0);
+		if (!player || (player->getProtocolHandler() != item.handler)) {
+			if (item.cont->getReceiverMayDelete())
+				delete item.cont;
+			continue;
+		}
+		item.handler->processGameCommandContainer(item.cont, this, player);
+	}
+}
+
 void Server_Game::pingClockTimeout()
 {
 	QMutexLocker locker(&gameMutex);
 	++secondsElapsed;
 	
-	QList<ServerInfo_PlayerPing *> pingList;
+	// Clients count the elapsed time themselves; resynchronize them now and then.
+	if (secondsElapsed % 60 == 0)
+		lastSentPingTimes.clear();
+	
+	QMap<int, int> pingTimes;
 	QMapIterator<int, Server_Player *> playerIterator(players);
 	bool allPlayersInactive = true;
 	int playerCount = 0;
@@ -74,14 +131,24 @@ void Server_Game::pingClockTimeout()
 			++playerCount;
 		int pingTime;
 		if (player->getProtocolHandler()) {
-			pingTime = player->getProtocolHandler()->getLastCommandTime();
+			// The client doesn't distinguish anything above this.
+			pingTime = qMin(player->getProtocolHandler()->getLastCommandTime(), maxReportedPingTime);
 			if (!player->getSpectator())
 				allPlayersInactive = false;
 		} else
 			pingTime = -1;
-		pingList.append(new ServerInfo_PlayerPing(player->getPlayerId(), pingTime));
+		pingTimes.insert(player->getPlayerId(), pingTime);
+	}
+	if (pingTimes != lastSentPingTimes) {
+		QList<ServerInfo_PlayerPing *> pingList;
+		QMapIterator<int, int> pingIterator(pingTimes);
+		while (pingIterator.hasNext()) {
+			pingIterator.next();
+			pingList.append(new ServerInfo_PlayerPing(pingIterator.key(), pingIterator.value()));
+		}
+		sendGameEvent(new Event_Ping(secondsElapsed, pingList));
+		lastSentPingTimes = pingTimes;
 	}
-	sendGameEvent(new Event_Ping(secondsElapsed, pingList));
 	
 	const int maxTime = room->getServer()->getMaxGameInactivityTime();
 	if (allPlayersInactive) {
@@ -238,7 +305,7 @@ bool Server_Game::containsUser(const QString &userName) const
 	return false;
 }
 
-Server_Player *Server_Game::addPlayer(Server_ProtocolHandler *handler, bool spectator, bool broadcastUpdate)
+Server_Player *Server_Game::addPlayer(Server_ProtocolHandler *handler, bool spectator, bool broadcastUpdate, QList<QSharedPointer<EncodedProtocolItem> > *joinState)
 {
 	QMutexLocker locker(&gameMutex);
 	
@@ -247,7 +314,22 @@ Server_Player *Server_Game::addPlayer(Server_ProtocolHandler *handler, bool spec
 	
 	Server_Player *newPlayer = new Server_Player(this, playerId, handler->getUserInfo(), spectator, handler);
 	newPlayer->moveToThread(thread());
-	sendGameEvent(new Event_Join(newPlayer->getProperties()));
+	
+	// The new player gets the state from before it joined, followed by its own
+	// Event_Join, so that the cached state stays valid for the next one.
+	// Joins handed out with a snapshot are marked as state replay, so that
+	// clients don't announce them again.
+	if (joinState)
+		*joinState = getGameStateItems(newPlayer);
+	EncodedProtocolItem joinItem(GameEventContainer::makeNew(new Event_Join(newPlayer->getProperties()), gameId), true);
+	QMapIterator<int, Server_Player *> playerIterator(players);
+	while (playerIterator.hasNext())
+		playerIterator.next().value()->sendEncodedItem(joinItem);
+	QSharedPointer<EncodedProtocolItem> replayItem(new EncodedProtocolItem(new GameEventContainer(QList<GameEvent *>() << new Event_Join(newPlayer->getProperties()), gameId, new Context_StateReplay), true));
+	gameStateCache.addJoin(replayItem);
+	if (joinState)
+		joinState->append(replayItem);
+	
 	players.insert(playerId, newPlayer);
 	if (newPlayer->getUserInfo()->getName() == creatorInfo->getName()) {
 		hostId = playerId;
@@ -262,7 +344,6 @@ Server_Player *Server_Game::addPlayer(Server_ProtocolHandler *handler, bool spec
 
 void Server_Game::removePlayer(Server_Player *player)
 {
-	QMutexLocker roomLocker(&room->roomMutex);
 	QMutexLocker locker(&gameMutex);
 	
 	players.remove(player->getPlayerId());
@@ -306,34 +387,25 @@ void Server_Game::removeArrowsRelatedToPlayer(Server_Player *player)
 	// Remove all arrows of other players pointing to the player being removed or to one of his cards.
 	// Also remove all arrows starting at one of his cards. This is necessary since players can create
 	// arrows that start at another person's cards.
-	QMapIterator<int, Server_Player *> playerIterator(players);
-	while (playerIterator.hasNext()) {
-		Server_Player *p = playerIterator.next().value();
-		QList<Server_Arrow *> arrows = p->getArrows().values();
-		QList<Server_Arrow *> toDelete;
-		for (int i = 0; i < arrows.size(); ++i) {
-			Server_Arrow *a = arrows[i];
-			Server_Card *targetCard = qobject_cast<Server_Card *>(a->getTargetItem());
-			if (targetCard) {
-				if (targetCard->getZone()->getPlayer() == player)
-					toDelete.append(a);
-			} else if (static_cast<Server_Player *>(a->getTargetItem()) == player)
-				toDelete.append(a);
-			
-			// Don't use else here! It has to happen regardless of whether targetCard == 0.
-			if (a->getStartCard()->getZone()->getPlayer() == player)
-				toDelete.append(a);
-		}
-		for (int i = 0; i < toDelete.size(); ++i) {
-			sendGameEvent(new Event_DeleteArrow(p->getPlayerId(), toDelete[i]->getId()));
-			p->deleteArrow(toDelete[i]->getId());
-		}
+	QSet<Server_Arrow *> toDelete = player->getRelatedArrows();
+	QMapIterator<QString, Server_CardZone *> zoneIterator(player->getZones());
+	while (zoneIterator.hasNext()) {
+		const QList<Server_Card *> &cards = zoneIterator.next().value()->getCards();
+		for (int i = 0; i < cards.size(); ++i)
+			toDelete.unite(cards[i]->getRelatedArrows());
+	}
+	
+	QSetIterator<Server_Arrow *> arrowIterator(toDelete);
+	while (arrowIterator.hasNext()) {
+		Server_Arrow *a = arrowIterator.next();
+		Server_Player *p = a->getPlayer();
+		sendGameEvent(new Event_DeleteArrow(p->getPlayerId(), a->getId()));
+		p->deleteArrow(a->getId());
 	}
 }
 
 bool Server_Game::kickPlayer(int playerId)
 {
-	QMutexLocker roomLocker(&room->roomMutex);
 	QMutexLocker locker(&gameMutex);
 	
 	Server_Player *playerToKick = players.value(playerId);
@@ -452,7 +524,7 @@ QList<ServerInfo_Player *> Server_Game::getGameState(Server_Player *playerWhosAs
 				(((playerWhosAsking == player) || (playerWhosAsking->getSpectator() && spectatorsSeeEverything)) && (zone->getType() != HiddenZone))
 				|| ((playerWhosAsking != player) && (zone->getType() == PublicZone))
 			) {
-				QListIterator<Server_Card *> cardIterator(zone->cards);
+				QListIterator<Server_Card *> cardIterator(zone->getCards());
 				while (cardIterator.hasNext()) {
 					Server_Card *card = cardIterator.next();
 					QString displayedName = card->getFaceDown() ? QString() : card->getName();
@@ -475,7 +547,7 @@ QList<ServerInfo_Player *> Server_Game::getGameState(Server_Player *playerWhosAs
 					cardList.append(new ServerInfo_Card(card->getId(), displayedName, card->getX(), card->getY(), card->getFaceDown(), card->getTapped(), card->getAttacking(), card->getColor(), card->getPT(), card->getAnnotation(), card->getDestroyOnZoneChange(), card->getDoesntUntap(), cardCounterList, attachPlayerId, attachZone, attachCardId));
 				}
 			}
-			zoneList.append(new ServerInfo_Zone(zone->getName(), zone->getType(), zone->hasCoords(), zone->cards.size(), cardList));
+			zoneList.append(new ServerInfo_Zone(zone->getName(), zone->getType(), zone->hasCoords(), zone->getCards().size(), cardList));
 		}
 
 		result.append(new ServerInfo_Player(player->getProperties(), player == playerWhosAsking ? player->getDeck() : 0, zoneList, counterList, arrowList));
@@ -483,43 +555,106 @@ QList<ServerInfo_Player *> Server_Game::getGameState(Server_Player *playerWhosAs
 	return result;
 }
 
+int Server_Game::getVisibilityKey(Server_Player *player) const
+{
+	// Spectators never have a deck or zones, so all of them in one class see the same state.
+	if (!player->getSpectator())
+		return player->getPlayerId();
+	return spectatorsSeeEverything ? -1 : -2;
+}
+
+QList<QSharedPointer<EncodedProtocolItem> > Server_Game::getGameStateItems(Server_Player *playerWhosAsking)
+{
+	QMutexLocker locker(&gameMutex);
+	
+	const int key = getVisibilityKey(playerWhosAsking);
+	QList<QSharedPointer<EncodedProtocolItem> > result = gameStateCache.getItems(key);
+	if (!result.isEmpty())
+		return result;
+	
+	QSharedPointer<EncodedProtocolItem> snapshot(new EncodedProtocolItem(GameEventContainer::makeNew(new Event_GameStateChanged(gameStarted, activePlayer, activePhase, getGameState(playerWhosAsking)), gameId), true));
+	gameStateCache.insert(key, snapshot);
+	result.append(snapshot);
+	return result;
+}
+
+void Server_Game::gameStateChanged()
+{
+	QMutexLocker locker(&gameMutex);
+	
+	gameStateCache.invalidate();
+}
+
 void Server_Game::sendGameEvent(GameEvent *event, GameEventContext *context, Server_Player *exclude)
 {
 	sendGameEventContainer(new GameEventContainer(QList<GameEvent *>() << event, -1, context), exclude);
 }
 
-void Server_Game::sendGameEventContainer(GameEventContainer *cont, Server_Player *exclude, bool excludeOmniscient)
+void Server_Game::sendGameEventContainer(GameEventContainer *cont, Server_Player *exclude)
 {
 	QMutexLocker locker(&gameMutex);
 	
+	// Every state change is announced by an event. Pings and chat messages
+	// are the frequent ones that don't change anything.
+	const QList<GameEvent *> &eventList = cont->getEventList();
+	for (int i = 0; i < eventList.size(); ++i)
+		if (!qobject_cast<Event_Ping *>(eventList[i]) && !qobject_cast<Event_Say *>(eventList[i])) {
+			gameStateCache.invalidate();
+			break;
+		}
+	
 	cont->setGameId(gameId);
+	EncodedProtocolItem encodedCont(cont);
 	QMapIterator<int, Server_Player *> playerIterator(players);
 	while (playerIterator.hasNext()) {
 		Server_Player *p = playerIterator.next().value();
-		if ((p != exclude) && !(excludeOmniscient && p->getSpectator() && spectatorsSeeEverything))
-			p->sendProtocolItem(cont, false);
+		if (p != exclude)
+			p->sendEncodedItem(encodedCont);
 	}
 
 	delete cont;
 }
 
-void Server_Game::sendGameEventContainerOmniscient(GameEventContainer *cont, Server_Player *exclude)
+void Server_Game::sendGameEventQueue(CommandContainer *cont, Server_Player *privatePlayer)
 {
 	QMutexLocker locker(&gameMutex);
 	
-	cont->setGameId(gameId);
+	gameStateCache.invalidate();
+	
+	// Build and encode every audience's container at most once.
+	GameEventContainer *privateCont = privatePlayer ? cont->makeGameEventContainer(AudiencePrivate) : 0;
+	GameEventContainer *omniscientCont = spectatorsSeeEverything ? cont->makeGameEventContainer(AudienceOmniscient) : 0;
+	GameEventContainer *publicCont = cont->makeGameEventContainer(AudiencePublic);
+	EncodedProtocolItem encodedPrivate(privateCont);
+	EncodedProtocolItem encodedOmniscient(omniscientCont);
+	EncodedProtocolItem encodedPublic(publicCont);
+	
 	QMapIterator<int, Server_Player *> playerIterator(players);
 	while (playerIterator.hasNext()) {
 		Server_Player *p = playerIterator.next().value();
-		if ((p != exclude) && (p->getSpectator() && spectatorsSeeEverything))
-			p->sendProtocolItem(cont, false);
+		EncodedProtocolItem *item;
+		if (p == privatePlayer)
+			item = &encodedPrivate;
+		else if (p->getSpectator() && spectatorsSeeEverything)
+			item = &encodedOmniscient;
+		else
+			item = &encodedPublic;
+		if (item->getItem())
+			p->sendEncodedItem(*item);
 	}
 	
-	delete cont;
+	// The events still belong to the command container.
+	GameEventContainer *containers[] = {privateCont, omniscientCont, publicCont};
+	for (int i = 0; i < 3; ++i)
+		if (containers[i]) {
+			containers[i]->releaseItems();
+			delete containers[i];
+		}
 }
 
 void Server_Game::sendGameEventToPlayer(Server_Player *player, GameEvent *event)
 {
+	gameStateChanged();
 	player->sendProtocolItem(new GameEventContainer(QList<GameEvent *>() << event, gameId));
 }
 
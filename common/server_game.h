@@ -24,12 +24,15 @@
 #include <QPointer>
 #include <QObject>
 #include <QMutex>
+#include <QSharedPointer>
 #include "server_player.h"
 #include "protocol.h"
+#include "server_gamestatecache.h"
 
-class QTimer;
+class QThread;
 class Server_Room;
 class ServerInfo_User;
+class RNG_Xoroshiro;
 
 class Server_Game : public QObject {
 	Q_OBJECT
@@ -50,18 +53,41 @@ private:
 	bool spectatorsNeedPassword;
 	bool spectatorsCanTalk;
 	bool spectatorsSeeEverything;
+	static const int maxReportedPingTime = 10;
 	int inactivityCounter;
 	int secondsElapsed;
-	QTimer *pingClock;
+	// The ping times last sent to the clients, keyed by player id. Event_Ping is
+	// only sent when they change; an empty map forces the next one out.
+	QMap<int, int> lastSentPingTimes;
+	// Only used by this game's thread, so it needs no locking.
+	RNG_Xoroshiro *rng;
+	
+	// Command containers waiting to be processed in the thread owning this game
+	struct QueuedCommandContainer {
+		Server_ProtocolHandler *handler;
+		int playerId;
+		CommandContainer *cont;
+	};
+	QMutex commandQueueMutex;
+	QList<QueuedCommandContainer> commandQueue;
+	
+	// Keyed by the player id for players, -1 for omniscient and -2 for other spectators.
+	Server_GameStateCache gameStateCache;
+	int getVisibilityKey(Server_Player *player) const;
 signals:
 	void sigStartGameIfReady();
 private slots:
-	void pingClockTimeout();
 	void doStartGameIfReady();
+	void processCommandQueue();
+public slots:
+	// Invoked once a second by the server, queued to the thread owning this game.
+	void pingClockTimeout();
 public:
 	mutable QMutex gameMutex;
 	Server_Game(Server_ProtocolHandler *_creator, int _gameId, const QString &_description, const QString &_password, int _maxPlayers, const QList<int> &_gameTypes, bool _onlyBuddies, bool _onlyRegistered, bool _spectatorsAllowed, bool _spectatorsNeedPassword, bool _spectatorsCanTalk, bool _spectatorsSeeEverything, Server_Room *parent);
 	~Server_Game();
+	void moveToThread(QThread *thread);
+	void postCommandContainer(Server_ProtocolHandler *handler, int playerId, CommandContainer *cont);
 	ServerInfo_Game *getInfo() const;
 	int getHostId() const { return hostId; }
 	ServerInfo_User *getCreatorInfo() const { return creatorInfo; }
@@ -71,6 +97,7 @@ public:
 	const QMap<int, Server_Player *> &getPlayers() const { return players; }
 	Server_Player *getPlayer(int playerId) const { return players.value(playerId, 0); }
 	int getGameId() const { return gameId; }
+	RNG_Xoroshiro *getRNG() const { return rng; }
 	QString getDescription() const { return description; }
 	QString getPassword() const { return password; }
 	int getMaxPlayers() const { return maxPlayers; }
@@ -80,7 +107,8 @@ public:
 	bool getSpectatorsSeeEverything() const { return spectatorsSeeEverything; }
 	ResponseCode checkJoin(ServerInfo_User *user, const QString &_password, bool spectator, bool overrideRestrictions);
 	bool containsUser(const QString &userName) const;
-	Server_Player *addPlayer(Server_ProtocolHandler *handler, bool spectator, bool broadcastUpdate = true);
+	// If joinState is given, it receives the game state items for the new player.
+	Server_Player *addPlayer(Server_ProtocolHandler *handler, bool spectator, bool broadcastUpdate = true, QList<QSharedPointer<EncodedProtocolItem> > *joinState = 0);
 	void removePlayer(Server_Player *player);
 	void removeArrowsRelatedToPlayer(Server_Player *player);
 	bool kickPlayer(int playerId);
@@ -94,9 +122,12 @@ public:
 	void postConnectionStatusUpdate(Server_Player *player, bool connectionStatus);
 
 	QList<ServerInfo_Player *> getGameState(Server_Player *playerWhosAsking) const;
+	// The cached Event_GameStateChanged container, followed by the joins since it was built.
+	QList<QSharedPointer<EncodedProtocolItem> > getGameStateItems(Server_Player *playerWhosAsking);
+	void gameStateChanged();
 	void sendGameEvent(GameEvent *event, GameEventContext *context = 0, Server_Player *exclude = 0);
-	void sendGameEventContainer(GameEventContainer *cont, Server_Player *exclude = 0, bool excludeOmniscient = false);
-	void sendGameEventContainerOmniscient(GameEventContainer *cont, Server_Player *exclude = 0);
+	void sendGameEventContainer(GameEventContainer *cont, Server_Player *exclude = 0);
+	void sendGameEventQueue(CommandContainer *cont, Server_Player *privatePlayer);
 	void sendGameEventToPlayer(Server_Player *player, GameEvent *event);
 };
 
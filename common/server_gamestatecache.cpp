@@ -0,0 +1,34 @@
+#include "server_gamestatecache.h"
+#include "protocol.h"
+
+void Server_GameStateCache::invalidate()
+{
+	entries.clear();
+	joins.clear();
+}
+
+void Server_GameStateCache::addJoin(const QSharedPointer<EncodedProtocolItem> &joinItem)
+{
+	joins.append(joinItem);
+}
+
+QList<QSharedPointer<EncodedProtocolItem> > Server_GameStateCache::getItems(int key) const
+{
+	QList<QSharedPointer<EncodedProtocolItem> > result;
+	QMap<int, Entry>::const_iterator it = entries.constFind(key);
+	if (it == entries.constEnd())
+		return result;
+	
+	result.append(it.value().snapshot);
+	for (int i = it.value().joinCount; i < joins.size(); ++i)
+		result.append(joins[i]);
+	return result;
+}
+
+void Server_GameStateCache::insert(int key, const QSharedPointer<EncodedProtocolItem> &snapshot)
+{
+	Entry entry;
+	entry.joinCount = joins.size();
+	entry.snapshot = snapshot;
+	entries.insert(key, entry);
+}
@@ -0,0 +1,33 @@
+#ifndef SERVER_GAMESTATECACHE_H
+#define SERVER_GAMESTATECACHE_H
+
+#include <QMap>
+#include <QList>
+#include <QSharedPointer>
+
+class EncodedProtocolItem;
+
+// Encoded Event_GameStateChanged containers of one game, keyed by what the
+// viewer may see. Joins don't invalidate the snapshots: the Event_Join
+// containers sent since a snapshot was built are handed out after it, so a
+// stream of joining spectators shares one snapshot.
+// Not thread-safe.
+class Server_GameStateCache {
+private:
+	struct Entry {
+		int joinCount;
+		QSharedPointer<EncodedProtocolItem> snapshot;
+	};
+	QMap<int, Entry> entries;
+	QList<QSharedPointer<EncodedProtocolItem> > joins;
+public:
+	// Drops all snapshots, to be called whenever the game state changes.
+	void invalidate();
+	void addJoin(const QSharedPointer<EncodedProtocolItem> &joinItem);
+	// Returns the snapshot followed by the joins since, or an empty list.
+	QList<QSharedPointer<EncodedProtocolItem> > getItems(int key) const;
+	// The snapshot has to reflect the players of all joins added so far.
+	void insert(int key, const QSharedPointer<EncodedProtocolItem> &snapshot);
+};
+
+#endif
@@ -127,7 +127,7 @@ void Server_Player::setupZones()
 			if (!currentCard)
 				continue;
 			for (int k = 0; k < currentCard->getNumber(); ++k)
-				z->cards.append(new Server_Card(currentCard->getName(), nextCardId++, 0, 0, z));
+				z->insertCard(new Server_Card(currentCard->getName(), nextCardId++, 0, 0, z), z->getCards().size(), 0);
 		}
 	}
 	
@@ -149,11 +149,12 @@ void Server_Player::setupZones()
 		else
 			continue;
 		
-		for (int j = 0; j < start->cards.size(); ++j)
-			if (start->cards[j]->getName() == m->getCardName()) {
-				Server_Card *card = start->cards[j];
-				start->cards.removeAt(j);
-				target->cards.append(card);
+		const QList<Server_Card *> &startCards = start->getCards();
+		for (int j = 0; j < startCards.size(); ++j)
+			if (startCards[j]->getName() == m->getCardName()) {
+				Server_Card *card = startCards[j];
+				start->removeCard(card);
+				target->insertCard(card, target->getCards().size(), 0);
 				break;
 			}
 	}
@@ -165,6 +166,11 @@ void Server_Player::clearZones()
 {
 	QMutexLocker locker(&game->gameMutex);
 	
+	QMapIterator<int, Server_Arrow *> arrowIterator(arrows);
+	while (arrowIterator.hasNext())
+		delete arrowIterator.next().value();
+	arrows.clear();
+	
 	QMapIterator<QString, Server_CardZone *> zoneIterator(zones);
 	while (zoneIterator.hasNext())
 		delete zoneIterator.next().value();
@@ -174,11 +180,6 @@ void Server_Player::clearZones()
 	while (counterIterator.hasNext())
 		delete counterIterator.next().value();
 	counters.clear();
-	
-	QMapIterator<int, Server_Arrow *> arrowIterator(arrows);
-	while (arrowIterator.hasNext())
-		delete arrowIterator.next().value();
-	arrows.clear();
 
 	lastDrawList.clear();
 }
@@ -249,21 +250,19 @@ ResponseCode Server_Player::drawCards(CommandContainer *cont, int number)
 	
 	Server_CardZone *deckZone = zones.value("deck");
 	Server_CardZone *handZone = zones.value("hand");
-	if (deckZone->cards.size() < number)
-		number = deckZone->cards.size();
+	if (deckZone->getCards().size() < number)
+		number = deckZone->getCards().size();
 
-	QList<ServerInfo_Card *> cardListPrivate;
-	QList<ServerInfo_Card *> cardListOmniscient;
+	QList<ServerInfo_Card *> cardList;
 	for (int i = 0; i < number; ++i) {
-		Server_Card *card = deckZone->cards.takeFirst();
-		handZone->cards.append(card);
+		Server_Card *card = deckZone->getCards().first();
+		deckZone->removeCard(card);
+		handZone->insertCard(card, handZone->getCards().size(), 0);
 		lastDrawList.append(card->getId());
-		cardListPrivate.append(new ServerInfo_Card(card->getId(), card->getName()));
-		cardListOmniscient.append(new ServerInfo_Card(card->getId(), card->getName()));
+		cardList.append(new ServerInfo_Card(card->getId(), card->getName()));
 	}
-	cont->enqueueGameEventPrivate(new Event_DrawCards(playerId, cardListPrivate.size(), cardListPrivate), game->getGameId());
-	cont->enqueueGameEventOmniscient(new Event_DrawCards(playerId, cardListOmniscient.size(), cardListOmniscient), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_DrawCards(playerId, cardListPrivate.size()), game->getGameId());
+	cont->enqueueGameEvent(new Event_DrawCards(playerId, cardList.size(), cardList), game->getGameId(), AudiencePrivate | AudienceOmniscient);
+	cont->enqueueGameEvent(new Event_DrawCards(playerId, cardList.size()), game->getGameId(), AudiencePublic);
 
 	return RespOk;
 }
@@ -327,7 +326,7 @@ ResponseCode Server_Player::moveCard(CommandContainer *cont, Server_CardZone *st
 		return RespContextError;
 	
 	if (!targetzone->hasCoords() && (x == -1))
-		x = targetzone->cards.size();
+		x = targetzone->getCards().size();
 	
 	QList<QPair<Server_Card *, int> > cardsToMove;
 	QMap<Server_Card *, CardToMove *> cardProperties;
@@ -391,24 +390,13 @@ ResponseCode Server_Player::moveCard(CommandContainer *cont, Server_CardZone *st
 		
 		if (startzone != targetzone) {
 			// Delete all arrows from and to the card
-			const QList<Server_Player *> &players = game->getPlayers().values();
-			for (int i = 0; i < players.size(); ++i) {
-				QList<int> arrowsToDelete;
-				QMapIterator<int, Server_Arrow *> arrowIterator(players[i]->getArrows());
-				while (arrowIterator.hasNext()) {
-					Server_Arrow *arrow = arrowIterator.next().value();
-					if ((arrow->getStartCard() == card) || (arrow->getTargetItem() == card))
-						arrowsToDelete.append(arrow->getId());
-				}
-				for (int j = 0; j < arrowsToDelete.size(); ++j)
-					players[i]->deleteArrow(arrowsToDelete[j]);
-			}
+			const QList<Server_Arrow *> arrowsToDelete = card->getRelatedArrows().toList();
+			for (int i = 0; i < arrowsToDelete.size(); ++i)
+				arrowsToDelete[i]->getPlayer()->deleteArrow(arrowsToDelete[i]->getId());
 		}
 		
 		if (card->getDestroyOnZoneChange() && (startzone->getName() != targetzone->getName())) {
-			cont->enqueueGameEventPrivate(new Event_DestroyCard(getPlayerId(), startzone->getName(), card->getId()), game->getGameId(), -1, new Context_MoveCard);
-			cont->enqueueGameEventOmniscient(new Event_DestroyCard(getPlayerId(), startzone->getName(), card->getId()), game->getGameId(), new Context_MoveCard);
-			cont->enqueueGameEventPublic(new Event_DestroyCard(getPlayerId(), startzone->getName(), card->getId()), game->getGameId(), new Context_MoveCard);
+			cont->enqueueGameEvent(new Event_DestroyCard(getPlayerId(), startzone->getName(), card->getId()), game->getGameId(), AudienceAll, new Context_MoveCard);
 			card->deleteLater();
 		} else {
 			if (!targetzone->hasCoords()) {
@@ -417,6 +405,10 @@ ResponseCode Server_Player::moveCard(CommandContainer *cont, Server_CardZone *st
 			} else
 				newX = targetzone->getFreeGridColumn(newX, y, card->getName());
 		
+			// The card must have its final id before it enters the target zone's index.
+			int oldCardId = card->getId();
+			if (thisCardProperties->getFaceDown() || (targetzone->getPlayer() != startzone->getPlayer()))
+				card->setId(targetzone->getPlayer()->newCardId());
 			targetzone->insertCard(card, newX, y);
 		
 			bool targetBeingLookedAt = (targetzone->getType() != HiddenZone) || (targetzone->getCardsBeingLookedAt() > newX) || (targetzone->getCardsBeingLookedAt() == -1);
@@ -433,9 +425,6 @@ ResponseCode Server_Player::moveCard(CommandContainer *cont, Server_CardZone *st
 			if (!(sourceHiddenToOthers && targetHiddenToOthers))
 				publicCardName = card->getName();
 		
-			int oldCardId = card->getId();
-			if (thisCardProperties->getFaceDown() || (targetzone->getPlayer() != startzone->getPlayer()))
-				card->setId(targetzone->getPlayer()->newCardId());
 			card->setFaceDown(thisCardProperties->getFaceDown());
 		
 			// The player does not get to see which card he moved if it moves between two parts of hidden zones which
@@ -450,8 +439,8 @@ ResponseCode Server_Player::moveCard(CommandContainer *cont, Server_CardZone *st
 			int privatePosition = -1;
 			if (startzone->getType() == HiddenZone)
 				privatePosition = position;
-			cont->enqueueGameEventPrivate(new Event_MoveCard(getPlayerId(), privateOldCardId, privateCardName, startzone->getName(), privatePosition, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, privateNewCardId, thisCardProperties->getFaceDown()), game->getGameId(), -1, undoingDraw ? static_cast<GameEventContext *>(new Context_UndoDraw) : static_cast<GameEventContext *>(new Context_MoveCard));
-			cont->enqueueGameEventOmniscient(new Event_MoveCard(getPlayerId(), privateOldCardId, privateCardName, startzone->getName(), privatePosition, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, privateNewCardId, thisCardProperties->getFaceDown()), game->getGameId(), undoingDraw ? static_cast<GameEventContext *>(new Context_UndoDraw) : static_cast<GameEventContext *>(new Context_MoveCard));
+			GameEventContext *context = undoingDraw ? static_cast<GameEventContext *>(new Context_UndoDraw) : static_cast<GameEventContext *>(new Context_MoveCard);
+			cont->enqueueGameEvent(new Event_MoveCard(getPlayerId(), privateOldCardId, privateCardName, startzone->getName(), privatePosition, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, privateNewCardId, thisCardProperties->getFaceDown()), game->getGameId(), AudiencePrivate | AudienceOmniscient, context);
 			
 			// Other players do not get to see the start and/or target position of the card if the respective
 			// part of the zone is being looked at. The information is not needed anyway because in hidden zones,
@@ -465,9 +454,9 @@ ResponseCode Server_Player::moveCard(CommandContainer *cont, Server_CardZone *st
 				newX = -1;
 		
 			if ((startzone->getType() == PublicZone) || (targetzone->getType() == PublicZone))
-				cont->enqueueGameEventPublic(new Event_MoveCard(getPlayerId(), oldCardId, publicCardName, startzone->getName(), position, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, card->getId(), thisCardProperties->getFaceDown()), game->getGameId(), undoingDraw ? static_cast<GameEventContext *>(new Context_UndoDraw) : static_cast<GameEventContext *>(new Context_MoveCard));
+				cont->enqueueGameEvent(new Event_MoveCard(getPlayerId(), oldCardId, publicCardName, startzone->getName(), position, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, card->getId(), thisCardProperties->getFaceDown()), game->getGameId(), AudiencePublic);
 			else
-				cont->enqueueGameEventPublic(new Event_MoveCard(getPlayerId(), -1, QString(), startzone->getName(), position, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, -1, false), game->getGameId(), undoingDraw ? static_cast<GameEventContext *>(new Context_UndoDraw) : static_cast<GameEventContext *>(new Context_MoveCard));
+				cont->enqueueGameEvent(new Event_MoveCard(getPlayerId(), -1, QString(), startzone->getName(), position, targetzone->getPlayer()->getPlayerId(), targetzone->getName(), newX, y, -1, false), game->getGameId(), AudiencePublic);
 			
 			if (thisCardProperties->getTapped())
 				setCardAttrHelper(cont, targetzone->getName(), card->getId(), "tapped", "1");
@@ -488,8 +477,7 @@ void Server_Player::unattachCard(CommandContainer *cont, Server_Card *card)
 	Server_CardZone *zone = card->getZone();
 	
 	card->setParentCard(0);
-	cont->enqueueGameEventPrivate(new Event_AttachCard(getPlayerId(), zone->getName(), card->getId(), -1, QString(), -1), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_AttachCard(getPlayerId(), zone->getName(), card->getId(), -1, QString(), -1), game->getGameId());
+	cont->enqueueGameEvent(new Event_AttachCard(getPlayerId(), zone->getName(), card->getId(), -1, QString(), -1), game->getGameId());
 	
 	CardToMove *cardToMove = new CardToMove(card->getId());
 	moveCard(cont, zone, QList<CardToMove *>() << cardToMove, zone, -1, card->getY(), card->getFaceDown());
@@ -508,7 +496,7 @@ ResponseCode Server_Player::setCardAttrHelper(CommandContainer *cont, const QStr
 
 	QString result;
 	if (cardId == -1) {
-		QListIterator<Server_Card *> CardIterator(zone->cards);
+		QListIterator<Server_Card *> CardIterator(zone->getCards());
 		while (CardIterator.hasNext()) {
 			result = CardIterator.next()->setAttribute(attrName, attrValue, true);
 			if (result.isNull())
@@ -522,9 +510,7 @@ ResponseCode Server_Player::setCardAttrHelper(CommandContainer *cont, const QStr
 		if (result.isNull())
 			return RespInvalidCommand;
 	}
-	cont->enqueueGameEventPrivate(new Event_SetCardAttr(getPlayerId(), zone->getName(), cardId, attrName, result), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_SetCardAttr(getPlayerId(), zone->getName(), cardId, attrName, result), game->getGameId());
-	cont->enqueueGameEventOmniscient(new Event_SetCardAttr(getPlayerId(), zone->getName(), cardId, attrName, result), game->getGameId());
+	cont->enqueueGameEvent(new Event_SetCardAttr(getPlayerId(), zone->getName(), cardId, attrName, result), game->getGameId());
 	return RespOk;
 }
 
@@ -535,3 +521,11 @@ void Server_Player::sendProtocolItem(ProtocolItem *item, bool deleteItem)
 	if (handler)
 		handler->sendProtocolItem(item, deleteItem);
 }
+
+void Server_Player::sendEncodedItem(EncodedProtocolItem &item)
+{
+	QMutexLocker locker(&playerMutex);
+	
+	if (handler)
+		handler->sendEncodedItem(item);
+}
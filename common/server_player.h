@@ -16,6 +16,7 @@ class Server_Arrow;
 class Server_Card;
 class Server_ProtocolHandler;
 class ProtocolItem;
+class EncodedProtocolItem;
 class ServerInfo_User;
 class ServerInfo_PlayerProperties;
 class CommandContainer;
@@ -87,6 +88,7 @@ public:
 	ResponseCode setCardAttrHelper(CommandContainer *cont, const QString &zone, int cardId, const QString &attrName, const QString &attrValue);
 
 	void sendProtocolItem(ProtocolItem *item, bool deleteItem = true);
+	void sendEncodedItem(EncodedProtocolItem &item);
 };
 
 #endif
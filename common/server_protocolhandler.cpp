@@ -1,5 +1,5 @@
 #include <QDebug>
-#include "rng_abstract.h"
+#include "rng_xoroshiro.h"
 #include "server_protocolhandler.h"
 #include "protocol.h"
 #include "protocol_items.h"
@@ -12,11 +12,11 @@
 #include "server_player.h"
 #include "decklist.h"
 #include <QDateTime>
+#include <QThread>
 
 Server_ProtocolHandler::Server_ProtocolHandler(Server *_server, QObject *parent)
-	: QObject(parent), server(_server), authState(PasswordWrong), acceptsUserListChanges(false), acceptsRoomListChanges(false), userInfo(0), sessionId(-1), timeRunning(0), lastDataReceived(0), gameListMutex(QMutex::Recursive)
+	: QObject(parent), server(_server), authState(PasswordWrong), acceptsUserListChanges(false), acceptsRoomListChanges(false), userInfo(0), sessionId(-1), messageSizeLimiter(_server->getMessageCountingInterval()), messageCountLimiter(_server->getMessageCountingInterval()), lastDataReceived(_server->getTickCount()), gameListMutex(QMutex::Recursive)
 {
-	connect(server, SIGNAL(pingClockTimeout()), this, SLOT(pingClockTimeout()));
 }
 
 Server_ProtocolHandler::~Server_ProtocolHandler()
@@ -37,12 +37,18 @@ void Server_ProtocolHandler::prepareDestroy()
 	while (roomIterator.hasNext())
 		roomIterator.next().value()->removeClient(this);
 	
+	// The games call back into playerRemovedFromGame(), so work on a copy
+	// of the ids and look every game up again when locking it.
 	gameListMutex.lock();
-	QMapIterator<int, QPair<Server_Game *, Server_Player *> > gameIterator(games);
-	while (gameIterator.hasNext()) {
-		gameIterator.next();
-		Server_Game *g = gameIterator.value().first;
-		Server_Player *p = gameIterator.value().second;
+	const QList<int> gameIds = games.keys();
+	gameListMutex.unlock();
+	
+	for (int i = 0; i < gameIds.size(); ++i) {
+		QPair<Server_Game *, Server_Player *> gamePair = lockGame(gameIds[i]);
+		Server_Game *g = gamePair.first;
+		Server_Player *p = gamePair.second;
+		if (!g)
+			continue;
 		
 		if ((authState == UnknownUser) || p->getSpectator())
 			g->removePlayer(p);
@@ -50,8 +56,8 @@ void Server_ProtocolHandler::prepareDestroy()
 			p->setProtocolHandler(0);
 			g->postConnectionStatusUpdate(p, false);
 		}
+		g->gameMutex.unlock();
 	}
-	gameListMutex.unlock();
 
 	delete userInfo;
 	QMapIterator<QString, ServerInfo_User *> i(buddyList);
@@ -70,6 +76,35 @@ void Server_ProtocolHandler::playerRemovedFromGame(Server_Game *game)
 	games.remove(game->getGameId());
 }
 
+QPair<Server_Game *, Server_Player *> Server_ProtocolHandler::lockGame(int gameId)
+{
+	// Game threads hold gameMutex when they call playerRemovedFromGame(), so
+	// we must never wait for gameMutex while holding gameListMutex. Holding
+	// gameListMutex does keep the games in our list alive, though, so the
+	// game lock is only tried, and we back off if it is taken.
+	forever {
+		gameListMutex.lock();
+		QPair<Server_Game *, Server_Player *> gamePair = games.value(gameId);
+		if (!gamePair.first || gamePair.first->gameMutex.tryLock()) {
+			gameListMutex.unlock();
+			return gamePair;
+		}
+		gameListMutex.unlock();
+		QThread::yieldCurrentThread();
+	}
+}
+
+bool Server_ProtocolHandler::isPlayingInGame()
+{
+	QMutexLocker locker(&gameListMutex);
+	
+	QMapIterator<int, QPair<Server_Game *, Server_Player *> > gameIterator(games);
+	while (gameIterator.hasNext())
+		if (!gameIterator.next().value().second->getSpectator())
+			return true;
+	return false;
+}
+
 ResponseCode Server_ProtocolHandler::processCommandHelper(Command *command, CommandContainer *cont)
 {
 	RoomCommand *roomCommand = qobject_cast<RoomCommand *>(command);
@@ -98,51 +133,15 @@ ResponseCode Server_ProtocolHandler::processCommandHelper(Command *command, Comm
 		if (authState == PasswordWrong)
 			return RespLoginNeeded;
 		
-		gameListMutex.lock();
-		if (!games.contains(gameCommand->getGameId())) {
+		QPair<Server_Game *, Server_Player *> gamePair = lockGame(gameCommand->getGameId());
+		if (!gamePair.first) {
 			qDebug() << "invalid game";
 			return RespNotInRoom;
 		}
-		QPair<Server_Game *, Server_Player *> gamePair = games.value(gameCommand->getGameId());
-		Server_Game *game = gamePair.first;
-		Server_Player *player = gamePair.second;
 		
-		QMutexLocker locker(&game->gameMutex);
-		gameListMutex.unlock();
-		
-		switch (command->getItemId()) {
-			case ItemId_Command_DeckSelect: return cmdDeckSelect(static_cast<Command_DeckSelect *>(command), cont, game, player);
-			case ItemId_Command_SetSideboardPlan: return cmdSetSideboardPlan(static_cast<Command_SetSideboardPlan *>(command), cont, game, player);
-			case ItemId_Command_LeaveGame: return cmdLeaveGame(static_cast<Command_LeaveGame *>(command), cont, game, player);
-			case ItemId_Command_KickFromGame: return cmdKickFromGame(static_cast<Command_KickFromGame *>(command), cont, game, player);
-			case ItemId_Command_ReadyStart: return cmdReadyStart(static_cast<Command_ReadyStart *>(command), cont, game, player);
-			case ItemId_Command_Concede: return cmdConcede(static_cast<Command_Concede *>(command), cont, game, player);
-			case ItemId_Command_Say: return cmdSay(static_cast<Command_Say *>(command), cont, game, player);
-			case ItemId_Command_Shuffle: return cmdShuffle(static_cast<Command_Shuffle *>(command), cont, game, player);
-			case ItemId_Command_Mulligan: return cmdMulligan(static_cast<Command_Mulligan *>(command), cont, game, player);
-			case ItemId_Command_RollDie: return cmdRollDie(static_cast<Command_RollDie *>(command), cont, game, player);
-			case ItemId_Command_DrawCards: return cmdDrawCards(static_cast<Command_DrawCards *>(command), cont, game, player);
-			case ItemId_Command_UndoDraw: return cmdUndoDraw(static_cast<Command_UndoDraw *>(command), cont, game, player);
-			case ItemId_Command_MoveCard: return cmdMoveCard(static_cast<Command_MoveCard *>(command), cont, game, player);
-			case ItemId_Command_FlipCard: return cmdFlipCard(static_cast<Command_FlipCard *>(command), cont, game, player);
-			case ItemId_Command_AttachCard: return cmdAttachCard(static_cast<Command_AttachCard *>(command), cont, game, player);
-			case ItemId_Command_CreateToken: return cmdCreateToken(static_cast<Command_CreateToken *>(command), cont, game, player);
-			case ItemId_Command_CreateArrow: return cmdCreateArrow(static_cast<Command_CreateArrow *>(command), cont, game, player);
-			case ItemId_Command_DeleteArrow: return cmdDeleteArrow(static_cast<Command_DeleteArrow *>(command), cont, game, player);
-			case ItemId_Command_SetCardAttr: return cmdSetCardAttr(static_cast<Command_SetCardAttr *>(command), cont, game, player);
-			case ItemId_Command_SetCardCounter: return cmdSetCardCounter(static_cast<Command_SetCardCounter *>(command), cont, game, player);
-			case ItemId_Command_IncCardCounter: return cmdIncCardCounter(static_cast<Command_IncCardCounter *>(command), cont, game, player);
-			case ItemId_Command_IncCounter: return cmdIncCounter(static_cast<Command_IncCounter *>(command), cont, game, player);
-			case ItemId_Command_CreateCounter: return cmdCreateCounter(static_cast<Command_CreateCounter *>(command), cont, game, player);
-			case ItemId_Command_SetCounter: return cmdSetCounter(static_cast<Command_SetCounter *>(command), cont, game, player);
-			case ItemId_Command_DelCounter: return cmdDelCounter(static_cast<Command_DelCounter *>(command), cont, game, player);
-			case ItemId_Command_NextTurn: return cmdNextTurn(static_cast<Command_NextTurn *>(command), cont, game, player);
-			case ItemId_Command_SetActivePhase: return cmdSetActivePhase(static_cast<Command_SetActivePhase *>(command), cont, game, player);
-			case ItemId_Command_DumpZone: return cmdDumpZone(static_cast<Command_DumpZone *>(command), cont, game, player);
-			case ItemId_Command_StopDumpZone: return cmdStopDumpZone(static_cast<Command_StopDumpZone *>(command), cont, game, player);
-			case ItemId_Command_RevealCards: return cmdRevealCards(static_cast<Command_RevealCards *>(command), cont, game, player);
-			default: return RespInvalidCommand;
-		}
+		ResponseCode result = processGameCommandHelper(gameCommand, cont, gamePair.first, gamePair.second);
+		gamePair.first->gameMutex.unlock();
+		return result;
 	}
 	ModeratorCommand *moderatorCommand = qobject_cast<ModeratorCommand *>(command);
 	if (moderatorCommand) {
@@ -192,11 +191,68 @@ ResponseCode Server_ProtocolHandler::processCommandHelper(Command *command, Comm
 	}
 }
 
+ResponseCode Server_ProtocolHandler::processGameCommandHelper(GameCommand *command, CommandContainer *cont, Server_Game *game, Server_Player *player)
+{
+	switch (command->getItemId()) {
+		case ItemId_Command_DeckSelect: return cmdDeckSelect(static_cast<Command_DeckSelect *>(command), cont, game, player);
+		case ItemId_Command_SetSideboardPlan: return cmdSetSideboardPlan(static_cast<Command_SetSideboardPlan *>(command), cont, game, player);
+		case ItemId_Command_LeaveGame: return cmdLeaveGame(static_cast<Command_LeaveGame *>(command), cont, game, player);
+		case ItemId_Command_KickFromGame: return cmdKickFromGame(static_cast<Command_KickFromGame *>(command), cont, game, player);
+		case ItemId_Command_ReadyStart: return cmdReadyStart(static_cast<Command_ReadyStart *>(command), cont, game, player);
+		case ItemId_Command_Concede: return cmdConcede(static_cast<Command_Concede *>(command), cont, game, player);
+		case ItemId_Command_Say: return cmdSay(static_cast<Command_Say *>(command), cont, game, player);
+		case ItemId_Command_Shuffle: return cmdShuffle(static_cast<Command_Shuffle *>(command), cont, game, player);
+		case ItemId_Command_Mulligan: return cmdMulligan(static_cast<Command_Mulligan *>(command), cont, game, player);
+		case ItemId_Command_RollDie: return cmdRollDie(static_cast<Command_RollDie *>(command), cont, game, player);
+		case ItemId_Command_DrawCards: return cmdDrawCards(static_cast<Command_DrawCards *>(command), cont, game, player);
+		case ItemId_Command_UndoDraw: return cmdUndoDraw(static_cast<Command_UndoDraw *>(command), cont, game, player);
+		case ItemId_Command_MoveCard: return cmdMoveCard(static_cast<Command_MoveCard *>(command), cont, game, player);
+		case ItemId_Command_FlipCard: return cmdFlipCard(static_cast<Command_FlipCard *>(command), cont, game, player);
+		case ItemId_Command_AttachCard: return cmdAttachCard(static_cast<Command_AttachCard *>(command), cont, game, player);
+		case ItemId_Command_CreateToken: return cmdCreateToken(static_cast<Command_CreateToken *>(command), cont, game, player);
+		case ItemId_Command_CreateArrow: return cmdCreateArrow(static_cast<Command_CreateArrow *>(command), cont, game, player);
+		case ItemId_Command_DeleteArrow: return cmdDeleteArrow(static_cast<Command_DeleteArrow *>(command), cont, game, player);
+		case ItemId_Command_SetCardAttr: return cmdSetCardAttr(static_cast<Command_SetCardAttr *>(command), cont, game, player);
+		case ItemId_Command_SetCardCounter: return cmdSetCardCounter(static_cast<Command_SetCardCounter *>(command), cont, game, player);
+		case ItemId_Command_IncCardCounter: return cmdIncCardCounter(static_cast<Command_IncCardCounter *>(command), cont, game, player);
+		case ItemId_Command_IncCounter: return cmdIncCounter(static_cast<Command_IncCounter *>(command), cont, game, player);
+		case ItemId_Command_CreateCounter: return cmdCreateCounter(static_cast<Command_CreateCounter *>(command), cont, game, player);
+		case ItemId_Command_SetCounter: return cmdSetCounter(static_cast<Command_SetCounter *>(command), cont, game, player);
+		case ItemId_Command_DelCounter: return cmdDelCounter(static_cast<Command_DelCounter *>(command), cont, game, player);
+		case ItemId_Command_NextTurn: return cmdNextTurn(static_cast<Command_NextTurn *>(command), cont, game, player);
+		case ItemId_Command_SetActivePhase: return cmdSetActivePhase(static_cast<Command_SetActivePhase *>(command), cont, game, player);
+		case ItemId_Command_DumpZone: return cmdDumpZone(static_cast<Command_DumpZone *>(command), cont, game, player);
+		case ItemId_Command_StopDumpZone: return cmdStopDumpZone(static_cast<Command_StopDumpZone *>(command), cont, game, player);
+		case ItemId_Command_RevealCards: return cmdRevealCards(static_cast<Command_RevealCards *>(command), cont, game, player);
+		default: return RespInvalidCommand;
+	}
+}
+
 void Server_ProtocolHandler::processCommandContainer(CommandContainer *cont)
 {
-	lastDataReceived = timeRunning;
+	lastDataReceived = server->getTickCount();
 	
 	const QList<Command *> &cmdList = cont->getCommandList();
+	
+	// A container holding only commands for one game is handed over to the
+	// thread owning that game, which processes it without blocking us.
+	GameCommand *firstGameCommand = cmdList.isEmpty() ? 0 : qobject_cast<GameCommand *>(cmdList.first());
+	if (firstGameCommand && (authState != PasswordWrong)) {
+		bool singleGame = true;
+		for (int i = 1; singleGame && (i < cmdList.size()); ++i) {
+			GameCommand *gameCommand = qobject_cast<GameCommand *>(cmdList[i]);
+			singleGame = gameCommand && (gameCommand->getGameId() == firstGameCommand->getGameId());
+		}
+		if (singleGame) {
+			QMutexLocker locker(&gameListMutex);
+			QPair<Server_Game *, Server_Player *> gamePair = games.value(firstGameCommand->getGameId());
+			if (gamePair.first && (gamePair.first->thread() != thread())) {
+				gamePair.first->postCommandContainer(this, gamePair.second->getPlayerId(), cont);
+				return;
+			}
+		}
+	}
+	
 	ResponseCode finalResponseCode = RespOk;
 	for (int i = 0; i < cmdList.size(); ++i) {
 		ResponseCode resp = processCommandHelper(cmdList[i], cont);
@@ -204,67 +260,89 @@ void Server_ProtocolHandler::processCommandContainer(CommandContainer *cont)
 			finalResponseCode = resp;
 	}
 	
-	ProtocolResponse *pr = cont->getResponse();
-	if (!pr)
-		pr = new ProtocolResponse(cont->getCmdId(), finalResponseCode);
-	
-	gameListMutex.lock();
-	GameEventContainer *gQPublic = cont->getGameEventQueuePublic();
-	if (gQPublic) {
-		QPair<Server_Game *, Server_Player *> gamePlayerPair = games.value(gQPublic->getGameId());
+	if (cont->hasGameEvents()) {
+		QPair<Server_Game *, Server_Player *> gamePlayerPair = lockGame(cont->getGameEventQueueGameId());
 		if (gamePlayerPair.first) {
-			GameEventContainer *gQPrivate = cont->getGameEventQueuePrivate();
-			GameEventContainer *gQOmniscient = cont->getGameEventQueueOmniscient();
-			if (gQPrivate) {
-				int privatePlayerId = cont->getPrivatePlayerId();
-				Server_Player *privatePlayer;
-				if (privatePlayerId == -1)
-					privatePlayer = gamePlayerPair.second;
-				else
-					privatePlayer = gamePlayerPair.first->getPlayer(privatePlayerId);
-				if (gQOmniscient) {
-					gamePlayerPair.first->sendGameEventContainer(gQPublic, privatePlayer, true);
-					gamePlayerPair.first->sendGameEventContainerOmniscient(gQOmniscient, privatePlayer);
-				} else
-					gamePlayerPair.first->sendGameEventContainer(gQPublic, privatePlayer);
-				privatePlayer->sendProtocolItem(gQPrivate);
-			} else
-				gamePlayerPair.first->sendGameEventContainer(gQPublic);
+			sendGameEventQueues(cont, gamePlayerPair.first, gamePlayerPair.second);
+			gamePlayerPair.first->gameMutex.unlock();
 		}
 	}
-	gameListMutex.unlock();
 	
-	const QList<ProtocolItem *> &iQ = cont->getItemQueue();
-	for (int i = 0; i < iQ.size(); ++i)
-		sendProtocolItem(iQ[i]);
-	
-	sendProtocolItem(pr);
+	sendContainerResponse(cont, finalResponseCode);
 	
 	while (!itemQueue.isEmpty())
-		sendProtocolItem(itemQueue.takeFirst());
+		sendEncodedItem(*itemQueue.takeFirst());
+
+	if (cont->getReceiverMayDelete())
+		delete cont;
+}
 
+void Server_ProtocolHandler::processGameCommandContainer(CommandContainer *cont, Server_Game *game, Server_Player *player)
+{
+	// Called in the thread owning the game, with gameMutex locked.
+	int playerId = player->getPlayerId();
+	const QList<Command *> &cmdList = cont->getCommandList();
+	ResponseCode finalResponseCode = RespOk;
+	for (int i = 0; i < cmdList.size(); ++i) {
+		ResponseCode resp = processGameCommandHelper(static_cast<GameCommand *>(cmdList[i]), cont, game, player);
+		if ((resp != RespOk) && (resp != RespNothing))
+			finalResponseCode = resp;
+	}
+	
+	// The player is gone if one of the commands made it leave the game.
+	if (cont->hasGameEvents() && (game->getPlayer(playerId) == player))
+		sendGameEventQueues(cont, game, player);
+	
+	sendContainerResponse(cont, finalResponseCode);
+	
 	if (cont->getReceiverMayDelete())
 		delete cont;
 }
 
-void Server_ProtocolHandler::pingClockTimeout()
+void Server_ProtocolHandler::sendGameEventQueues(CommandContainer *cont, Server_Game *game, Server_Player *player)
 {
-	int interval = server->getMessageCountingInterval();
-	if (interval > 0) {
-		messageSizeOverTime.prepend(0);
-		if (messageSizeOverTime.size() > server->getMessageCountingInterval())
-			messageSizeOverTime.removeLast();
-		messageCountOverTime.prepend(0);
-		if (messageCountOverTime.size() > server->getMessageCountingInterval())
-			messageCountOverTime.removeLast();
+	Server_Player *privatePlayer = 0;
+	if (cont->hasGameEventsFor(AudiencePrivate)) {
+		int privatePlayerId = cont->getPrivatePlayerId();
+		if (privatePlayerId == -1)
+			privatePlayer = player;
+		else
+			privatePlayer = game->getPlayer(privatePlayerId);
 	}
+	game->sendGameEventQueue(cont, privatePlayer);
+}
+
+void Server_ProtocolHandler::sendContainerResponse(CommandContainer *cont, ResponseCode finalResponseCode)
+{
+	ProtocolResponse *pr = cont->getResponse();
+	if (!pr)
+		pr = new ProtocolResponse(cont->getCmdId(), finalResponseCode);
+	
+	const QList<ProtocolItem *> &iQ = cont->getItemQueue();
+	for (int i = 0; i < iQ.size(); ++i)
+		sendProtocolItem(iQ[i]);
 	
-	if (timeRunning - lastDataReceived > server->getMaxPlayerInactivityTime())
+	sendProtocolItem(pr);
+}
+
+void Server_ProtocolHandler::timerWheelExpired()
+{
+	// Incoming commands don't touch the timer wheel, so check whether one
+	// arrived in the meantime and sleep for the rest of the allowed time if so.
+	const int inactivityTime = getLastCommandTime();
+	const int maxInactivityTime = server->getMaxPlayerInactivityTime();
+	if (inactivityTime > maxInactivityTime)
 		deleteLater();
-	++timeRunning;
+	else
+		server->getTimerWheel().schedule(this, maxInactivityTime - inactivityTime + 1);
 }
 
 void Server_ProtocolHandler::enqueueProtocolItem(ProtocolItem *item)
+{
+	itemQueue.append(QSharedPointer<EncodedProtocolItem>(new EncodedProtocolItem(item, true)));
+}
+
+void Server_ProtocolHandler::enqueueEncodedItem(const QSharedPointer<EncodedProtocolItem> &item)
 {
 	itemQueue.append(item);
 }
@@ -316,7 +394,6 @@ ResponseCode Server_ProtocolHandler::cmdLogin(Command_Login *cmd, CommandContain
 	
 	QList<ServerInfo_Game *> gameList;
 	QMapIterator<int, Server_Room *> roomIterator(server->getRooms());
-	QMutexLocker gameListLocker(&gameListMutex);
 	while (roomIterator.hasNext()) {
 		Server_Room *room = roomIterator.next().value();
 		room->roomMutex.lock();
@@ -329,10 +406,14 @@ ResponseCode Server_ProtocolHandler::cmdLogin(Command_Login *cmd, CommandContain
 				if (gamePlayers[j]->getUserInfo()->getName() == userInfo->getName()) {
 					gamePlayers[j]->setProtocolHandler(this);
 					game->postConnectionStatusUpdate(gamePlayers[j], true);
+					gameListMutex.lock();
 					games.insert(game->getGameId(), QPair<Server_Game *, Server_Player *>(game, gamePlayers[j]));
+					gameListMutex.unlock();
 					
 					enqueueProtocolItem(new Event_GameJoined(game->getGameId(), game->getDescription(), game->getHostId(), gamePlayers[j]->getPlayerId(), gamePlayers[j]->getSpectator(), game->getSpectatorsCanTalk(), game->getSpectatorsSeeEverything(), true));
-					enqueueProtocolItem(GameEventContainer::makeNew(new Event_GameStateChanged(game->getGameStarted(), game->getActivePlayer(), game->getActivePhase(), game->getGameState(gamePlayers[j])), game->getGameId()));
+					const QList<QSharedPointer<EncodedProtocolItem> > gameState = game->getGameStateItems(gamePlayers[j]);
+					for (int k = 0; k < gameState.size(); ++k)
+						enqueueEncodedItem(gameState[k]);
 					
 					break;
 				}
@@ -354,7 +435,8 @@ ResponseCode Server_ProtocolHandler::cmdMessage(Command_Message *cmd, CommandCon
 		return RespLoginNeeded;
 	
 	QString receiver = cmd->getUserName();
-	Server_ProtocolHandler *userHandler = server->getUsers().value(receiver);
+	QReadLocker locker(&server->clientsLock);
+	Server_ProtocolHandler *userHandler = server->getUser(receiver);
 	qDebug() << "cmdMessage: recv=" << receiver << (userHandler == 0 ? "not found" : "found");
 	if (!userHandler)
 		return RespNameNotFound;
@@ -371,10 +453,10 @@ ResponseCode Server_ProtocolHandler::cmdGetGamesOfUser(Command_GetGamesOfUser *c
 	if (authState == PasswordWrong)
 		return RespLoginNeeded;
 	
-	server->serverMutex.lock();
-	if (!server->getUsers().contains(cmd->getUserName()))
+	if (!server->getUser(cmd->getUserName()))
 		return RespNameNotFound;
 	
+	server->serverMutex.lock();
 	QList<ServerInfo_Room *> roomList;
 	QList<ServerInfo_Game *> gameList;
 	QMapIterator<int, Server_Room *> roomIterator(server->getRooms());
@@ -403,7 +485,8 @@ ResponseCode Server_ProtocolHandler::cmdGetUserInfo(Command_GetUserInfo *cmd, Co
 	if (cmd->getUserName().isEmpty())
 		result = new ServerInfo_User(userInfo);
 	else {
-		Server_ProtocolHandler *handler = server->getUsers().value(cmd->getUserName());
+		QReadLocker locker(&server->clientsLock);
+		Server_ProtocolHandler *handler = server->getUser(cmd->getUserName());
 		if (!handler)
 			return RespNameNotFound;
 		result = new ServerInfo_User(handler->getUserInfo(), true, userInfo->getUserLevel() & ServerInfo_User::IsModerator);
@@ -466,19 +549,9 @@ ResponseCode Server_ProtocolHandler::cmdRoomSay(Command_RoomSay *cmd, CommandCon
 	QString msg = cmd->getMessage();
 	
 	if (server->getMessageCountingInterval() > 0) {
-		int totalSize = 0, totalCount = 0;
-		if (messageSizeOverTime.isEmpty())
-			messageSizeOverTime.prepend(0);
-		messageSizeOverTime[0] += msg.size();
-		for (int i = 0; i < messageSizeOverTime.size(); ++i)
-			totalSize += messageSizeOverTime[i];
-		
-		if (messageCountOverTime.isEmpty())
-			messageCountOverTime.prepend(0);
-		++messageCountOverTime[0];
-		for (int i = 0; i < messageCountOverTime.size(); ++i)
-			totalCount += messageCountOverTime[i];
-		
+		const int tick = server->getTickCount();
+		const int totalSize = messageSizeLimiter.add(tick, msg.size());
+		const int totalCount = messageCountLimiter.add(tick, 1);
 		if ((totalSize > server->getMaxMessageSizePerInterval()) || (totalCount > server->getMaxMessageCountPerInterval()))
 			return RespChatFlood;
 	}
@@ -494,9 +567,11 @@ ResponseCode Server_ProtocolHandler::cmdListUsers(Command_ListUsers * /*cmd*/, C
 		return RespLoginNeeded;
 	
 	QList<ServerInfo_User *> resultList;
-	QMapIterator<QString, Server_ProtocolHandler *> userIterator = server->getUsers();
-	while (userIterator.hasNext())
-		resultList.append(new ServerInfo_User(userIterator.next().value()->getUserInfo(), false));
+	server->clientsLock.lockForRead();
+	const QList<Server_ProtocolHandler *> userList = server->getUserList();
+	for (int i = 0; i < userList.size(); ++i)
+		resultList.append(new ServerInfo_User(userList[i]->getUserInfo(), false));
+	server->clientsLock.unlock();
 	
 	acceptsUserListChanges = true;
 	
@@ -526,15 +601,16 @@ ResponseCode Server_ProtocolHandler::cmdCreateGame(Command_CreateGame *cmd, Comm
 		description = description.left(60);
 	Server_Game *game = room->createGame(description, cmd->getPassword(), cmd->getMaxPlayers(), gameTypes, cmd->getOnlyBuddies(), cmd->getOnlyRegistered(), cmd->getSpectatorsAllowed(), cmd->getSpectatorsNeedPassword(), cmd->getSpectatorsCanTalk(), cmd->getSpectatorsSeeEverything(), this);
 	
+	QMutexLocker gameLocker(&game->gameMutex);
 	Server_Player *creator = game->getPlayers().values().first();
 	
 	QMutexLocker gameListLocker(&gameListMutex);
 	games.insert(game->getGameId(), QPair<Server_Game *, Server_Player *>(game, creator));
 	
 	sendProtocolItem(new Event_GameJoined(game->getGameId(), game->getDescription(), creator->getPlayerId(), creator->getPlayerId(), false, game->getSpectatorsCanTalk(), game->getSpectatorsSeeEverything(), false));
-	sendProtocolItem(GameEventContainer::makeNew(new Event_GameStateChanged(game->getGameStarted(), game->getActivePlayer(), game->getActivePhase(), game->getGameState(creator)), game->getGameId()));
-	
-	game->gameMutex.unlock();
+	const QList<QSharedPointer<EncodedProtocolItem> > gameState = game->getGameStateItems(creator);
+	for (int i = 0; i < gameState.size(); ++i)
+		sendEncodedItem(*gameState[i]);
 	
 	return RespOk;
 }
@@ -544,11 +620,13 @@ ResponseCode Server_ProtocolHandler::cmdJoinGame(Command_JoinGame *cmd, CommandC
 	if (authState == PasswordWrong)
 		return RespLoginNeeded;
 	
-	QMutexLocker gameListLocker(&gameListMutex);
-	
-	if (games.contains(cmd->getGameId()))
+	gameListMutex.lock();
+	bool alreadyJoined = games.contains(cmd->getGameId());
+	gameListMutex.unlock();
+	if (alreadyJoined)
 		return RespContextError;
 	
+	// The locked room keeps the game alive.
 	Server_Game *g = room->getGames().value(cmd->getGameId());
 	if (!g)
 		return RespNameNotFound;
@@ -557,10 +635,14 @@ ResponseCode Server_ProtocolHandler::cmdJoinGame(Command_JoinGame *cmd, CommandC
 	
 	ResponseCode result = g->checkJoin(userInfo, cmd->getPassword(), cmd->getSpectator(), cmd->getOverrideRestrictions());
 	if (result == RespOk) {
-		Server_Player *player = g->addPlayer(this, cmd->getSpectator());
+		QList<QSharedPointer<EncodedProtocolItem> > gameState;
+		Server_Player *player = g->addPlayer(this, cmd->getSpectator(), true, &gameState);
+		gameListMutex.lock();
 		games.insert(cmd->getGameId(), QPair<Server_Game *, Server_Player *>(g, player));
+		gameListMutex.unlock();
 		enqueueProtocolItem(new Event_GameJoined(cmd->getGameId(), g->getDescription(), g->getHostId(), player->getPlayerId(), cmd->getSpectator(), g->getSpectatorsCanTalk(), g->getSpectatorsSeeEverything(), false));
-		enqueueProtocolItem(GameEventContainer::makeNew(new Event_GameStateChanged(g->getGameStarted(), g->getActivePlayer(), g->getActivePhase(), g->getGameState(player)), cmd->getGameId()));
+		for (int i = 0; i < gameState.size(); ++i)
+			enqueueEncodedItem(gameState[i]);
 	}
 	return result;
 }
@@ -619,6 +701,8 @@ ResponseCode Server_ProtocolHandler::cmdSetSideboardPlan(Command_SetSideboardPla
 		return RespContextError;
 	
 	deck->setCurrentSideboardPlan(cmd->getMoveList());
+	// Only the player itself sees this, so there is no event invalidating the cached state.
+	game->gameStateChanged();
 	return RespOk;
 }
 
@@ -694,27 +778,23 @@ ResponseCode Server_ProtocolHandler::cmdMulligan(Command_Mulligan * /*cmd*/, Com
 		return RespContextError;
 	
 	Server_CardZone *hand = player->getZones().value("hand");
-	int number = (hand->cards.size() <= 1) ? player->getInitialCards() : hand->cards.size() - 1;
+	int number = (hand->getCards().size() <= 1) ? player->getInitialCards() : hand->getCards().size() - 1;
 		
 	Server_CardZone *deck = player->getZones().value("deck");
-	while (!hand->cards.isEmpty()) {
-		CardToMove *cardToMove = new CardToMove(hand->cards.first()->getId());
+	while (!hand->getCards().isEmpty()) {
+		CardToMove *cardToMove = new CardToMove(hand->getCards().first()->getId());
 		player->moveCard(cont, hand, QList<CardToMove *>() << cardToMove, deck, 0, 0, false);
 		delete cardToMove;
 	}
 
 	deck->shuffle();
-	cont->enqueueGameEventPrivate(new Event_Shuffle(player->getPlayerId()), game->getGameId());
-	cont->enqueueGameEventOmniscient(new Event_Shuffle(player->getPlayerId()), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_Shuffle(player->getPlayerId()), game->getGameId());
+	cont->enqueueGameEvent(new Event_Shuffle(player->getPlayerId()), game->getGameId());
 
 	player->drawCards(cont, number);
 	
 	if (number == player->getInitialCards())
 		number = -1;
-	cont->getGameEventQueuePrivate()->setContext(new Context_Mulligan(number));
-	cont->getGameEventQueuePublic()->setContext(new Context_Mulligan(number));
-	cont->getGameEventQueueOmniscient()->setContext(new Context_Mulligan(number));
+	cont->setGameEventContext(new Context_Mulligan(number));
 
 	return RespOk;
 }
@@ -725,8 +805,10 @@ ResponseCode Server_ProtocolHandler::cmdRollDie(Command_RollDie *cmd, CommandCon
 		return RespFunctionNotAllowed;
 	if (player->getConceded())
 		return RespContextError;
+	if (cmd->getSides() < 1)
+		return RespContextError;
 	
-	game->sendGameEvent(new Event_RollDie(player->getPlayerId(), cmd->getSides(), rng->getNumber(1, cmd->getSides())));
+	game->sendGameEvent(new Event_RollDie(player->getPlayerId(), cmd->getSides(), game->getRNG()->getNumber(1, cmd->getSides())));
 	return RespOk;
 }
 
@@ -794,8 +876,7 @@ ResponseCode Server_ProtocolHandler::cmdFlipCard(Command_FlipCard *cmd, CommandC
 		return RespContextError;
 	
 	card->setFaceDown(faceDown);
-	cont->enqueueGameEventPrivate(new Event_FlipCard(player->getPlayerId(), zone->getName(), card->getId(), card->getName(), faceDown), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_FlipCard(player->getPlayerId(), zone->getName(), card->getId(), card->getName(), faceDown), game->getGameId());
+	cont->enqueueGameEvent(new Event_FlipCard(player->getPlayerId(), zone->getName(), card->getId(), card->getName(), faceDown), game->getGameId());
 	
 	return RespOk;
 }
@@ -845,22 +926,12 @@ ResponseCode Server_ProtocolHandler::cmdAttachCard(Command_AttachCard *cmd, Comm
 		return RespContextError;
 	
 	// Get all arrows pointing to or originating from the card being attached and delete them.
-	QMapIterator<int, Server_Player *> playerIterator(game->getPlayers());
-	while (playerIterator.hasNext()) {
-		Server_Player *p = playerIterator.next().value();
-		QList<Server_Arrow *> arrows = p->getArrows().values();
-		QList<Server_Arrow *> toDelete;
-		for (int i = 0; i < arrows.size(); ++i) {
-			Server_Arrow *a = arrows[i];
-			Server_Card *tCard = qobject_cast<Server_Card *>(a->getTargetItem());
-			if ((tCard == card) || (a->getStartCard() == card))
-				toDelete.append(a);
-		}
-		for (int i = 0; i < toDelete.size(); ++i) {
-			cont->enqueueGameEventPrivate(new Event_DeleteArrow(p->getPlayerId(), toDelete[i]->getId()), game->getGameId());
-			cont->enqueueGameEventPublic(new Event_DeleteArrow(p->getPlayerId(), toDelete[i]->getId()), game->getGameId());
-			p->deleteArrow(toDelete[i]->getId());
-		}
+	const QList<Server_Arrow *> arrowsToDelete = card->getRelatedArrows().toList();
+	for (int i = 0; i < arrowsToDelete.size(); ++i) {
+		Server_Player *p = arrowsToDelete[i]->getPlayer();
+		const int arrowId = arrowsToDelete[i]->getId();
+		cont->enqueueGameEvent(new Event_DeleteArrow(p->getPlayerId(), arrowId), game->getGameId());
+		p->deleteArrow(arrowId);
 	}
 
 	if (targetCard) {
@@ -877,9 +948,8 @@ ResponseCode Server_ProtocolHandler::cmdAttachCard(Command_AttachCard *cmd, Comm
 		}
 		
 		card->setParentCard(targetCard);
-		card->setCoords(-1, card->getY());
-		cont->enqueueGameEventPrivate(new Event_AttachCard(player->getPlayerId(), startzone->getName(), card->getId(), targetPlayer->getPlayerId(), targetzone->getName(), targetCard->getId()), game->getGameId());
-		cont->enqueueGameEventPublic(new Event_AttachCard(player->getPlayerId(), startzone->getName(), card->getId(), targetPlayer->getPlayerId(), targetzone->getName(), targetCard->getId()), game->getGameId());
+		startzone->updateCardCoords(card, -1, card->getY());
+		cont->enqueueGameEvent(new Event_AttachCard(player->getPlayerId(), startzone->getName(), card->getId(), targetPlayer->getPlayerId(), targetzone->getName(), targetCard->getId()), game->getGameId());
 		startzone->fixFreeSpaces(cont);
 	} else
 		player->unattachCard(cont, card);
@@ -971,7 +1041,7 @@ ResponseCode Server_ProtocolHandler::cmdCreateArrow(Command_CreateArrow *cmd, Co
 			return RespContextError;
 	}
 	
-	Server_Arrow *arrow = new Server_Arrow(player->newArrowId(), startCard, targetItem, cmd->getColor());
+	Server_Arrow *arrow = new Server_Arrow(player->newArrowId(), player, startCard, targetItem, cmd->getColor());
 	player->addArrow(arrow);
 	game->sendGameEvent(new Event_CreateArrows(player->getPlayerId(), QList<ServerInfo_Arrow *>() << new ServerInfo_Arrow(
 		arrow->getId(),
@@ -1038,8 +1108,7 @@ ResponseCode Server_ProtocolHandler::cmdSetCardCounter(Command_SetCardCounter *c
 	
 	card->setCounter(cmd->getCounterId(), cmd->getCounterValue());
 	
-	cont->enqueueGameEventPrivate(new Event_SetCardCounter(player->getPlayerId(), zone->getName(), card->getId(), cmd->getCounterId(), cmd->getCounterValue()), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_SetCardCounter(player->getPlayerId(), zone->getName(), card->getId(), cmd->getCounterId(), cmd->getCounterValue()), game->getGameId());
+	cont->enqueueGameEvent(new Event_SetCardCounter(player->getPlayerId(), zone->getName(), card->getId(), cmd->getCounterId(), cmd->getCounterValue()), game->getGameId());
 	return RespOk;
 }
 
@@ -1066,8 +1135,7 @@ ResponseCode Server_ProtocolHandler::cmdIncCardCounter(Command_IncCardCounter *c
 	int newValue = card->getCounter(cmd->getCounterId()) + cmd->getCounterDelta();
 	card->setCounter(cmd->getCounterId(), newValue);
 	
-	cont->enqueueGameEventPrivate(new Event_SetCardCounter(player->getPlayerId(), zone->getName(), card->getId(), cmd->getCounterId(), newValue), game->getGameId());
-	cont->enqueueGameEventPublic(new Event_SetCardCounter(player->getPlayerId(), zone->getName(), card->getId(), cmd->getCounterId(), newValue), game->getGameId());
+	cont->enqueueGameEvent(new Event_SetCardCounter(player->getPlayerId(), zone->getName(), card->getId(), cmd->getCounterId(), newValue), game->getGameId());
 	return RespOk;
 }
 
@@ -1190,8 +1258,8 @@ ResponseCode Server_ProtocolHandler::cmdDumpZone(Command_DumpZone *cmd, CommandC
 	
 	int numberCards = cmd->getNumberCards();
 	QList<ServerInfo_Card *> respCardList;
-	for (int i = 0; (i < zone->cards.size()) && (i < numberCards || numberCards == -1); ++i) {
-		Server_Card *card = zone->cards[i];
+	for (int i = 0; (i < zone->getCards().size()) && (i < numberCards || numberCards == -1); ++i) {
+		Server_Card *card = zone->getCards()[i];
 		QString displayedName = card->getFaceDown() ? QString() : card->getName();
 		if (zone->getType() == HiddenZone)
 			respCardList.append(new ServerInfo_Card(i, displayedName));
@@ -1219,7 +1287,7 @@ ResponseCode Server_ProtocolHandler::cmdDumpZone(Command_DumpZone *cmd, CommandC
 		zone->setCardsBeingLookedAt(numberCards);
 		game->sendGameEvent(new Event_DumpZone(player->getPlayerId(), otherPlayer->getPlayerId(), zone->getName(), numberCards));
 	}
-	cont->setResponse(new Response_DumpZone(cont->getCmdId(), RespOk, new ServerInfo_Zone(zone->getName(), zone->getType(), zone->hasCoords(), numberCards < zone->cards.size() ? zone->cards.size() : numberCards, respCardList)));
+	cont->setResponse(new Response_DumpZone(cont->getCmdId(), RespOk, new ServerInfo_Zone(zone->getName(), zone->getType(), zone->hasCoords(), numberCards < zone->getCards().size() ? zone->getCards().size() : numberCards, respCardList)));
 	return RespNothing;
 }
 
@@ -1266,11 +1334,11 @@ ResponseCode Server_ProtocolHandler::cmdRevealCards(Command_RevealCards *cmd, Co
 	
 	QList<Server_Card *> cardsToReveal;
 	if (cmd->getCardId() == -1)
-		cardsToReveal = zone->cards;
+		cardsToReveal = zone->getCards();
 	else if (cmd->getCardId() == -2) {
-		if (zone->cards.isEmpty())
+		if (zone->getCards().isEmpty())
 			return RespContextError;
-		cardsToReveal.append(zone->cards.at(rng->getNumber(0, zone->cards.size() - 1)));
+		cardsToReveal.append(zone->getCards().at(game->getRNG()->getNumber(0, zone->getCards().size() - 1)));
 	} else {
 		Server_Card *card = zone->getCard(cmd->getCardId());
 		if (!card)
@@ -1278,16 +1346,15 @@ ResponseCode Server_ProtocolHandler::cmdRevealCards(Command_RevealCards *cmd, Co
 		cardsToReveal.append(card);
 	}
 	
-	QList<ServerInfo_Card *> respCardListPrivate, respCardListOmniscient;
+	QList<ServerInfo_Card *> respCardList;
 	for (int i = 0; i < cardsToReveal.size(); ++i) {
 		Server_Card *card = cardsToReveal[i];
 
-		QList<ServerInfo_CardCounter *> cardCounterListPrivate, cardCounterListOmniscient;
+		QList<ServerInfo_CardCounter *> cardCounterList;
 		QMapIterator<int, int> cardCounterIterator(card->getCounters());
 		while (cardCounterIterator.hasNext()) {
 			cardCounterIterator.next();
-			cardCounterListPrivate.append(new ServerInfo_CardCounter(cardCounterIterator.key(), cardCounterIterator.value()));
-			cardCounterListOmniscient.append(new ServerInfo_CardCounter(cardCounterIterator.key(), cardCounterIterator.value()));
+			cardCounterList.append(new ServerInfo_CardCounter(cardCounterIterator.key(), cardCounterIterator.value()));
 		}
 		
 		int attachPlayerId = -1;
@@ -1299,17 +1366,14 @@ ResponseCode Server_ProtocolHandler::cmdRevealCards(Command_RevealCards *cmd, Co
 			attachCardId = card->getParentCard()->getId();
 		}
 		
-		if (cmd->getPlayerId() != -1)
-			respCardListPrivate.append(new ServerInfo_Card(card->getId(), card->getName(), card->getX(), card->getY(), card->getFaceDown(), card->getTapped(), card->getAttacking(), card->getColor(), card->getPT(), card->getAnnotation(), card->getDestroyOnZoneChange(), card->getDoesntUntap(), cardCounterListPrivate, attachPlayerId, attachZone, attachCardId));
-		respCardListOmniscient.append(new ServerInfo_Card(card->getId(), card->getName(), card->getX(), card->getY(), card->getFaceDown(), card->getTapped(), card->getAttacking(), card->getColor(), card->getPT(), card->getAnnotation(), card->getDestroyOnZoneChange(), card->getDoesntUntap(), cardCounterListOmniscient, attachPlayerId, attachZone, attachCardId));
+		respCardList.append(new ServerInfo_Card(card->getId(), card->getName(), card->getX(), card->getY(), card->getFaceDown(), card->getTapped(), card->getAttacking(), card->getColor(), card->getPT(), card->getAnnotation(), card->getDestroyOnZoneChange(), card->getDoesntUntap(), cardCounterList, attachPlayerId, attachZone, attachCardId));
 	}
 	
 	if (cmd->getPlayerId() == -1)
-		cont->enqueueGameEventPublic(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), -1, respCardListOmniscient), game->getGameId());
+		cont->enqueueGameEvent(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), -1, respCardList), game->getGameId());
 	else {
-		cont->enqueueGameEventPublic(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), otherPlayer->getPlayerId()), game->getGameId());
-		cont->enqueueGameEventPrivate(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), otherPlayer->getPlayerId(), respCardListPrivate), game->getGameId(), otherPlayer->getPlayerId());
-		cont->enqueueGameEventOmniscient(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), otherPlayer->getPlayerId(), respCardListOmniscient), game->getGameId());
+		cont->enqueueGameEvent(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), otherPlayer->getPlayerId()), game->getGameId(), AudiencePublic);
+		cont->enqueueGameEvent(new Event_RevealCards(player->getPlayerId(), zone->getName(), cmd->getCardId(), otherPlayer->getPlayerId(), respCardList), game->getGameId(), AudiencePrivate | AudienceOmniscient, 0, otherPlayer->getPlayerId());
 	}
 	
 	return RespOk;
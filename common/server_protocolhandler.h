@@ -3,7 +3,10 @@
 
 #include <QObject>
 #include <QPair>
+#include <QSharedPointer>
+#include <QHostAddress>
 #include "server.h"
+#include "server_ratelimiter.h"
 #include "protocol.h"
 #include "protocol_items.h"
 
@@ -11,9 +14,8 @@ class Server_Player;
 class Server_Card;
 class ServerInfo_User;
 class Server_Room;
-class QTimer;
 
-class Server_ProtocolHandler : public QObject {
+class Server_ProtocolHandler : public QObject, public Server_TimerWheelClient {
 	Q_OBJECT
 protected:
 	Server *server;
@@ -22,6 +24,8 @@ protected:
 
 	Server *getServer() const { return server; }
 	QPair<Server_Game *, Server_Player *> getGame(int gameId) const;
+	// Returns the game with its gameMutex locked, or a null pair.
+	QPair<Server_Game *, Server_Player *> lockGame(int gameId);
 
 	AuthenticationResult authState;
 	bool acceptsUserListChanges;
@@ -33,10 +37,9 @@ protected:
 	virtual bool getCompressionSupport() const = 0;
 	int sessionId;
 private:
-	QList<ProtocolItem *> itemQueue;
-	QList<int> messageSizeOverTime, messageCountOverTime;
-	int timeRunning, lastDataReceived;
-	QTimer *pingClock;
+	QList<QSharedPointer<EncodedProtocolItem> > itemQueue;
+	Server_RateLimiter messageSizeLimiter, messageCountLimiter;
+	int lastDataReceived;
 
 	virtual DeckList *getDeckFromDatabase(int deckId) = 0;
 
@@ -95,29 +98,37 @@ private:
 	virtual ResponseCode cmdUpdateServerMessage(Command_UpdateServerMessage *cmd, CommandContainer *cont) = 0;
 	
 	ResponseCode processCommandHelper(Command *command, CommandContainer *cont);
-private slots:
-	void pingClockTimeout();
+	ResponseCode processGameCommandHelper(GameCommand *command, CommandContainer *cont, Server_Game *game, Server_Player *player);
+	void sendGameEventQueues(CommandContainer *cont, Server_Game *game, Server_Player *player);
+	void sendContainerResponse(CommandContainer *cont, ResponseCode finalResponseCode);
 public:
 	QMutex gameListMutex;
 	
 	Server_ProtocolHandler(Server *_server, QObject *parent = 0);
 	~Server_ProtocolHandler();
 	void playerRemovedFromGame(Server_Game *game);
+	bool isPlayingInGame();
 	
 	bool getAcceptsUserListChanges() const { return acceptsUserListChanges; }
 	bool getAcceptsRoomListChanges() const { return acceptsRoomListChanges; }
 	ServerInfo_User *getUserInfo() const { return userInfo; }
 	virtual QString getAddress() const = 0;
+	// Null for connections that don't come in over the network.
+	virtual QHostAddress getPeerAddress() const { return QHostAddress(); }
 	void setUserInfo(ServerInfo_User *_userInfo) { userInfo = _userInfo; }
 	const QMap<QString, ServerInfo_User *> &getBuddyList() const { return buddyList; }
 	const QMap<QString, ServerInfo_User *> &getIgnoreList() const { return ignoreList; }
 	int getSessionId() const { return sessionId; }
 	void setSessionId(int _sessionId) { sessionId = _sessionId; }
 
-	int getLastCommandTime() const { return timeRunning - lastDataReceived; }
+	int getLastCommandTime() const { return server->getTickCount() - lastDataReceived; }
+	void timerWheelExpired();
 	void processCommandContainer(CommandContainer *cont);
+	void processGameCommandContainer(CommandContainer *cont, Server_Game *game, Server_Player *player);
 	virtual void sendProtocolItem(ProtocolItem *item, bool deleteItem = true) = 0;
+	virtual void sendEncodedItem(EncodedProtocolItem &item) { sendProtocolItem(item.getItem(), false); }
 	void enqueueProtocolItem(ProtocolItem *item);
+	void enqueueEncodedItem(const QSharedPointer<EncodedProtocolItem> &item);
 };
 
 #endif
@@ -0,0 +1,45 @@
+#include "server_ratelimiter.h"
+
+Server_RateLimiter::Server_RateLimiter(int interval)
+	: buckets(qMax(interval, 0)), total(0), lastTick(0)
+{
+}
+
+void Server_RateLimiter::advance(int tick)
+{
+	const int elapsed = tick - lastTick;
+	if (elapsed <= 0)
+		return;
+	
+	const int interval = buckets.size();
+	if (elapsed >= interval) {
+		buckets.fill(0);
+		total = 0;
+	} else
+		for (int i = 1; i <= elapsed; ++i) {
+			int &bucket = buckets[(lastTick + i) % interval];
+			total -= bucket;
+			bucket = 0;
+		}
+	lastTick = tick;
+}
+
+int Server_RateLimiter::add(int tick, int amount)
+{
+	if (buckets.isEmpty())
+		return amount;
+	
+	advance(tick);
+	buckets[tick % buckets.size()] += amount;
+	total += amount;
+	return total;
+}
+
+int Server_RateLimiter::getTotal(int tick)
+{
+	if (buckets.isEmpty())
+		return 0;
+	
+	advance(tick);
+	return total;
+}
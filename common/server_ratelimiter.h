@@ -0,0 +1,24 @@
+#ifndef SERVER_RATELIMITER_H
+#define SERVER_RATELIMITER_H
+
+#include <QVector>
+
+// Sums up amounts over a sliding window of the last few seconds, kept in
+// a ring buffer with one bucket per second. Adding and querying cost O(1),
+// apart from clearing the buckets of the seconds that passed in between.
+// Not thread-safe.
+class Server_RateLimiter {
+private:
+	QVector<int> buckets;
+	int total;
+	int lastTick;
+	void advance(int tick);
+public:
+	Server_RateLimiter(int interval = 0);
+	int getInterval() const { return buckets.size(); }
+	// Adds the amount at the given tick and returns the new sum over the window.
+	int add(int tick, int amount);
+	int getTotal(int tick);
+};
+
+#endif
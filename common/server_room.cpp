@@ -53,7 +53,9 @@ void Server_Room::addClient(Server_ProtocolHandler *client)
 	QMutexLocker locker(&roomMutex);
 	
 	sendRoomEvent(new Event_JoinRoom(id, new ServerInfo_User(client->getUserInfo(), false)));
+	clientListMutex.lock();
 	append(client);
+	clientListMutex.unlock();
 	emit roomInfoChanged();
 }
 
@@ -61,7 +63,9 @@ void Server_Room::removeClient(Server_ProtocolHandler *client)
 {
 	QMutexLocker locker(&roomMutex);
 	
+	clientListMutex.lock();
 	removeAt(indexOf(client));
+	clientListMutex.unlock();
 	sendRoomEvent(new Event_LeaveRoom(id, client->getUserInfo()->getName()));
 	emit roomInfoChanged();
 }
@@ -73,21 +77,24 @@ void Server_Room::say(Server_ProtocolHandler *client, const QString &s)
 
 void Server_Room::sendRoomEvent(RoomEvent *event)
 {
-	QMutexLocker locker(&roomMutex);
+	QMutexLocker locker(&clientListMutex);
 	
+	EncodedProtocolItem encodedEvent(event);
 	for (int i = 0; i < size(); ++i)
-		at(i)->sendProtocolItem(event, false);
+		at(i)->sendEncodedItem(encodedEvent);
 	delete event;
 }
 
 void Server_Room::broadcastGameListUpdate(Server_Game *game)
 {
-	QMutexLocker locker(&roomMutex);
-	
+	// Called by games with their gameMutex locked, so this must not take
+	// roomMutex. getInfo() locks the game and has to come first.
 	Event_ListGames *event = new Event_ListGames(id, QList<ServerInfo_Game *>() << game->getInfo());
 	
+	QMutexLocker locker(&clientListMutex);
+	EncodedProtocolItem encodedEvent(event);
 	for (int i = 0; i < size(); i++)
-		at(i)->sendProtocolItem(event, false);
+		at(i)->sendEncodedItem(encodedEvent);
 	delete event;
 }
 
@@ -96,9 +103,10 @@ Server_Game *Server_Room::createGame(const QString &description, const QString &
 	QMutexLocker locker(&roomMutex);
 	
 	Server_Game *newGame = new Server_Game(creator, static_cast<Server *>(parent())->getNextGameId(), description, password, maxPlayers, gameTypes, onlyBuddies, onlyRegistered, spectatorsAllowed, spectatorsNeedPassword, spectatorsCanTalk, spectatorsSeeEverything, this);
-	newGame->moveToThread(thread());
-	// This mutex needs to be unlocked by the caller.
-	newGame->gameMutex.lock();
+	// Every game is owned by one game thread, which processes all of its
+	// game commands. Without game threads, the game stays with the room.
+	QThread *gameThread = static_cast<Server *>(parent())->getNextGameThread();
+	newGame->moveToThread(gameThread ? gameThread : thread());
 	games.insert(newGame->getGameId(), newGame);
 	
 	broadcastGameListUpdate(newGame);
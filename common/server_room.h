@@ -28,7 +28,11 @@ private:
 	QStringList gameTypes;
 	QMap<int, Server_Game *> games;
 public:
+	// Lock order: roomMutex before any gameMutex. clientListMutex only
+	// guards the client list and is taken last, so games may broadcast
+	// while their gameMutex is locked.
 	mutable QMutex roomMutex;
+	mutable QMutex clientListMutex;
 	Server_Room(int _id, const QString &_name, const QString &_description, bool _autoJoin, const QString &_joinMessage, const QStringList &_gameTypes, Server *parent);
 	~Server_Room();
 	int getId() const { return id; }
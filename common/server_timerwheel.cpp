@@ -0,0 +1,76 @@
+#include "server_timerwheel.h"
+
+Server_TimerWheel::Server_TimerWheel()
+	: currentTick(0)
+{
+}
+
+int Server_TimerWheel::getCurrentTick() const
+{
+	QMutexLocker locker(&mutex);
+	return currentTick;
+}
+
+void Server_TimerWheel::insert(Server_TimerWheelClient *client)
+{
+	if (client->wheelDeadline - currentTick < slotCount) {
+		client->wheelLevel = 0;
+		client->wheelSlot = client->wheelDeadline & (slotCount - 1);
+	} else {
+		client->wheelLevel = 1;
+		client->wheelSlot = (client->wheelDeadline >> slotBits) & (slotCount - 1);
+	}
+	buckets[client->wheelLevel][client->wheelSlot].insert(client);
+}
+
+void Server_TimerWheel::remove(Server_TimerWheelClient *client)
+{
+	if (client->wheelLevel == -1)
+		return;
+	buckets[client->wheelLevel][client->wheelSlot].remove(client);
+	client->wheelLevel = -1;
+	client->wheelSlot = -1;
+}
+
+void Server_TimerWheel::schedule(Server_TimerWheelClient *client, int seconds)
+{
+	QMutexLocker locker(&mutex);
+	
+	remove(client);
+	client->wheelDeadline = currentTick + qMax(seconds, 1);
+	insert(client);
+}
+
+void Server_TimerWheel::cancel(Server_TimerWheelClient *client)
+{
+	QMutexLocker locker(&mutex);
+	
+	remove(client);
+}
+
+QList<Server_TimerWheelClient *> Server_TimerWheel::tick()
+{
+	QMutexLocker locker(&mutex);
+	
+	++currentTick;
+	const int lowerSlot = currentTick & (slotCount - 1);
+	
+	// At the start of every lap of the lower level, move the clients due
+	// during this lap down from the upper level.
+	if (lowerSlot == 0) {
+		QSet<Server_TimerWheelClient *> &upperBucket = buckets[1][(currentTick >> slotBits) & (slotCount - 1)];
+		const QSet<Server_TimerWheelClient *> cascading = upperBucket;
+		upperBucket.clear();
+		QSetIterator<Server_TimerWheelClient *> cascadeIterator(cascading);
+		while (cascadeIterator.hasNext())
+			insert(cascadeIterator.next());
+	}
+	
+	QList<Server_TimerWheelClient *> result = buckets[0][lowerSlot].toList();
+	buckets[0][lowerSlot].clear();
+	for (int i = 0; i < result.size(); ++i) {
+		result[i]->wheelLevel = -1;
+		result[i]->wheelSlot = -1;
+	}
+	return result;
+}
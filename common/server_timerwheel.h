@@ -0,0 +1,47 @@
+#ifndef SERVER_TIMERWHEEL_H
+#define SERVER_TIMERWHEEL_H
+
+#include <QMutex>
+#include <QSet>
+#include <QList>
+
+class Server_TimerWheel;
+
+// Implemented by objects that want to be woken up by a Server_TimerWheel.
+class Server_TimerWheelClient {
+	friend class Server_TimerWheel;
+private:
+	int wheelDeadline, wheelLevel, wheelSlot;
+public:
+	Server_TimerWheelClient() : wheelDeadline(0), wheelLevel(-1), wheelSlot(-1) { }
+	virtual ~Server_TimerWheelClient() { }
+	virtual void timerWheelExpired() = 0;
+};
+
+// A hierarchical timer wheel with a resolution of one second. The lower
+// level has a slot for each of the next 64 seconds, the upper level a slot
+// for each of the next 64 minute-ish periods; later deadlines go round the
+// upper level more than once. Scheduling and cancelling are O(1), and a
+// tick only touches the clients that are due.
+class Server_TimerWheel {
+private:
+	static const int slotBits = 6;
+	static const int slotCount = 1 << slotBits;
+	mutable QMutex mutex;
+	int currentTick;
+	QSet<Server_TimerWheelClient *> buckets[2][slotCount];
+	
+	void insert(Server_TimerWheelClient *client);
+	void remove(Server_TimerWheelClient *client);
+public:
+	Server_TimerWheel();
+	int getCurrentTick() const;
+	// Wakes the client up after the given number of seconds, replacing an earlier schedule.
+	void schedule(Server_TimerWheelClient *client, int seconds);
+	void cancel(Server_TimerWheelClient *client);
+	// Advances the wheel by one second and returns the clients which are due.
+	// They are no longer scheduled; the caller invokes timerWheelExpired() on them.
+	QList<Server_TimerWheelClient *> tick();
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "stream_compression.h"
+
+static const int zlibBufferSize = 16384;
+
+StreamCompressor::StreamCompressor(int level)
+{
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	valid = deflateInit(&stream, level) == Z_OK;
+}
+
+StreamCompressor::~StreamCompressor()
+{
+	if (valid)
+		deflateEnd(&stream);
+}
+
+QByteArray StreamCompressor::compress(const QByteArray &data)
+{
+	QByteArray result;
+	if (data.isEmpty() || !valid)
+		return result;
+	
+	char buffer[zlibBufferSize];
+	stream.next_in = (Bytef *) data.constData();
+	stream.avail_in = data.size();
+	// Z_SYNC_FLUSH puts everything on the wire without resetting the
+	// dictionary.
+	do {
+		stream.next_out = (Bytef *) buffer;
+		stream.avail_out = zlibBufferSize;
+		deflate(&stream, Z_SYNC_FLUSH);
+		result.append(buffer, zlibBufferSize - stream.avail_out);
+	} while (stream.avail_out == 0);
+	
+	return result;
+}
+
+StreamDecompressor::StreamDecompressor()
+{
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	stream.next_in = Z_NULL;
+	stream.avail_in = 0;
+	valid = inflateInit(&stream) == Z_OK;
+}
+
+StreamDecompressor::~StreamDecompressor()
+{
+	if (valid)
+		inflateEnd(&stream);
+}
+
+bool StreamDecompressor::decompress(const QByteArray &data, QByteArray &result)
+{
+	if (!valid)
+		return false;
+	if (data.isEmpty())
+		return true;
+	
+	char buffer[zlibBufferSize];
+	stream.next_in = (Bytef *) data.constData();
+	stream.avail_in = data.size();
+	do {
+		stream.next_out = (Bytef *) buffer;
+		stream.avail_out = zlibBufferSize;
+		int ret = inflate(&stream, Z_SYNC_FLUSH);
+		if ((ret != Z_OK) && (ret != Z_BUF_ERROR))
+			return false;
+		result.append(buffer, zlibBufferSize - stream.avail_out);
+	} while (stream.avail_out == 0);
+	
+	return true;
+}
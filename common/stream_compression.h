@@ -0,0 +1,33 @@
+#ifndef STREAM_COMPRESSION_H
+#define STREAM_COMPRESSION_H
+
+#include <QByteArray>
+#include <zlib.h>
+
+// Deflates a connection's outgoing data with one zlib context for the
+// whole lifetime of the stream, so that similar messages compress well.
+// If zlib cannot set up the stream, isValid() is false and the
+// connection must not use deflate.
+class StreamCompressor {
+private:
+	z_stream stream;
+	bool valid;
+public:
+	StreamCompressor(int level = Z_DEFAULT_COMPRESSION);
+	~StreamCompressor();
+	bool isValid() const { return valid; }
+	QByteArray compress(const QByteArray &data);
+};
+
+class StreamDecompressor {
+private:
+	z_stream stream;
+	bool valid;
+public:
+	StreamDecompressor();
+	~StreamDecompressor();
+	bool isValid() const { return valid; }
+	bool decompress(const QByteArray &data, QByteArray &result);
+};
+
+#endif
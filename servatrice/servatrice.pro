@@ -8,7 +8,7 @@ DEPENDPATH += . src ../common
 INCLUDEPATH += . src ../common
 MOC_DIR = build
 OBJECTS_DIR = build
-LIBS += -lgcrypt
+LIBS += -lgcrypt -lz
 
 CONFIG += qt debug
 QT += network sql
@@ -20,14 +20,20 @@ HEADERS += src/main.h \
 	src/server_logger.h \
 	src/serversocketthread.h \
 	src/passwordhasher.h \
+	src/databasepool.h \
+	src/bancache.h \
+	src/usercache.h \
+	src/databasejournal.h \
 	../common/color.h \
 	../common/serializable_item.h \
+	../common/stream_compression.h \
 	../common/decklist.h \
 	../common/protocol.h \
 	../common/protocol_items.h \
 	../common/protocol_datastructures.h \
 	../common/rng_abstract.h \
 	../common/rng_sfmt.h \
+	../common/rng_xoroshiro.h \
 	../common/server.h \
 	../common/server_arrow.h \
 	../common/server_card.h \
@@ -37,7 +43,10 @@ HEADERS += src/main.h \
 	../common/server_game.h \
 	../common/server_player.h \
 	../common/server_protocolhandler.h \
-	../common/server_arrowtarget.h
+	../common/server_arrowtarget.h \
+	../common/server_timerwheel.h \
+	../common/server_ratelimiter.h \
+	../common/server_gamestatecache.h
  
 SOURCES += src/main.cpp \
 	src/servatrice.cpp \
@@ -45,18 +54,28 @@ SOURCES += src/main.cpp \
 	src/server_logger.cpp \
 	src/serversocketthread.cpp \
 	src/passwordhasher.cpp \
+	src/databasepool.cpp \
+	src/bancache.cpp \
+	src/usercache.cpp \
+	src/databasejournal.cpp \
 	../common/serializable_item.cpp \
+	../common/stream_compression.cpp \
 	../common/decklist.cpp \
 	../common/protocol.cpp \
 	../common/protocol_items.cpp \
 	../common/protocol_datastructures.cpp \
 	../common/rng_abstract.cpp \
 	../common/rng_sfmt.cpp \
+	../common/rng_xoroshiro.cpp \
 	../common/sfmt/SFMT.c \
 	../common/server.cpp \
 	../common/server_card.cpp \
+	../common/server_arrowtarget.cpp \
 	../common/server_cardzone.cpp \
 	../common/server_room.cpp \
 	../common/server_game.cpp \
 	../common/server_player.cpp \
-	../common/server_protocolhandler.cpp
+	../common/server_protocolhandler.cpp \
+	../common/server_timerwheel.cpp \
+	../common/server_ratelimiter.cpp \
+	../common/server_gamestatecache.cpp
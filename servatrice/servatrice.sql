@@ -31,13 +31,29 @@ CREATE TABLE IF NOT EXISTS `cockatrice_decklist_files` (
   `user` varchar(35) NOT NULL,
   `name` varchar(50) NOT NULL,
   `upload_time` datetime NOT NULL,
-  `content` text NOT NULL,
+  `content_hash` char(40) NOT NULL default '',
+  `content` text,
   PRIMARY KEY  (`id`),
-  KEY `FolderPlusUser` (`id_folder`,`user`)
+  KEY `FolderPlusUser` (`id_folder`,`user`),
+  KEY `content_hash` (`content_hash`)
 ) ENGINE=MyISAM  DEFAULT CHARSET=latin1 AUTO_INCREMENT=550 ;
 
 -- --------------------------------------------------------
 
+--
+-- Deck files with identical content share one blob, keyed by the SHA-1 of the content.
+-- `content` in `decklist_files` is only used by decks uploaded before this table existed.
+-- Existing databases are upgraded with servatrice_decklist_blobs_migration.sql.
+--
+
+CREATE TABLE IF NOT EXISTS `cockatrice_decklist_blobs` (
+  `content_hash` char(40) NOT NULL,
+  `content` text NOT NULL,
+  PRIMARY KEY  (`content_hash`)
+) ENGINE=MyISAM DEFAULT CHARSET=latin1;
+
+-- --------------------------------------------------------
+
 --
 -- Tabellenstruktur für Tabelle `decklist_folders`
 --
@@ -0,0 +1,30 @@
+-- Upgrades a database created from an older servatrice.sql to shared deck blobs.
+-- Run it once, with the server stopped. The backfill can be run again if it is interrupted.
+
+/*!40101 SET NAMES utf8 */;
+
+ALTER TABLE `cockatrice_decklist_files`
+  ADD `content_hash` char(40) NOT NULL default '' AFTER `upload_time`,
+  MODIFY `content` text,
+  ADD KEY `content_hash` (`content_hash`);
+
+CREATE TABLE IF NOT EXISTS `cockatrice_decklist_blobs` (
+  `content_hash` char(40) NOT NULL,
+  `content` text NOT NULL,
+  PRIMARY KEY  (`content_hash`)
+) ENGINE=MyISAM DEFAULT CHARSET=latin1;
+
+--
+-- Backfill: the server hashes the UTF-8 encoded content, so the existing content is converted the same way.
+-- A file entry only drops its own copy once the blob it points to exists.
+--
+
+INSERT IGNORE INTO `cockatrice_decklist_blobs` (`content_hash`, `content`)
+  SELECT SHA1(CONVERT(`content` USING utf8)), `content`
+  FROM `cockatrice_decklist_files`
+  WHERE `content_hash` = '' AND `content` IS NOT NULL;
+
+UPDATE `cockatrice_decklist_files` f
+  JOIN `cockatrice_decklist_blobs` b ON b.`content_hash` = SHA1(CONVERT(f.`content` USING utf8))
+  SET f.`content_hash` = b.`content_hash`, f.`content` = NULL
+  WHERE f.`content_hash` = '' AND f.`content` IS NOT NULL;
@@ -0,0 +1,93 @@
+#include "bancache.h"
+#include <QDateTime>
+#include <algorithm>
+
+void BanCache::insertBan(QHash<QString, Ban> &bans, bool byAddress, const QString &key, uint timeFrom, int seconds)
+{
+	if (key.isEmpty())
+		return;
+	
+	QHash<QString, Ban>::iterator existing = bans.find(key);
+	if ((existing != bans.end()) && (existing.value().timeFrom > timeFrom))
+		return;
+	
+	Ban ban;
+	ban.timeFrom = timeFrom;
+	ban.permanent = (seconds == 0);
+	ban.expiry = timeFrom + seconds;
+	bans.insert(key, ban);
+	
+	if (!ban.permanent) {
+		Expiry expiry;
+		expiry.time = ban.expiry;
+		expiry.byAddress = byAddress;
+		expiry.key = key;
+		expiries.append(expiry);
+		std::push_heap(expiries.begin(), expiries.end());
+	}
+}
+
+void BanCache::removeExpired(uint now)
+{
+	while (!expiries.isEmpty() && (expiries.first().time <= now)) {
+		const Expiry expiry = expiries.first();
+		std::pop_heap(expiries.begin(), expiries.end());
+		expiries.removeLast();
+		
+		// The entry may have been replaced by a later ban since.
+		QHash<QString, Ban> &bans = expiry.byAddress ? addressBans : userNameBans;
+		QHash<QString, Ban>::iterator ban = bans.find(expiry.key);
+		if ((ban != bans.end()) && !ban.value().permanent && (ban.value().expiry <= now))
+			bans.erase(ban);
+	}
+}
+
+void BanCache::addBan(const QString &userName, const QString &address, uint timeFrom, int seconds)
+{
+	QMutexLocker locker(&mutex);
+	
+	insertBan(userNameBans, false, userName.toLower(), timeFrom, seconds);
+	insertBan(addressBans, true, address, timeFrom, seconds);
+}
+
+void BanCache::replace(BanCache &other, uint since)
+{
+	QMutexLocker locker(&mutex);
+	QMutexLocker otherLocker(&other.mutex);
+	
+	for (int i = 0; i < 2; ++i) {
+		const bool byAddress = (i == 1);
+		QHashIterator<QString, Ban> banIterator(byAddress ? addressBans : userNameBans);
+		while (banIterator.hasNext()) {
+			const Ban &ban = banIterator.next().value();
+			if (ban.timeFrom >= since)
+				other.insertBan(byAddress ? other.addressBans : other.userNameBans, byAddress, banIterator.key(), ban.timeFrom, ban.permanent ? 0 : ban.expiry - ban.timeFrom);
+		}
+	}
+	addressBans = other.addressBans;
+	userNameBans = other.userNameBans;
+	expiries = other.expiries;
+}
+
+bool BanCache::isAddressBanned(const QString &address)
+{
+	QMutexLocker locker(&mutex);
+	
+	removeExpired(QDateTime::currentDateTime().toTime_t());
+	return addressBans.contains(address);
+}
+
+bool BanCache::isUserNameBanned(const QString &userName)
+{
+	QMutexLocker locker(&mutex);
+	
+	removeExpired(QDateTime::currentDateTime().toTime_t());
+	// The database compares user names case-insensitively.
+	return userNameBans.contains(userName.toLower());
+}
+
+int BanCache::size() const
+{
+	QMutexLocker locker(&mutex);
+	return addressBans.size() + userNameBans.size();
+}
@@ -0,0 +1,45 @@
+#ifndef BANCACHE_H
+#define BANCACHE_H
+
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QString>
+
+// The bans that are in force, indexed by address and by user name, so
+// that logins don't need to ask the database. Like the old queries, only
+// the most recent ban for an address or a name counts. Timed bans are
+// dropped through a min-heap ordered by expiry. Thread-safe.
+class BanCache {
+private:
+	struct Ban {
+		uint timeFrom;
+		uint expiry;
+		bool permanent;
+	};
+	struct Expiry {
+		uint time;
+		bool byAddress;
+		QString key;
+		// Reversed, so that the std heap functions keep the earliest expiry on top.
+		bool operator<(const Expiry &other) const { return time > other.time; }
+	};
+	mutable QMutex mutex;
+	QHash<QString, Ban> addressBans, userNameBans;
+	QVector<Expiry> expiries;
+	
+	void insertBan(QHash<QString, Ban> &bans, bool byAddress, const QString &key, uint timeFrom, int seconds);
+	void removeExpired(uint now);
+public:
+	// Records a ban starting at timeFrom (seconds since the epoch) that lasts
+	// the given number of seconds, or forever if seconds is 0. Either key may be empty.
+	void addBan(const QString &userName, const QString &address, uint timeFrom, int seconds);
+	// Takes over the bans of a fresh load, so that lifted and shortened bans
+	// go away. Bans from since on are kept, as the load may have missed them.
+	void replace(BanCache &other, uint since);
+	bool isAddressBanned(const QString &address);
+	bool isUserNameBanned(const QString &userName);
+	int size() const;
+};
+
+#endif
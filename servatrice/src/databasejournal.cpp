@@ -0,0 +1,220 @@
+#include "databasejournal.h"
+#include "databasepool.h"
+#include <QFile>
+#include <QDataStream>
+#include <QStringList>
+#include <QDebug>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <stdio.h>
+#endif
+
+DatabaseJournal::DatabaseJournal(DatabasePool *_pool, const QString &_dbPrefix, const QString &_spoolFileName, int _maxBatchSize, int _flushInterval, QObject *parent)
+	: QThread(parent), pool(_pool), dbPrefix(_dbPrefix), spoolFileName(_spoolFileName), maxBatchSize(qMax(_maxBatchSize, 1)), flushInterval(qMax(_flushInterval, (int) minFlushInterval)), stopping(false), maxSpooledSessionId(0)
+{
+	const QList<Entry> spoolEntries = readSpool();
+	for (int i = 0; i < spoolEntries.size(); ++i)
+		if (spoolEntries[i].type == SessionStart)
+			maxSpooledSessionId = qMax(maxSpooledSessionId, spoolEntries[i].values[0].toInt());
+	if (!spoolEntries.isEmpty())
+		qDebug() << "Database journal:" << spoolEntries.size() << "spooled entries waiting";
+}
+
+DatabaseJournal::~DatabaseJournal()
+{
+	mutex.lock();
+	stopping = true;
+	batchFull.wakeAll();
+	mutex.unlock();
+	
+	wait();
+}
+
+void DatabaseJournal::addEntry(EntryType type, const QVariantList &values)
+{
+	Entry entry;
+	entry.type = type;
+	entry.values = values;
+	
+	QMutexLocker locker(&mutex);
+	entries.append(entry);
+	if (entries.size() >= maxBatchSize)
+		batchFull.wakeAll();
+}
+
+void DatabaseJournal::run()
+{
+	bool done = false;
+	while (!done) {
+		mutex.lock();
+		if (!stopping && (entries.size() < maxBatchSize))
+			batchFull.wait(&mutex, flushInterval);
+		QList<Entry> batch = entries;
+		entries.clear();
+		done = stopping;
+		mutex.unlock();
+		
+		writeEntries(batch);
+	}
+}
+
+QList<DatabaseJournal::Entry> DatabaseJournal::readSpool() const
+{
+	QList<Entry> result;
+	QFile file(spoolFileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return result;
+	
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_4_5);
+	while (!in.atEnd()) {
+		Entry entry;
+		qint32 type;
+		in >> type >> entry.values;
+		// A record cut short by a crash ends the spool.
+		if (in.status() != QDataStream::Ok)
+			break;
+		entry.type = type;
+		result.append(entry);
+	}
+	return result;
+}
+
+bool DatabaseJournal::syncFile(QFile &file)
+{
+	if (!file.flush())
+		return false;
+#ifdef Q_OS_UNIX
+	return fsync(file.handle()) == 0;
+#else
+	return true;
+#endif
+}
+
+bool DatabaseJournal::writeSpool(const QList<Entry> &spoolEntries, bool append) const
+{
+	// Replacing the spool goes through a temporary file, so that a crash
+	// leaves either the old or the new spool behind.
+	const QString fileName = append ? spoolFileName : (spoolFileName + ".tmp");
+	QFile file(fileName);
+	if (!file.open(append ? (QIODevice::WriteOnly | QIODevice::Append) : (QIODevice::WriteOnly | QIODevice::Truncate))) {
+		qCritical() << "Database journal: cannot open spool file" << fileName;
+		return false;
+	}
+	
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_4_5);
+	for (int i = 0; i < spoolEntries.size(); ++i)
+		out << (qint32) spoolEntries[i].type << spoolEntries[i].values;
+	if ((out.status() != QDataStream::Ok) || !syncFile(file)) {
+		qCritical() << "Database journal: cannot write spool file" << fileName;
+		return false;
+	}
+	file.close();
+	if (append)
+		return true;
+	
+#ifdef Q_OS_UNIX
+	if (::rename(QFile::encodeName(fileName).constData(), QFile::encodeName(spoolFileName).constData()) == 0)
+		return true;
+#else
+	// QFile::rename() doesn't overwrite, so this isn't atomic.
+	QFile::remove(spoolFileName);
+	if (QFile::rename(fileName, spoolFileName))
+		return true;
+#endif
+	qCritical() << "Database journal: cannot replace spool file" << spoolFileName;
+	return false;
+}
+
+bool DatabaseJournal::execBatch(int type, const QList<Entry> &batch)
+{
+	DatabaseQuery query;
+	QStringList rows;
+	switch (type) {
+		case SessionStart:
+			for (int i = 0; i < batch.size(); ++i)
+				rows.append(QString("(:id%1, :user_name%1, :ip_address%1, from_unixtime(:start_time%1))").arg(i));
+			query.prepare("insert ignore into " + dbPrefix + "_sessions (id, user_name, ip_address, start_time) values " + rows.join(", "));
+			for (int i = 0; i < batch.size(); ++i) {
+				query.bindValue(QString(":id%1").arg(i), batch[i].values[0]);
+				query.bindValue(QString(":user_name%1").arg(i), batch[i].values[1]);
+				query.bindValue(QString(":ip_address%1").arg(i), batch[i].values[2]);
+				query.bindValue(QString(":start_time%1").arg(i), batch[i].values[3]);
+			}
+			break;
+		case SessionEnd: {
+			QStringList ids;
+			for (int i = 0; i < batch.size(); ++i) {
+				rows.append(QString("when :id%1 then from_unixtime(:end_time%1)").arg(i));
+				ids.append(QString(":where_id%1").arg(i));
+			}
+			query.prepare("update " + dbPrefix + "_sessions set end_time = case id " + rows.join(" ") + " end where id in (" + ids.join(", ") + ")");
+			for (int i = 0; i < batch.size(); ++i) {
+				query.bindValue(QString(":id%1").arg(i), batch[i].values[0]);
+				query.bindValue(QString(":end_time%1").arg(i), batch[i].values[1]);
+				query.bindValue(QString(":where_id%1").arg(i), batch[i].values[0]);
+			}
+			break;
+		}
+		case Uptime:
+			for (int i = 0; i < batch.size(); ++i)
+				rows.append(QString("(:id%1, from_unixtime(:timest%1), :uptime%1, :users_count%1, :games_count%1, :tx%1, :rx%1)").arg(i));
+			query.prepare("insert ignore into " + dbPrefix + "_uptime (id_server, timest, uptime, users_count, games_count, tx_bytes, rx_bytes) values " + rows.join(", "));
+			for (int i = 0; i < batch.size(); ++i) {
+				query.bindValue(QString(":id%1").arg(i), batch[i].values[0]);
+				query.bindValue(QString(":timest%1").arg(i), batch[i].values[1]);
+				query.bindValue(QString(":uptime%1").arg(i), batch[i].values[2]);
+				query.bindValue(QString(":users_count%1").arg(i), batch[i].values[3]);
+				query.bindValue(QString(":games_count%1").arg(i), batch[i].values[4]);
+				query.bindValue(QString(":tx%1").arg(i), batch[i].values[5]);
+				query.bindValue(QString(":rx%1").arg(i), batch[i].values[6]);
+			}
+			break;
+		default:
+			return true;
+	}
+	return pool->execSync(query);
+}
+
+void DatabaseJournal::writeEntries(const QList<Entry> &batch)
+{
+	const QList<Entry> spoolEntries = readSpool();
+	if (spoolEntries.isEmpty() && batch.isEmpty())
+		return;
+	
+	// Sessions are started before any are ended, so that an end never
+	// overtakes the start it belongs to.
+	QList<Entry> byType[3];
+	const QList<Entry> all = spoolEntries + batch;
+	for (int i = 0; i < all.size(); ++i)
+		if ((all[i].type >= 0) && (all[i].type < 3))
+			byType[all[i].type].append(all[i]);
+	
+	bool anyWritten = false;
+	for (int type = 0; type < 3; ++type)
+		for (int pos = 0; pos < byType[type].size(); pos += maxBatchSize) {
+			if (execBatch(type, byType[type].mid(pos, maxBatchSize))) {
+				anyWritten = true;
+				continue;
+			}
+			
+			qCritical() << "Database journal: writing failed, spooling to" << spoolFileName;
+			if (!anyWritten) {
+				// The spool is still the same, only the new entries need adding.
+				if (!writeSpool(batch, true))
+					qCritical() << "Database journal:" << batch.size() << "entries lost";
+			} else {
+				QList<Entry> remaining = byType[type].mid(pos);
+				for (int laterType = type + 1; laterType < 3; ++laterType)
+					remaining += byType[laterType];
+				// If this fails, the old spool stays and is written again. The
+				// inserts ignore rows that are already there.
+				writeSpool(remaining, false);
+			}
+			return;
+		}
+	
+	if (!spoolEntries.isEmpty())
+		QFile::remove(spoolFileName);
+}
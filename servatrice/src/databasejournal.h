@@ -0,0 +1,61 @@
+#ifndef DATABASEJOURNAL_H
+#define DATABASEJOURNAL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVariant>
+#include <QList>
+
+class QFile;
+class DatabasePool;
+
+// Collects the session and uptime records and writes them in the
+// background, several rows per statement, whenever enough have piled up
+// or the flush interval has passed. Batches that can't be written are
+// appended to a local spool file, which is synced to disk before they are
+// dropped from memory, and written together with the next batch, also
+// after a restart.
+class DatabaseJournal : public QThread {
+	Q_OBJECT
+public:
+	enum EntryType {
+		SessionStart = 0,	// id, user name, address, start time
+		SessionEnd = 1,		// id, end time
+		Uptime = 2		// server id, time, uptime, users, games, tx bytes, rx bytes
+	};
+private:
+	struct Entry {
+		int type;
+		QVariantList values;
+	};
+	DatabasePool *pool;
+	QString dbPrefix;
+	QString spoolFileName;
+	// A shorter interval would have run() spin, reading the spool every pass.
+	static const int minFlushInterval = 100;
+	int maxBatchSize, flushInterval;
+	QMutex mutex;
+	QWaitCondition batchFull;
+	QList<Entry> entries;
+	bool stopping;
+	int maxSpooledSessionId;
+	
+	static bool syncFile(QFile &file);
+	QList<Entry> readSpool() const;
+	bool writeSpool(const QList<Entry> &spoolEntries, bool append) const;
+	bool execBatch(int type, const QList<Entry> &batch);
+	void writeEntries(const QList<Entry> &batch);
+protected:
+	void run();
+public:
+	// Times are in seconds since the epoch, the flush interval is in milliseconds.
+	DatabaseJournal(DatabasePool *_pool, const QString &_dbPrefix, const QString &_spoolFileName, int _maxBatchSize, int _flushInterval, QObject *parent = 0);
+	// Writes out everything still queued.
+	~DatabaseJournal();
+	// Session ids are assigned by the server, so those waiting in the spool must not be handed out again.
+	int getMaxSpooledSessionId() const { return maxSpooledSessionId; }
+	void addEntry(EntryType type, const QVariantList &values);
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "databasepool.h"
+#include <QtSql>
+#include <QDebug>
+
+DatabaseQuery::DatabaseQuery(const QString &_queryString, QObject *parent)
+	: QObject(parent), queryString(_queryString), async(false), done(false), success(false), currentRow(-1)
+{
+}
+
+void DatabaseQuery::prepare(const QString &_queryString)
+{
+	queryString = _queryString;
+	boundValues.clear();
+	rows.clear();
+	currentRow = -1;
+	insertId = QVariant();
+	errorText.clear();
+	done = false;
+	success = false;
+}
+
+void DatabaseQuery::bindValue(const QString &placeholder, const QVariant &value)
+{
+	boundValues.append(QPair<QString, QVariant>(placeholder, value));
+}
+
+bool DatabaseQuery::next()
+{
+	if (currentRow + 1 >= rows.size())
+		return false;
+	++currentRow;
+	return true;
+}
+
+QVariant DatabaseQuery::value(int index) const
+{
+	if ((currentRow < 0) || (currentRow >= rows.size()))
+		return QVariant();
+	return rows[currentRow].value(index);
+}
+
+bool DatabaseQuery::exec(QSqlDatabase &db)
+{
+	QSqlQuery query(db);
+	query.prepare(queryString);
+	for (int i = 0; i < boundValues.size(); ++i)
+		query.bindValue(boundValues[i].first, boundValues[i].second);
+	if (!query.exec()) {
+		errorText = query.lastError().text();
+		return false;
+	}
+
+	const int columns = query.record().count();
+	while (query.next()) {
+		QVariantList row;
+		for (int i = 0; i < columns; ++i)
+			row.append(query.value(i));
+		rows.append(row);
+	}
+	insertId = query.lastInsertId();
+	errorText.clear();
+	return true;
+}
+
+void DatabaseTask::waitForFinished()
+{
+	QMutexLocker locker(&doneMutex);
+	while (!done)
+		doneCondition.wait(&doneMutex);
+}
+
+DatabaseConnection::DatabaseConnection(DatabasePool *_pool, int _number)
+	: QThread(_pool), pool(_pool), connectionName("servatrice_" + QString::number(_number)), db(0)
+{
+}
+
+bool DatabaseConnection::openDatabase(QSqlDatabase &db)
+{
+	if (db.isOpen())
+		db.close();
+	if (db.open())
+		return true;
+	qCritical() << "Database error:" << connectionName << db.lastError().text();
+	return false;
+}
+
+bool DatabaseConnection::execQuery(DatabaseQuery &query)
+{
+	query.rows.clear();
+	query.currentRow = -1;
+	bool success = query.exec(*db);
+	// Only check the connection after a failure; reconnect and retry once.
+	if (!success && !db->exec("select 1").isActive())
+		if (openDatabase(*db))
+			success = query.exec(*db);
+	query.success = success;
+	return success;
+}
+
+void DatabaseConnection::run()
+{
+	{
+		QSqlDatabase database = QSqlDatabase::addDatabase("QMYSQL", connectionName);
+		database.setHostName(pool->hostName);
+		database.setDatabaseName(pool->databaseName);
+		database.setUserName(pool->userName);
+		database.setPassword(pool->password);
+		db = &database;
+		openDatabase(database);
+
+		DatabaseQuery *query;
+		DatabaseTask *task;
+		while (pool->takeWork(query, task)) {
+			if (query) {
+				execQuery(*query);
+				pool->queryDone(query);
+			} else {
+				task->run();
+				pool->taskDone(task);
+			}
+		}
+		db = 0;
+		database.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+}
+
+DatabasePool::DatabasePool(const QString &_hostName, const QString &_databaseName, const QString &_userName, const QString &_password, int numberOfConnections, QObject *parent)
+	: QObject(parent), hostName(_hostName), databaseName(_databaseName), userName(_userName), password(_password), stopping(false)
+{
+	for (int i = 0; i < numberOfConnections; ++i) {
+		DatabaseConnection *connection = new DatabaseConnection(this, i);
+		connection->start();
+		connections.append(connection);
+	}
+}
+
+DatabasePool::~DatabasePool()
+{
+	// Queued queries are still run before the connections close.
+	queueMutex.lock();
+	stopping = true;
+	queueNotEmpty.wakeAll();
+	queueMutex.unlock();
+
+	for (int i = 0; i < connections.size(); ++i) {
+		connections[i]->wait();
+		delete connections[i];
+	}
+}
+
+bool DatabasePool::takeWork(DatabaseQuery *&query, DatabaseTask *&task)
+{
+	QMutexLocker locker(&queueMutex);
+	while (queue.isEmpty()) {
+		if (stopping)
+			return false;
+		queueNotEmpty.wait(&queueMutex);
+	}
+	QPair<DatabaseQuery *, DatabaseTask *> entry = queue.takeFirst();
+	query = entry.first;
+	task = entry.second;
+	return true;
+}
+
+void DatabasePool::queryDone(DatabaseQuery *query)
+{
+	if (!query->success)
+		qCritical() << "Database error:" << query->errorText;
+
+	if (query->async) {
+		emit query->finished();
+		return;
+	}
+
+	QMutexLocker locker(&queueMutex);
+	query->done = true;
+	query->doneCondition.wakeAll();
+}
+
+void DatabasePool::taskDone(DatabaseTask *task)
+{
+	// finished() comes last, since it is commonly connected to deleteLater().
+	task->doneMutex.lock();
+	task->done = true;
+	task->doneCondition.wakeAll();
+	task->doneMutex.unlock();
+	
+	emit task->finished();
+}
+
+bool DatabasePool::execSync(DatabaseQuery &query)
+{
+	// Within a task, the query runs right away on the task's connection.
+	// Queueing it could deadlock once every connection runs such a task.
+	DatabaseConnection *connection = qobject_cast<DatabaseConnection *>(QThread::currentThread());
+	if (connection && (connection->pool == this)) {
+		query.async = false;
+		if (!connection->execQuery(query))
+			qCritical() << "Database error:" << query.errorText;
+		query.done = true;
+		return query.success;
+	}
+	
+	QMutexLocker locker(&queueMutex);
+	query.async = false;
+	query.done = false;
+	query.rows.clear();
+	query.currentRow = -1;
+	queue.append(QPair<DatabaseQuery *, DatabaseTask *>(&query, 0));
+	queueNotEmpty.wakeOne();
+	while (!query.done)
+		query.doneCondition.wait(&queueMutex);
+	return query.success;
+}
+
+void DatabasePool::execAsync(DatabaseQuery *query)
+{
+	QMutexLocker locker(&queueMutex);
+	query->async = true;
+	query->done = false;
+	query->rows.clear();
+	query->currentRow = -1;
+	queue.append(QPair<DatabaseQuery *, DatabaseTask *>(query, 0));
+	queueNotEmpty.wakeOne();
+}
+
+void DatabasePool::startTask(DatabaseTask *task)
+{
+	QMutexLocker locker(&queueMutex);
+	task->done = false;
+	queue.append(QPair<DatabaseQuery *, DatabaseTask *>(0, task));
+	queueNotEmpty.wakeOne();
+}
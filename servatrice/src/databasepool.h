@@ -0,0 +1,115 @@
+#ifndef DATABASEPOOL_H
+#define DATABASEPOOL_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QVariant>
+#include <QPair>
+
+class QSqlDatabase;
+class DatabasePool;
+
+// A query that is executed by one of the pool's connection threads.
+// The result rows are copied out so that they can be read in any thread.
+class DatabaseQuery : public QObject {
+	Q_OBJECT
+	friend class DatabasePool;
+	friend class DatabaseConnection;
+signals:
+	// Emitted in the connection thread after an asynchronous query has run.
+	void finished();
+private:
+	QString queryString;
+	QList<QPair<QString, QVariant> > boundValues;
+	bool async, done, success;
+	QString errorText;
+	QList<QVariantList> rows;
+	int currentRow;
+	QVariant insertId;
+	QWaitCondition doneCondition;
+
+	bool exec(QSqlDatabase &db);
+public:
+	DatabaseQuery(const QString &_queryString = QString(), QObject *parent = 0);
+	void prepare(const QString &_queryString);
+	void bindValue(const QString &placeholder, const QVariant &value);
+
+	bool getSuccess() const { return success; }
+	QString getErrorText() const { return errorText; }
+	bool next();
+	QVariant value(int index) const;
+	QVariant lastInsertId() const { return insertId; }
+};
+
+// Work that runs several queries one after the other, e.g. a command that
+// needs the result of one query for the next. run() is called in one of the
+// pool's connection threads, and DatabasePool::execSync() called from there
+// uses that thread's connection directly.
+class DatabaseTask : public QObject {
+	Q_OBJECT
+	friend class DatabasePool;
+	friend class DatabaseConnection;
+signals:
+	// Emitted in the connection thread after run() has returned.
+	void finished();
+private:
+	QMutex doneMutex;
+	QWaitCondition doneCondition;
+	bool done;
+protected:
+	virtual void run() = 0;
+public:
+	DatabaseTask(QObject *parent = 0) : QObject(parent), done(false) { }
+	// Blocks until run() has returned. Only call this for a started task.
+	void waitForFinished();
+};
+
+// Owns one database connection, which is only ever used from this thread.
+class DatabaseConnection : public QThread {
+	Q_OBJECT
+	friend class DatabasePool;
+private:
+	DatabasePool *pool;
+	QString connectionName;
+	QSqlDatabase *db;
+	bool openDatabase(QSqlDatabase &db);
+	bool execQuery(DatabaseQuery &query);
+protected:
+	void run();
+public:
+	DatabaseConnection(DatabasePool *_pool, int _number);
+};
+
+class DatabasePool : public QObject {
+	Q_OBJECT
+	friend class DatabaseConnection;
+private:
+	QString hostName, databaseName, userName, password;
+	QList<DatabaseConnection *> connections;
+	QMutex queueMutex;
+	QWaitCondition queueNotEmpty;
+	// Every entry holds either a query or a task.
+	QList<QPair<DatabaseQuery *, DatabaseTask *> > queue;
+	bool stopping;
+
+	bool takeWork(DatabaseQuery *&query, DatabaseTask *&task);
+	void queryDone(DatabaseQuery *query);
+	void taskDone(DatabaseTask *task);
+public:
+	DatabasePool(const QString &_hostName, const QString &_databaseName, const QString &_userName, const QString &_password, int numberOfConnections, QObject *parent = 0);
+	~DatabasePool();
+
+	// Blocks the calling thread, but no other, until the query has run.
+	bool execSync(DatabaseQuery &query);
+	// Returns immediately. Connect to DatabaseQuery::finished() for the
+	// result. The pool doesn't take ownership, so the query must stay alive
+	// until then.
+	void execAsync(DatabaseQuery *query);
+	// Returns immediately. The task must stay alive until it has finished.
+	void startTask(DatabaseTask *task);
+};
+
+#endif
@@ -24,10 +24,22 @@
 #include <QMetaType>
 #include <QSettings>
 #include <QDateTime>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QSemaphore>
+#include <QHostAddress>
+#include "main.h"
 #include "passwordhasher.h"
 #include "servatrice.h"
 #include "server_logger.h"
 #include "rng_sfmt.h"
+#include "rng_xoroshiro.h"
+#include "server.h"
+#include "server_room.h"
+#include "server_game.h"
+#include "server_protocolhandler.h"
+#include "bancache.h"
+#include "protocol_items.h"
 #ifdef Q_OS_UNIX
 #include <signal.h>
 #endif
@@ -36,7 +48,25 @@ RNG_Abstract *rng;
 ServerLogger *logger;
 ServerLoggerThread *loggerThread;
 
-void testRNG()
+// Prints the result of a check and passes it on.
+bool checkResult(const std::string &name, bool ok)
+{
+	std::cerr << name << ": " << (ok ? "OK" : "FAILED") << std::endl;
+	return ok;
+}
+
+bool testRNGEdgeCases(RNG_Abstract *r)
+{
+	// Empty and single-value ranges must not divide by zero.
+	const unsigned int emptyRange = r->getNumber(1, 0);
+	const unsigned int singleValue = r->getNumber(5, 5);
+	bool ok = checkResult("getNumber(1, 0) = " + QString::number(emptyRange).toStdString(), emptyRange == 1);
+	ok = checkResult("getNumber(5, 5) = " + QString::number(singleValue).toStdString(), singleValue == 5) && ok;
+	std::cerr << std::endl;
+	return ok;
+}
+
+bool testRNG()
 {
 	const int n = 500000;
 	std::cerr << "Testing random number generator (n = " << n << " * bins)..." << std::endl;
@@ -68,6 +98,52 @@ void testRNG()
 	for (int j = 0; j < chisq.size(); ++j)
 		std::cerr << "\t" << (j - min + minMax);
 	std::cerr << std::endl << std::endl;
+	
+	bool ok = testRNGEdgeCases(rng);
+	RNG_Xoroshiro gameRng(RNG_Xoroshiro::generateSeed());
+	return testRNGEdgeCases(&gameRng) && ok;
+}
+
+void testShuffle()
+{
+	const int n = 100000;
+	const int deckSize = 60;
+	std::cerr << "Benchmarking shuffle (n = " << n << " decks of " << deckSize << " cards)..." << std::endl;
+	
+	QList<int> deck;
+	for (int i = 0; i < deckSize; ++i)
+		deck.append(i);
+	
+	// The algorithm Server_CardZone::shuffle() used before, for comparison.
+	QTime startTime;
+	startTime.start();
+	for (int j = 0; j < n; ++j) {
+		QList<int> temp;
+		for (int i = deck.size(); i; i--)
+			temp.append(deck.takeAt(rng->getNumber(0, i - 1)));
+		deck = temp;
+	}
+	std::cerr << "takeAt:\t\t" << startTime.elapsed() << " msecs" << std::endl;
+	
+	startTime.start();
+	for (int j = 0; j < n; ++j)
+		rng->shuffle(deck);
+	std::cerr << "Fisher-Yates:\t" << startTime.elapsed() << " msecs" << std::endl;
+	
+	// Every card should end up in every position equally often.
+	const int bins = 10;
+	QVector<int> positions(bins);
+	QList<int> small;
+	for (int i = 0; i < bins; ++i)
+		small.append(i);
+	for (int j = 0; j < n * bins; ++j) {
+		rng->shuffle(small);
+		positions[small.indexOf(0)]++;
+	}
+	std::cerr << "Position of card 0:";
+	for (int i = 0; i < bins; ++i)
+		std::cerr << "\t" << positions[i];
+	std::cerr << std::endl << "Chi^2 = " << QString::number(rng->testRandom(positions), 'f', 3).toStdString() << ", k = " << (bins - 1) << std::endl << std::endl;
 }
 
 void testHash()
@@ -81,6 +157,311 @@ void testHash()
 	std::cerr << startTime.secsTo(endTime) << "secs" << std::endl;
 }
 
+// Counts finished checks so that the benchmark knows when the burst is done.
+class BenchmarkPasswordCheck : public PasswordCheck {
+private:
+	QSemaphore *done;
+protected:
+	void run()
+	{
+		PasswordCheck::run();
+		done->release();
+	}
+public:
+	BenchmarkPasswordCheck(const QHostAddress &_address, const QString &_password, const QString &_correctHash, QSemaphore *_done)
+		: PasswordCheck(_address, _password, _correctHash), done(_done) { }
+};
+
+void testLoginBurst()
+{
+	const int addresses = 250;
+	const int loginsPerAddress = 4;
+	const int maxLoginsPerAddress = 2;
+	int threads = QThread::idealThreadCount();
+	if (threads <= 0)
+		threads = 1;
+	std::cerr << "Benchmarking password checks (burst of " << addresses * loginsPerAddress << " logins from " << addresses << " addresses, " << threads << " threads)..." << std::endl;
+	
+	const QString correctHash = PasswordHasher::computeHash("aaaaaa", "aaaaaaaaaaaaaaaa");
+	PasswordHasherPool *pool = new PasswordHasherPool(threads, maxLoginsPerAddress);
+	QSemaphore done;
+	QList<PasswordCheck *> checks;
+	int rejected = 0;
+	
+	QTime startTime;
+	startTime.start();
+	for (int i = 0; i < loginsPerAddress; ++i)
+		for (int j = 0; j < addresses; ++j) {
+			PasswordCheck *check = new BenchmarkPasswordCheck(QHostAddress(0x0a000000 + j), (i % 2) ? "aaaaaa" : "bbbbbb", correctHash, &done);
+			if (pool->start(check))
+				checks.append(check);
+			else {
+				delete check;
+				++rejected;
+			}
+		}
+	done.acquire(checks.size());
+	int elapsed = startTime.elapsed();
+	
+	// The pool threads may still be touching the last checks.
+	delete pool;
+	int accepted = 0;
+	for (int i = 0; i < checks.size(); ++i)
+		if (checks[i]->getAccepted())
+			++accepted;
+	qDeleteAll(checks);
+	
+	std::cerr << checks.size() << " logins checked (" << accepted << " accepted, " << rejected << " rejected by the per-address limit) in " << elapsed << " msecs";
+	if (elapsed)
+		std::cerr << " (" << (checks.size() * 1000.0 / elapsed) << " logins/sec)";
+	std::cerr << std::endl;
+}
+
+// Just enough of a server to host a game in a room.
+class TestServer : public Server {
+protected:
+	int startSession(const QString & /*userName*/, const QString & /*address*/) { return -1; }
+	void endSession(int /*sessionId*/) { }
+	bool userExists(const QString & /*user*/) { return false; }
+	AuthenticationResult checkUserPassword(Server_ProtocolHandler * /*handler*/, const QString & /*user*/, const QString & /*password*/) { return UnknownUser; }
+	ServerInfo_User *getUserData(const QString &name) { return new ServerInfo_User(name); }
+public:
+	QString getLoginMessage() const { return QString(); }
+	bool getGameShouldPing() const { return false; }
+	int getMaxGameInactivityTime() const { return 0; }
+	int getMaxPlayerInactivityTime() const { return 0; }
+	bool getThreaded() const { return false; }
+	QMap<QString, ServerInfo_User *> getBuddyList(const QString & /*name*/) { return QMap<QString, ServerInfo_User *>(); }
+	QMap<QString, ServerInfo_User *> getIgnoreList(const QString & /*name*/) { return QMap<QString, ServerInfo_User *>(); }
+};
+
+// A logged in user without a connection. Counts the Event_Join containers
+// it gets, and how many of them are marked as state replay.
+class TestProtocolHandler : public Server_ProtocolHandler {
+private:
+	DeckList *getDeckFromDatabase(int /*deckId*/) { return 0; }
+	ResponseCode cmdAddToList(Command_AddToList * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdRemoveFromList(Command_RemoveFromList * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdDeckList(Command_DeckList * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdDeckNewDir(Command_DeckNewDir * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdDeckDelDir(Command_DeckDelDir * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdDeckDel(Command_DeckDel * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdDeckUpload(Command_DeckUpload * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdDeckDownload(Command_DeckDownload * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdBanFromServer(Command_BanFromServer * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdShutdownServer(Command_ShutdownServer * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+	ResponseCode cmdUpdateServerMessage(Command_UpdateServerMessage * /*cmd*/, CommandContainer * /*cont*/) { return RespInvalidCommand; }
+protected:
+	bool getCompressionSupport() const { return false; }
+public:
+	int joins, replayedJoins;
+	TestProtocolHandler(Server *_server, const QString &_name)
+		: Server_ProtocolHandler(_server), joins(0), replayedJoins(0)
+	{
+		authState = PasswordRight;
+		userInfo = new ServerInfo_User(_name, ServerInfo_User::IsUser | ServerInfo_User::IsRegistered);
+		server->addClient(this);
+	}
+	~TestProtocolHandler()
+	{
+		prepareDestroy();
+	}
+	QString getAddress() const { return QString(); }
+	void sendProtocolItem(ProtocolItem *item, bool deleteItem = true)
+	{
+		GameEventContainer *cont = qobject_cast<GameEventContainer *>(item);
+		if (cont && !cont->getEventList().isEmpty() && qobject_cast<Event_Join *>(cont->getEventList().first())) {
+			++joins;
+			if (qobject_cast<Context_StateReplay *>(cont->getContext()))
+				++replayedJoins;
+		}
+		if (deleteItem)
+			delete item;
+	}
+};
+
+// Whether the items are a game state snapshot followed by joins marked as state replay.
+bool isJoinState(const QList<QSharedPointer<EncodedProtocolItem> > &items, int joins)
+{
+	if (items.size() != joins + 1)
+		return false;
+	for (int i = 0; i < items.size(); ++i) {
+		GameEventContainer *cont = qobject_cast<GameEventContainer *>(items[i]->getItem());
+		if (!cont || (cont->getEventList().size() != 1))
+			return false;
+		if (i == 0) {
+			if (!qobject_cast<Event_GameStateChanged *>(cont->getEventList().first()))
+				return false;
+		} else if (!qobject_cast<Event_Join *>(cont->getEventList().first()) || !qobject_cast<Context_StateReplay *>(cont->getContext()))
+			return false;
+	}
+	return true;
+}
+
+bool testGameStateCache()
+{
+	std::cerr << "Testing game state cache..." << std::endl;
+	
+	TestServer *server = new TestServer;
+	Server_Room *room = new Server_Room(0, "Test", QString(), false, QString(), QStringList(), server);
+	TestProtocolHandler *creator = new TestProtocolHandler(server, "Creator");
+	TestProtocolHandler *spectator1 = new TestProtocolHandler(server, "Spectator1");
+	TestProtocolHandler *spectator2 = new TestProtocolHandler(server, "Spectator2");
+	TestProtocolHandler *spectator3 = new TestProtocolHandler(server, "Spectator3");
+	
+	Server_Game *game = room->createGame(QString(), QString(), 2, QList<int>(), false, false, true, false, true, false, creator);
+	QList<QSharedPointer<EncodedProtocolItem> > first, second, third;
+	game->addPlayer(spectator1, true, false, &first);
+	game->addPlayer(spectator2, true, false, &second);
+	
+	// The second spectator gets the same snapshot and both joins, its own included.
+	bool ok = checkResult("First spectator join", isJoinState(first, 1));
+	ok = checkResult("Second spectator join reuses the snapshot", isJoinState(second, 2) && (second[0] == first[0]) && (second[1] == first[1])) && ok;
+	// Players already in the game get live joins.
+	ok = checkResult("Live joins", (creator->joins == 2) && (creator->replayedJoins == 0) && (spectator1->joins == 1) && (spectator1->replayedJoins == 0)) && ok;
+	
+	game->gameStateChanged();
+	game->addPlayer(spectator3, true, false, &third);
+	ok = checkResult("Join after a state change", isJoinState(third, 1) && (third[0] != first[0])) && ok;
+	std::cerr << std::endl;
+	
+	// The game closes with the room and removes its players from the handlers.
+	delete room;
+	delete creator;
+	delete spectator1;
+	delete spectator2;
+	delete spectator3;
+	delete server;
+	return ok;
+}
+
+bool testBanCache()
+{
+	std::cerr << "Testing ban cache..." << std::endl;
+	
+	const uint now = QDateTime::currentDateTime().toTime_t();
+	BanCache cache;
+	cache.addBan("Lifted", "10.0.0.1", now - 120, 0);
+	cache.addBan("Shortened", "10.0.0.2", now - 120, 60 * 60);
+	cache.addBan("Local", "10.0.0.3", now, 0);
+	
+	// A reload started a minute ago, after the first ban was deleted and the
+	// second one shortened to a minute, and before the third one was issued.
+	BanCache freshBans;
+	freshBans.addBan("Shortened", "10.0.0.2", now - 120, 60);
+	cache.replace(freshBans, now - 60);
+	
+	const bool lifted = !cache.isUserNameBanned("lifted") && !cache.isAddressBanned("10.0.0.1");
+	const bool shortened = !cache.isUserNameBanned("Shortened") && !cache.isAddressBanned("10.0.0.2");
+	const bool kept = cache.isUserNameBanned("Local") && cache.isAddressBanned("10.0.0.3");
+	bool ok = checkResult("Lifted ban", lifted);
+	ok = checkResult("Shortened ban", shortened) && ok;
+	ok = checkResult("Ban issued during the reload", kept) && ok;
+	std::cerr << std::endl;
+	return ok;
+}
+
+// Whether the items read back encode to the same XML as the ones sent.
+bool sameItems(const QList<QByteArray> &sent, const QList<ProtocolItem *> &received)
+{
+	if (sent.size() != received.size())
+		return false;
+	for (int i = 0; i < sent.size(); ++i) {
+		if (!received[i])
+			return false;
+		EncodedProtocolItem encoded(received[i]);
+		if (encoded.getXmlData() != sent[i])
+			return false;
+	}
+	return true;
+}
+
+void printParserTime(const char *encoding, int received, int elapsed)
+{
+	std::cerr << encoding << ": " << received << " commands in " << elapsed << " msecs";
+	if (received)
+		std::cerr << " (" << (elapsed * 1000.0 / received) << " usecs/command)";
+	std::cerr << std::endl;
+}
+
+bool testParser()
+{
+	const int n = 100000;
+	const int chunkSize = 1024;
+	std::cerr << "Benchmarking protocol parser (n = " << n << " commands)..." << std::endl;
+	
+	ProtocolItem::initializeHash();
+	
+	// Roughly what a client sends during a game, once as XML and once in
+	// binary frames.
+	QByteArray stream, binaryStream;
+	QList<QByteArray> sent;
+	bool framesWritten = true;
+	QXmlStreamWriter writer(&stream);
+	writer.writeStartDocument();
+	writer.writeStartElement("cockatrice_client_stream");
+	for (int i = 0; i < n; ++i) {
+		Command *cmd;
+		switch (i % 4) {
+			case 0: cmd = new Command_Ping; break;
+			case 1: cmd = new Command_Say(1, "Hello & welcome"); break;
+			case 2: cmd = new Command_SetCardAttr(1, "table", i, "tapped", "1"); break;
+			default: cmd = new Command_CreateArrow(1, 0, "table", i, 1, "table", i + 1, Color(255, 0, 0));
+		}
+		CommandContainer cont(QList<Command *>() << cmd);
+		cont.write(&writer);
+		if (!cont.writeBinaryFrame(binaryStream))
+			framesWritten = false;
+		sent.append(EncodedProtocolItem(&cont).getXmlData());
+	}
+	
+	QTime startTime;
+	startTime.start();
+	
+	QXmlStreamReader xml;
+	SerializableItem *currentItem = 0;
+	QList<ProtocolItem *> received;
+	bool unknownItem = false;
+	for (int pos = 0; (pos < stream.size()) && !unknownItem; pos += chunkSize) {
+		xml.addData(stream.mid(pos, chunkSize));
+		while (!xml.atEnd()) {
+			xml.readNext();
+			if (currentItem) {
+				if (currentItem->read(&xml)) {
+					received.append(dynamic_cast<ProtocolItem *>(currentItem));
+					currentItem = 0;
+				}
+			} else if (xml.isStartElement() && (xml.name() != QLatin1String("cockatrice_client_stream"))) {
+				currentItem = SerializableItem::getNewItem(xml.name().toString() + xml.attributes().value(QLatin1String("type")).toString());
+				if (!currentItem) {
+					unknownItem = true;
+					break;
+				}
+				currentItem->read(&xml);
+			}
+		}
+	}
+	delete currentItem;
+	printParserTime("XML", received.size(), startTime.elapsed());
+	bool ok = checkResult("XML round trip", !unknownItem && sameItems(sent, received));
+	qDeleteAll(received);
+	
+	startTime.start();
+	
+	TopLevelProtocolItem binaryReader;
+	ParserTestReceiver receiver;
+	QObject::connect(&binaryReader, SIGNAL(protocolItemReceived(ProtocolItem *)), &receiver, SLOT(protocolItemReceived(ProtocolItem *)));
+	bool framesRead = true;
+	for (int pos = 0; (pos < binaryStream.size()) && framesRead; pos += chunkSize)
+		framesRead = binaryReader.readBinaryData(binaryStream.mid(pos, chunkSize));
+	printParserTime("Binary", receiver.items.size(), startTime.elapsed());
+	ok = checkResult("Binary round trip", framesWritten && framesRead && sameItems(sent, receiver.items)) && ok;
+	qDeleteAll(receiver.items);
+	std::cerr << std::endl;
+	
+	return ok;
+}
+
 void myMessageOutput(QtMsgType /*type*/, const char *msg)
 {
 	logger->logMessage(msg);
@@ -106,7 +487,12 @@ int main(int argc, char *argv[])
 	
 	QStringList args = app.arguments();
 	bool testRandom = args.contains("--test-random");
+	bool testShuffleFunction = args.contains("--test-shuffle");
 	bool testHashFunction = args.contains("--test-hash");
+	bool testProtocolParser = args.contains("--test-parser");
+	bool testLoginBurstFunction = args.contains("--test-login-burst");
+	bool testGameStateCacheFunction = args.contains("--test-game-state-cache");
+	bool testBanCacheFunction = args.contains("--test-bans");
 	
 	qRegisterMetaType<QList<int> >("QList<int>");
 	
@@ -140,10 +526,31 @@ int main(int argc, char *argv[])
 	std::cerr << "Servatrice " << Servatrice::versionString.toStdString() << " starting." << std::endl;
 	std::cerr << "-------------------------" << std::endl;
 	
-	if (testRandom)
-		testRNG();
-	if (testHashFunction)
-		testHash();
+	// The tests and benchmarks run instead of the server. A failed test
+	// makes the exit status non-zero.
+	if (testRandom || testShuffleFunction || testHashFunction || testProtocolParser || testLoginBurstFunction || testGameStateCacheFunction || testBanCacheFunction) {
+		bool testsPassed = true;
+		if (testRandom)
+			testsPassed = testRNG() && testsPassed;
+		if (testShuffleFunction)
+			testShuffle();
+		if (testHashFunction)
+			testHash();
+		if (testProtocolParser)
+			testsPassed = testParser() && testsPassed;
+		if (testLoginBurstFunction)
+			testLoginBurst();
+		if (testGameStateCacheFunction)
+			testsPassed = testGameStateCache() && testsPassed;
+		if (testBanCacheFunction)
+			testsPassed = testBanCache() && testsPassed;
+		
+		std::cerr << (testsPassed ? "All tests passed." : "Some tests FAILED.") << std::endl;
+		delete rng;
+		delete settings;
+		delete loggerThread;
+		return testsPassed ? 0 : 1;
+	}
 	
 	Servatrice *server = new Servatrice(settings);
 	QObject::connect(server, SIGNAL(destroyed()), &app, SLOT(quit()), Qt::QueuedConnection);
@@ -1,7 +1,20 @@
 #ifndef MAIN_H
 #define MAIN_H
 
+#include <QObject>
+#include <QList>
+
 class ServerLogger;
+class ProtocolItem;
 extern ServerLogger *logger;
 
+// Keeps the items the protocol parser test reads from a binary stream.
+class ParserTestReceiver : public QObject {
+	Q_OBJECT
+public:
+	QList<ProtocolItem *> items;
+public slots:
+	void protocolItemReceived(ProtocolItem *item) { items.append(item); }
+};
+
 #endif
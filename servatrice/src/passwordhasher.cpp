@@ -19,3 +19,82 @@ QString PasswordHasher::computeHash(const QString &password, const QString &salt
 	return salt + QString(QByteArray(hash, hashLen).toBase64());
 }
 
+PasswordCheck::PasswordCheck(const QHostAddress &_address, const QString &_password, const QString &_correctHash, QObject *parent)
+	: QObject(parent), address(_address), password(_password), correctHash(_correctHash), accepted(false)
+{
+}
+
+void PasswordCheck::run()
+{
+	accepted = (correctHash == PasswordHasher::computeHash(password, correctHash.left(16)));
+}
+
+PasswordHasherThread::PasswordHasherThread(PasswordHasherPool *_pool)
+	: QThread(_pool), pool(_pool)
+{
+}
+
+void PasswordHasherThread::run()
+{
+	while (PasswordCheck *check = pool->takeCheck()) {
+		check->run();
+		pool->checkDone(check);
+	}
+}
+
+PasswordHasherPool::PasswordHasherPool(int numberOfThreads, int _maxChecksPerAddress, QObject *parent)
+	: QObject(parent), maxChecksPerAddress(_maxChecksPerAddress), stopping(false)
+{
+	for (int i = 0; i < numberOfThreads; ++i) {
+		PasswordHasherThread *thread = new PasswordHasherThread(this);
+		thread->start();
+		threads.append(thread);
+	}
+}
+
+PasswordHasherPool::~PasswordHasherPool()
+{
+	// Queued checks are still run before the threads quit.
+	queueMutex.lock();
+	stopping = true;
+	queueNotEmpty.wakeAll();
+	queueMutex.unlock();
+	
+	for (int i = 0; i < threads.size(); ++i) {
+		threads[i]->wait();
+		delete threads[i];
+	}
+}
+
+PasswordCheck *PasswordHasherPool::takeCheck()
+{
+	QMutexLocker locker(&queueMutex);
+	while (queue.isEmpty()) {
+		if (stopping)
+			return 0;
+		queueNotEmpty.wait(&queueMutex);
+	}
+	return queue.takeFirst();
+}
+
+void PasswordHasherPool::checkDone(PasswordCheck *check)
+{
+	queueMutex.lock();
+	QHash<QHostAddress, int>::iterator addressChecks = checksPerAddress.find(check->getAddress());
+	if ((addressChecks != checksPerAddress.end()) && (--addressChecks.value() == 0))
+		checksPerAddress.erase(addressChecks);
+	queueMutex.unlock();
+	
+	emit check->finished();
+}
+
+bool PasswordHasherPool::start(PasswordCheck *check)
+{
+	QMutexLocker locker(&queueMutex);
+	if ((maxChecksPerAddress > 0) && (checksPerAddress.value(check->getAddress()) >= maxChecksPerAddress))
+		return false;
+	++checksPerAddress[check->getAddress()];
+	queue.append(check);
+	queueNotEmpty.wakeOne();
+	return true;
+}
@@ -2,10 +2,76 @@
 #define PASSWORDHASHER_H
 
 #include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHostAddress>
+#include <QHash>
+#include <QList>
+
+class PasswordHasherPool;
 
 class PasswordHasher {
 public:
 	static QString computeHash(const QString &password, const QString &salt);
 };
 
+// Checks a password against a stored hash in one of the pool's threads.
+// Subclasses can do more of the login work there by reimplementing run().
+class PasswordCheck : public QObject {
+	Q_OBJECT
+	friend class PasswordHasherPool;
+signals:
+	// Emitted in the pool thread after run() has returned.
+	void finished();
+private:
+	QHostAddress address;
+	QString password, correctHash;
+	bool accepted;
+protected:
+	virtual void run();
+public:
+	PasswordCheck(const QHostAddress &_address, const QString &_password, const QString &_correctHash = QString(), QObject *parent = 0);
+	QHostAddress getAddress() const { return address; }
+	QString getPassword() const { return password; }
+	bool getAccepted() const { return accepted; }
+};
+
+class PasswordHasherThread : public QThread {
+	Q_OBJECT
+private:
+	PasswordHasherPool *pool;
+protected:
+	void run();
+public:
+	PasswordHasherThread(PasswordHasherPool *_pool);
+};
+
+// A fixed number of threads doing the CPU heavy password hashing, so that
+// a burst of logins neither stalls the socket threads nor takes every core.
+class PasswordHasherPool : public QObject {
+	Q_OBJECT
+	friend class PasswordHasherThread;
+private:
+	QList<PasswordHasherThread *> threads;
+	QMutex queueMutex;
+	QWaitCondition queueNotEmpty;
+	QList<PasswordCheck *> queue;
+	// Queued and running checks per address, guarded by queueMutex.
+	QHash<QHostAddress, int> checksPerAddress;
+	int maxChecksPerAddress;
+	bool stopping;
+	
+	PasswordCheck *takeCheck();
+	void checkDone(PasswordCheck *check);
+public:
+	PasswordHasherPool(int numberOfThreads, int _maxChecksPerAddress, QObject *parent = 0);
+	~PasswordHasherPool();
+	
+	// Returns false, without queueing the check, if its address already has
+	// the maximum number of checks in progress. Otherwise connect to
+	// PasswordCheck::finished() for the result; the check must stay alive until then.
+	bool start(PasswordCheck *check);
+};
+
 #endif
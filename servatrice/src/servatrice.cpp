@@ -17,9 +17,9 @@
  *   Free Software Foundation, Inc.,                                       *
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
-#include <QtSql>
 #include <QSettings>
 #include <QDebug>
+#include <QDateTime>
 #include <iostream>
 #include "servatrice.h"
 #include "server_room.h"
@@ -29,12 +29,39 @@
 #include "server_logger.h"
 #include "main.h"
 #include "passwordhasher.h"
+#include "databasepool.h"
+#include "usercache.h"
+#include "databasejournal.h"
+#include "decklist.h"
 
-void Servatrice_TcpServer::incomingConnection(int socketDescriptor)
+Servatrice_TcpServer::Servatrice_TcpServer(Servatrice *_server, int _numberOfThreads, QObject *parent)
+	: QTcpServer(parent), server(_server), nextThread(0)
 {
-	if (threaded) {
-		ServerSocketThread *sst = new ServerSocketThread(socketDescriptor, server, this);
+	for (int i = 0; i < _numberOfThreads; ++i) {
+		ServerSocketThread *sst = new ServerSocketThread(server);
 		sst->start();
+		socketThreads.append(sst);
+	}
+}
+
+Servatrice_TcpServer::~Servatrice_TcpServer()
+{
+	for (int i = 0; i < socketThreads.size(); ++i)
+		delete socketThreads[i];
+}
+
+void Servatrice_TcpServer::incomingConnection(int socketDescriptor)
+{
+	if (!socketThreads.isEmpty()) {
+		// Least loaded worker; ties are broken round-robin.
+		ServerSocketWorker *worker = 0;
+		for (int i = 0; i < socketThreads.size(); ++i) {
+			ServerSocketWorker *candidate = socketThreads[(nextThread + i) % socketThreads.size()]->getWorker();
+			if (!worker || (candidate->getConnectionCount() < worker->getConnectionCount()))
+				worker = candidate;
+		}
+		nextThread = (nextThread + 1) % socketThreads.size();
+		worker->assignConnection(socketDescriptor);
 	} else {
 		QTcpSocket *socket = new QTcpSocket;
 		socket->setSocketDescriptor(socketDescriptor);
@@ -44,10 +71,10 @@ void Servatrice_TcpServer::incomingConnection(int socketDescriptor)
 }
 
 Servatrice::Servatrice(QSettings *_settings, QObject *parent)
-	: Server(parent), dbMutex(QMutex::Recursive), settings(_settings), uptime(0), shutdownTimer(0)
+	: Server(parent), databasePool(0), databaseJournal(0), passwordHasherPool(0), banReloadTime(0), banRefreshPending(false), settings(_settings), uptime(0), lastConnectionRatePurge(0), userCache(0), shutdownTimer(0)
 {
 	pingClock = new QTimer(this);
-	connect(pingClock, SIGNAL(timeout()), this, SIGNAL(pingClockTimeout()));
+	connect(pingClock, SIGNAL(timeout()), this, SLOT(pingClockTimeout()));
 	pingClock->start(1000);
 	
 	ProtocolItem::initializeHash();
@@ -62,7 +89,37 @@ Servatrice::Servatrice(QSettings *_settings, QObject *parent)
 	}
 	
 	threaded = settings->value("server/threaded", false).toInt();
-	tcpServer = new Servatrice_TcpServer(this, threaded, this);
+	int numberOfThreads = 0;
+	if (threaded) {
+		numberOfThreads = settings->value("server/worker_threads", 0).toInt();
+		if (numberOfThreads <= 0)
+			numberOfThreads = QThread::idealThreadCount();
+		if (numberOfThreads <= 0)
+			numberOfThreads = 1;
+		qDebug() << "Starting" << numberOfThreads << "socket worker threads";
+		
+		int numberOfGameThreads = settings->value("game/worker_threads", 0).toInt();
+		if (numberOfGameThreads <= 0)
+			numberOfGameThreads = QThread::idealThreadCount();
+		if (numberOfGameThreads <= 0)
+			numberOfGameThreads = 1;
+		qDebug() << "Starting" << numberOfGameThreads << "game worker threads";
+		startGameThreads(numberOfGameThreads);
+	}
+	
+	// Read once here; authenticate() runs in the password hasher threads.
+	authenticationMethod = settings->value("authentication/method").toString();
+	int numberOfHasherThreads = settings->value("authentication/hasher_threads", 0).toInt();
+	if (numberOfHasherThreads <= 0)
+		numberOfHasherThreads = QThread::idealThreadCount();
+	if (numberOfHasherThreads <= 0)
+		numberOfHasherThreads = 1;
+	passwordHasherPool = new PasswordHasherPool(numberOfHasherThreads, settings->value("security/max_logins_in_progress_per_address", 2).toInt(), this);
+	qDebug() << "Starting" << numberOfHasherThreads << "password hasher threads";
+	userCache = new UserCache(settings->value("database/user_cache_size", 1000).toInt(), settings->value("database/user_cache_max_age", 300).toInt());
+	deckCache.setMaxCost(settings->value("database/deck_cache_size", 100).toInt());
+	
+	tcpServer = new Servatrice_TcpServer(this, numberOfThreads, this);
 	int port = settings->value("server/port", 4747).toInt();
 	qDebug() << "Starting server on port" << port;
 	if (tcpServer->listen(QHostAddress::Any, port))
@@ -72,8 +129,43 @@ Servatrice::Servatrice(QSettings *_settings, QObject *parent)
 	
 	QString dbType = settings->value("database/type").toString();
 	dbPrefix = settings->value("database/prefix").toString();
-	if (dbType == "mysql")
-		openDatabase();
+	if (dbType == "mysql") {
+		int numberOfConnections = settings->value("database/connections", 4).toInt();
+		if (numberOfConnections <= 0)
+			numberOfConnections = 1;
+		settings->beginGroup("database");
+		databasePool = new DatabasePool(settings->value("hostname").toString(), settings->value("database").toString(), settings->value("user").toString(), settings->value("password").toString(), numberOfConnections, this);
+		settings->endGroup();
+		qDebug() << "Started" << numberOfConnections << "database connections";
+		
+		DatabaseQuery query("select max(id) from " + dbPrefix + "_games");
+		if (execSqlQuery(query) && query.next()) {
+			nextGameId = query.value(0).toInt() + 1;
+			qDebug() << "set nextGameId to " << nextGameId;
+		}
+		
+		databaseJournal = new DatabaseJournal(databasePool, dbPrefix, settings->value("database/journal_spool", "servatrice_journal.spool").toString(), settings->value("database/journal_batch_size", 100).toInt(), settings->value("database/journal_flush_interval", 5000).toInt(), this);
+		databaseJournal->start();
+		
+		// Start above every id in use, whichever server it belongs to.
+		int maxSessionId = databaseJournal->getMaxSpooledSessionId();
+		DatabaseQuery sessionQuery("select max(id) from " + dbPrefix + "_sessions");
+		if (execSqlQuery(sessionQuery) && sessionQuery.next())
+			maxSessionId = qMax(maxSessionId, sessionQuery.value(0).toInt());
+		nextSessionNumber = maxSessionId / maxServerIds + 1;
+		if ((serverId < 0) || (serverId >= maxServerIds))
+			qCritical() << "server/id must be between 0 and" << (maxServerIds - 1) << "for sessions to be logged";
+		
+		DatabaseQuery *banChecksumQuery = newBanChecksumQuery();
+		if (execSqlQuery(*banChecksumQuery) && banChecksumQuery->next())
+			banTableChecksum = banChecksumQuery->value(0).toString();
+		delete banChecksumQuery;
+		DatabaseQuery *banQuery = newBanQuery();
+		if (execSqlQuery(*banQuery))
+			loadBans(*banQuery);
+		delete banQuery;
+		qDebug() << "Loaded" << banCache.size() << "bans";
+	}
 	
 	int size = settings->beginReadArray("rooms");
 	for (int i = 0; i < size; ++i) {
@@ -110,101 +202,87 @@ Servatrice::Servatrice(QSettings *_settings, QObject *parent)
 	maxMessageCountPerInterval = settings->value("security/max_message_count_per_interval").toInt();
 	maxMessageSizePerInterval = settings->value("security/max_message_size_per_interval").toInt();
 	maxGamesPerUser = settings->value("security/max_games_per_user").toInt();
+	maxSendBufferSize = settings->value("security/max_send_buffer_size").toInt();
+	connectionCountingInterval = settings->value("security/connection_counting_interval").toInt();
+	maxConnectionsPerInterval = settings->value("security/max_connections_per_interval").toInt();
 }
 
 Servatrice::~Servatrice()
 {
 	prepareDestroy();
-	QSqlDatabase::database().close();
+	// Login checks still in the queue need the database.
+	delete passwordHasherPool;
+	// Writes the last session ends.
+	delete databaseJournal;
+	delete databasePool;
+	delete userCache;
 }
 
-bool Servatrice::openDatabase()
+bool Servatrice::execSqlQuery(DatabaseQuery &query)
 {
-	if (!QSqlDatabase::connectionNames().isEmpty())
-		QSqlDatabase::removeDatabase(QSqlDatabase::database().connectionNames().at(0));
-	
-	settings->beginGroup("database");
-	QSqlDatabase sqldb = QSqlDatabase::addDatabase("QMYSQL");
-	sqldb.setHostName(settings->value("hostname").toString());
-	sqldb.setDatabaseName(settings->value("database").toString());
-	sqldb.setUserName(settings->value("user").toString());
-	sqldb.setPassword(settings->value("password").toString());
-	settings->endGroup();
-	
-	std::cerr << "Opening database...";
-	if (!sqldb.open()) {
-		std::cerr << "error" << std::endl;
+	if (!databasePool)
 		return false;
+	return databasePool->execSync(query);
+}
+
+void Servatrice::execSqlQueryAsync(DatabaseQuery *query)
+{
+	if (!databasePool) {
+		delete query;
+		return;
 	}
-	std::cerr << "OK" << std::endl;
-	
-	if (!nextGameId) {
-		QSqlQuery query;
-		if (!query.exec("select max(id) from " + dbPrefix + "_games"))
-			return false;
-		if (!query.next())
-			return false;
-		nextGameId = query.value(0).toInt() + 1;
-		qDebug() << "set nextGameId to " << nextGameId;
-	}
+	connect(query, SIGNAL(finished()), query, SLOT(deleteLater()));
+	databasePool->execAsync(query);
+}
+
+bool Servatrice::startDatabaseTask(DatabaseTask *task)
+{
+	if (!databasePool)
+		return false;
+	databasePool->startTask(task);
 	return true;
 }
 
-void Servatrice::checkSql()
+LoginCheck::LoginCheck(Servatrice *_server, const QHostAddress &_address, const QString &_userName, const QString &_password)
+	: PasswordCheck(_address, _password), server(_server), userName(_userName), result(PasswordWrong)
 {
-	QMutexLocker locker(&dbMutex);
-	if (!QSqlDatabase::database().exec("select 1").isActive())
-		openDatabase();
 }
 
-bool Servatrice::execSqlQuery(QSqlQuery &query)
+void LoginCheck::run()
 {
-	if (query.exec())
-		return true;
-	qCritical() << "Database error:" << query.lastError().text();
-	return false;
+	result = server->authenticate(getAddress(), userName, getPassword());
+}
+
+bool Servatrice::startLoginCheck(LoginCheck *check)
+{
+	return passwordHasherPool->start(check);
 }
 
 AuthenticationResult Servatrice::checkUserPassword(Server_ProtocolHandler *handler, const QString &user, const QString &password)
 {
-	QMutexLocker locker(&dbMutex);
-	const QString method = settings->value("authentication/method").toString();
-	if (method == "none")
+	// Logins are normally checked in advance by a LoginCheck.
+	ServerSocketInterface *ssi = static_cast<ServerSocketInterface *>(handler);
+	AuthenticationResult result;
+	if (ssi->takeCheckedAuthentication(user, password, result))
+		return result;
+	return authenticate(ssi->getPeerAddress(), user, password);
+}
+
+AuthenticationResult Servatrice::authenticate(const QHostAddress &address, const QString &user, const QString &password)
+{
+	if (authenticationMethod == "none")
 		return UnknownUser;
-	else if (method == "sql") {
-		checkSql();
-		
-		QSqlQuery ipBanQuery;
-		ipBanQuery.prepare("select time_to_sec(timediff(now(), date_add(b.time_from, interval b.minutes minute))) < 0, b.minutes <=> 0 from " + dbPrefix + "_bans b where b.time_from = (select max(c.time_from) from " + dbPrefix + "_bans c where c.ip_address = :address) and b.ip_address = :address2");
-		ipBanQuery.bindValue(":address", static_cast<ServerSocketInterface *>(handler)->getPeerAddress().toString());
-		ipBanQuery.bindValue(":address2", static_cast<ServerSocketInterface *>(handler)->getPeerAddress().toString());
-		if (!execSqlQuery(ipBanQuery)) {
-			qDebug("Login denied: SQL error");
+	else if (authenticationMethod == "sql") {
+		if (banCache.isAddressBanned(address.toString())) {
+			qDebug("Login denied: banned by address");
 			return PasswordWrong;
 		}
-		
-		if (ipBanQuery.next())
-			if (ipBanQuery.value(0).toInt() || ipBanQuery.value(1).toInt()) {
-				qDebug("Login denied: banned by address");
-				return PasswordWrong;
-			}
-		
-		QSqlQuery nameBanQuery;
-		nameBanQuery.prepare("select time_to_sec(timediff(now(), date_add(b.time_from, interval b.minutes minute))) < 0, b.minutes <=> 0 from " + dbPrefix + "_bans b where b.time_from = (select max(c.time_from) from " + dbPrefix + "_bans c where c.user_name = :name2) and b.user_name = :name1");
-		nameBanQuery.bindValue(":name1", user);
-		nameBanQuery.bindValue(":name2", user);
-		if (!execSqlQuery(nameBanQuery)) {
-			qDebug("Login denied: SQL error");
+		if (banCache.isUserNameBanned(user)) {
+			qDebug("Login denied: banned by name");
 			return PasswordWrong;
 		}
 		
-		if (nameBanQuery.next())
-			if (nameBanQuery.value(0).toInt() || nameBanQuery.value(1).toInt()) {
-				qDebug("Login denied: banned by name");
-				return PasswordWrong;
-			}
-		
-		QSqlQuery passwordQuery;
+		DatabaseQuery passwordQuery;
 		passwordQuery.prepare("select password_sha512 from " + dbPrefix + "_users where name = :name and active = 1");
 		passwordQuery.bindValue(":name", user);
 		if (!execSqlQuery(passwordQuery)) {
@@ -231,12 +309,9 @@ AuthenticationResult Servatrice::checkUserPassword(Server_ProtocolHandler *handl
 
 bool Servatrice::userExists(const QString &user)
 {
-	QMutexLocker locker(&dbMutex);
 	const QString method = settings->value("authentication/method").toString();
 	if (method == "sql") {
-		checkSql();
-	
-		QSqlQuery query;
+		DatabaseQuery query;
 		query.prepare("select 1 from " + dbPrefix + "_users where name = :name and active = 1");
 		query.bindValue(":name", user);
 		if (!execSqlQuery(query))
@@ -245,7 +320,7 @@ bool Servatrice::userExists(const QString &user)
 	} else return false;
 }
 
-ServerInfo_User *Servatrice::evalUserQueryResult(const QSqlQuery &query, bool complete)
+ServerInfo_User *Servatrice::evalUserQueryResult(const DatabaseQuery &query, bool complete)
 {
 	QString name = query.value(0).toString();
 	int is_admin = query.value(1).toInt();
@@ -283,71 +358,114 @@ ServerInfo_User *Servatrice::evalUserQueryResult(const QSqlQuery &query, bool co
 
 ServerInfo_User *Servatrice::getUserData(const QString &name)
 {
-	QMutexLocker locker(&dbMutex);
-	const QString method = settings->value("authentication/method").toString();
-	if (method == "sql") {
-		checkSql();
-
-		QSqlQuery query;
+	if (authenticationMethod == "sql") {
+		ServerInfo_User *cachedUser = userCache->getUser(name);
+		if (cachedUser)
+			return cachedUser;
+		
+		DatabaseQuery query;
 		query.prepare("select name, admin, realname, gender, country, avatar_bmp from " + dbPrefix + "_users where name = :name and active = 1");
 		query.bindValue(":name", name);
 		if (!execSqlQuery(query))
 			return new ServerInfo_User(name, ServerInfo_User::IsUser);
 		
-		if (query.next())
-			return evalUserQueryResult(query, true);
-		else
+		if (query.next()) {
+			ServerInfo_User *result = evalUserQueryResult(query, true);
+			userCache->insertUser(name, result);
+			return result;
+		} else
 			return new ServerInfo_User(name, ServerInfo_User::IsUser);
 	} else
 		return new ServerInfo_User(name, ServerInfo_User::IsUser);
 }
 
-int Servatrice::getUsersWithAddress(const QHostAddress &address) const
+int Servatrice::getUserIdInDB(const QString &name)
 {
-	QMutexLocker locker(&serverMutex);
-	int result = 0;
-	for (int i = 0; i < clients.size(); ++i)
-		if (static_cast<ServerSocketInterface *>(clients[i])->getPeerAddress() == address)
-			++result;
-	return result;
+	int id = userCache->getUserId(name);
+	if (id != -1)
+		return id;
+	
+	DatabaseQuery query;
+	query.prepare("select id from " + dbPrefix + "_users where name = :name");
+	query.bindValue(":name", name);
+	if (!execSqlQuery(query))
+		return -1;
+	if (!query.next())
+		return -1;
+	id = query.value(0).toInt();
+	userCache->insertUserId(name, id);
+	return id;
+}
+
+DeckList *Servatrice::getCachedDeck(const QString &contentHash)
+{
+	QMutexLocker locker(&deckCacheMutex);
+	DeckList *deck = deckCache.object(contentHash);
+	return deck ? new DeckList(deck) : 0;
+}
+
+void Servatrice::insertCachedDeck(const QString &contentHash, DeckList *deck)
+{
+	QMutexLocker locker(&deckCacheMutex);
+	deckCache.insert(contentHash, new DeckList(deck));
+}
+
+void Servatrice::userListChanged(const QString &list, const QString &name)
+{
+	userCache->invalidateUserList(list, name);
+}
+
+bool Servatrice::registerConnection(const QHostAddress &address)
+{
+	if ((connectionCountingInterval <= 0) || (maxConnectionsPerInterval <= 0))
+		return true;
+	
+	const int tick = getTickCount();
+	QMutexLocker locker(&connectionRateMutex);
+	
+	// Forget addresses which have been quiet for a whole interval.
+	if (tick - lastConnectionRatePurge >= connectionCountingInterval) {
+		QMutableHashIterator<QHostAddress, Server_RateLimiter> rateIterator(connectionRates);
+		while (rateIterator.hasNext())
+			if (rateIterator.next().value().getTotal(tick) == 0)
+				rateIterator.remove();
+		lastConnectionRatePurge = tick;
+	}
+	
+	QHash<QHostAddress, Server_RateLimiter>::iterator rate = connectionRates.find(address);
+	if (rate == connectionRates.end())
+		rate = connectionRates.insert(address, Server_RateLimiter(connectionCountingInterval));
+	return rate.value().add(tick, 1) <= maxConnectionsPerInterval;
 }
 
 int Servatrice::startSession(const QString &userName, const QString &address)
 {
-	QMutexLocker locker(&dbMutex);
-	checkSql();
+	if (!databaseJournal || (serverId < 0) || (serverId >= maxServerIds))
+		return -1;
 	
-	QSqlQuery query;
-	query.prepare("insert into " + dbPrefix + "_sessions (user_name, ip_address, start_time) values(:user_name, :ip_address, NOW())");
-	query.bindValue(":user_name", userName);
-	query.bindValue(":ip_address", address);
-	if (execSqlQuery(query))
-		return query.lastInsertId().toInt();
-	return -1;
+	const int sessionId = nextSessionNumber.fetchAndAddOrdered(1) * maxServerIds + serverId;
+	databaseJournal->addEntry(DatabaseJournal::SessionStart, QVariantList() << sessionId << userName << address << QDateTime::currentDateTime().toTime_t());
+	return sessionId;
 }
 
 void Servatrice::endSession(int sessionId)
 {
-	QMutexLocker locker(&dbMutex);
-	checkSql();
+	if (!databaseJournal)
+		return;
 	
-	QSqlQuery query;
-	query.prepare("update " + dbPrefix + "_sessions set end_time=NOW() where id = :id_session");
-	query.bindValue(":id_session", sessionId);
-	execSqlQuery(query);
+	databaseJournal->addEntry(DatabaseJournal::SessionEnd, QVariantList() << sessionId << QDateTime::currentDateTime().toTime_t());
 }
 
-QMap<QString, ServerInfo_User *> Servatrice::getBuddyList(const QString &name)
+QMap<QString, ServerInfo_User *> Servatrice::getUserList(const QString &list, const QString &name)
 {
-	QMutexLocker locker(&dbMutex);
 	QMap<QString, ServerInfo_User *> result;
 	
-	const QString method = settings->value("authentication/method").toString();
-	if (method == "sql") {
-		checkSql();
-
-		QSqlQuery query;
-		query.prepare("select a.name, a.admin, a.realname, a.gender, a.country from " + dbPrefix + "_users a left join " + dbPrefix + "_buddylist b on a.id = b.id_user2 left join " + dbPrefix + "_users c on b.id_user1 = c.id where c.name = :name");
+	if (authenticationMethod == "sql") {
+		if (userCache->getUserList(list, name, result))
+			return result;
+		
+		DatabaseQuery query;
+		query.prepare("select a.name, a.admin, a.realname, a.gender, a.country from " + dbPrefix + "_users a left join " + dbPrefix + "_" + list + "list b on a.id = b.id_user2 left join " + dbPrefix + "_users c on b.id_user1 = c.id where c.name = :name");
 		query.bindValue(":name", name);
 		if (!execSqlQuery(query))
 			return result;
@@ -356,38 +474,24 @@ QMap<QString, ServerInfo_User *> Servatrice::getBuddyList(const QString &name)
 			ServerInfo_User *temp = evalUserQueryResult(query, false);
 			result.insert(temp->getName(), temp);
 		}
+		userCache->insertUserList(list, name, result);
 	}
 	return result;
 }
 
-QMap<QString, ServerInfo_User *> Servatrice::getIgnoreList(const QString &name)
+QMap<QString, ServerInfo_User *> Servatrice::getBuddyList(const QString &name)
 {
-	QMutexLocker locker(&dbMutex);
-	QMap<QString, ServerInfo_User *> result;
-	
-	const QString method = settings->value("authentication/method").toString();
-	if (method == "sql") {
-		checkSql();
+	return getUserList("buddy", name);
+}
 
-		QSqlQuery query;
-		query.prepare("select a.name, a.admin, a.realname, a.gender, a.country from " + dbPrefix + "_users a left join " + dbPrefix + "_ignorelist b on a.id = b.id_user2 left join " + dbPrefix + "_users c on b.id_user1 = c.id where c.name = :name");
-		query.bindValue(":name", name);
-		if (!execSqlQuery(query))
-			return result;
-		
-		while (query.next()) {
-			ServerInfo_User *temp = evalUserQueryResult(query, false);
-			result.insert(temp->getName(), temp);
-		}
-	}
-	return result;
+QMap<QString, ServerInfo_User *> Servatrice::getIgnoreList(const QString &name)
+{
+	return getUserList("ignore", name);
 }
 
 void Servatrice::updateLoginMessage()
 {
-	QMutexLocker locker(&dbMutex);
-	checkSql();
-	QSqlQuery query;
+	DatabaseQuery query;
 	query.prepare("select message from " + dbPrefix + "_servermessages where id_server = :id_server order by timest desc limit 1");
 	query.bindValue(":id_server", serverId);
 	if (execSqlQuery(query))
@@ -395,17 +499,62 @@ void Servatrice::updateLoginMessage()
 			loginMessage = query.value(0).toString();
 			
 			Event_ServerMessage *event = new Event_ServerMessage(loginMessage);
-			QMapIterator<QString, Server_ProtocolHandler *> usersIterator(users);
-			while (usersIterator.hasNext()) {
-				usersIterator.next().value()->sendProtocolItem(event, false);
-			}
+			QReadLocker clientsLocker(&clientsLock);
+			const QList<Server_ProtocolHandler *> userList = getUserList();
+			for (int i = 0; i < userList.size(); ++i)
+				userList[i]->sendProtocolItem(event, false);
 			delete event;
 		}
 }
 
+DatabaseQuery *Servatrice::newBanChecksumQuery() const
+{
+	// Covers every column, so that deleted and edited rows are noticed as well.
+	return new DatabaseQuery("select concat(count(*), ':', coalesce(bit_xor(crc32(concat_ws(',', user_name, ip_address, time_from, minutes))), 0)) from " + dbPrefix + "_bans");
+}
+
+DatabaseQuery *Servatrice::newBanQuery()
+{
+	banReloadTime = QDateTime::currentDateTime().toTime_t();
+	return new DatabaseQuery("select user_name, ip_address, unix_timestamp(time_from), minutes from " + dbPrefix + "_bans order by time_from");
+}
+
+void Servatrice::loadBans(DatabaseQuery &query)
+{
+	BanCache freshBans;
+	while (query.next())
+		freshBans.addBan(query.value(0).toString(), query.value(1).toString(), query.value(2).toUInt(), query.value(3).toInt() * 60);
+	banCache.replace(freshBans, banReloadTime);
+}
+
+void Servatrice::banChecksumFinished()
+{
+	DatabaseQuery *query = static_cast<DatabaseQuery *>(sender());
+	if (!query->getSuccess() || !query->next() || (query->value(0).toString() == banTableChecksum)) {
+		banRefreshPending = false;
+		return;
+	}
+	
+	banTableChecksum = query->value(0).toString();
+	DatabaseQuery *banQuery = newBanQuery();
+	connect(banQuery, SIGNAL(finished()), this, SLOT(banRefreshFinished()));
+	execSqlQueryAsync(banQuery);
+}
+
+void Servatrice::banRefreshFinished()
+{
+	DatabaseQuery *query = static_cast<DatabaseQuery *>(sender());
+	if (query->getSuccess())
+		loadBans(*query);
+	else
+		// Try again on the next status update.
+		banTableChecksum.clear();
+	banRefreshPending = false;
+}
+
 void Servatrice::statusUpdate()
 {
-	const int uc = getUsersCount(); // for correct mutex locking order
+	const int uc = getUsersCount();
 	const int gc = getGamesCount();
 	
 	uptime += statusUpdateClock->interval() / 1000;
@@ -419,18 +568,25 @@ void Servatrice::statusUpdate()
 	rxBytes = 0;
 	rxBytesMutex.unlock();
 	
-	QMutexLocker locker(&dbMutex);
-	checkSql();
+	if (databaseJournal)
+		databaseJournal->addEntry(DatabaseJournal::Uptime, QVariantList() << serverId << QDateTime::currentDateTime().toTime_t() << uptime << uc << gc << tx << rx);
+	
+	if (databasePool && !banRefreshPending) {
+		banRefreshPending = true;
+		DatabaseQuery *banChecksumQuery = newBanChecksumQuery();
+		connect(banChecksumQuery, SIGNAL(finished()), this, SLOT(banChecksumFinished()));
+		execSqlQueryAsync(banChecksumQuery);
+	}
 	
-	QSqlQuery query;
-	query.prepare("insert into " + dbPrefix + "_uptime (id_server, timest, uptime, users_count, games_count, tx_bytes, rx_bytes) values(:id, NOW(), :uptime, :users_count, :games_count, :tx, :rx)");
-	query.bindValue(":id", serverId);
-	query.bindValue(":uptime", uptime);
-	query.bindValue(":users_count", uc);
-	query.bindValue(":games_count", gc);
-	query.bindValue(":tx", tx);
-	query.bindValue(":rx", rx);
-	execSqlQuery(query);
+	// Make connection floods visible in the log.
+	const QList<QPair<QHostAddress, int> > topAddresses = getTopAddresses(5);
+	QStringList topAddressList;
+	for (int i = 0; i < topAddresses.size(); ++i)
+		if (topAddresses[i].second > 1)
+			topAddressList.append(QString("%1 (%2)").arg(topAddresses[i].first.toString()).arg(topAddresses[i].second));
+	if (!topAddressList.isEmpty())
+		qDebug() << "Addresses with most connections:" << topAddressList.join(", ");
+	qDebug() << "User cache:" << userCache->getHits() << "hits," << userCache->getMisses() << "misses";
 }
 
 void Servatrice::scheduleShutdown(const QString &reason, int minutes)
@@ -473,8 +629,10 @@ void Servatrice::shutdownTimeout()
 	else
 		event = new Event_ConnectionClosed("server_shutdown");
 
+	clientsLock.lockForRead();
 	for (int i = 0; i < clients.size(); ++i)
 		clients[i]->sendProtocolItem(event, false);
+	clientsLock.unlock();
 	delete event;
 	
 	if (!shutdownMinutes)
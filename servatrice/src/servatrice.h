@@ -22,42 +22,77 @@
 
 #include <QTcpServer>
 #include <QMutex>
+#include <QHash>
+#include <QHostAddress>
+#include <QCache>
 #include "server.h"
+#include "server_ratelimiter.h"
+#include "passwordhasher.h"
+#include "bancache.h"
 
-class QSqlDatabase;
 class QSettings;
-class QSqlQuery;
 class QTimer;
+class DatabasePool;
+class DatabaseQuery;
+class DatabaseTask;
+class UserCache;
+class DatabaseJournal;
+class DeckList;
 
 class Servatrice;
 class ServerSocketInterface;
+class ServerSocketThread;
 
 class Servatrice_TcpServer : public QTcpServer {
 	Q_OBJECT
 private:
 	Servatrice *server;
-	bool threaded;
+	QList<ServerSocketThread *> socketThreads;
+	int nextThread;
 public:
-	Servatrice_TcpServer(Servatrice *_server, bool _threaded, QObject *parent = 0)
-		: QTcpServer(parent), server(_server), threaded(_threaded) { }
+	Servatrice_TcpServer(Servatrice *_server, int _numberOfThreads, QObject *parent = 0);
+	~Servatrice_TcpServer();
 protected:
 	void incomingConnection(int socketDescriptor);
 };
 
+// Runs the whole password check of a login, including the database
+// lookups, in a password hasher thread.
+class LoginCheck : public PasswordCheck {
+private:
+	Servatrice *server;
+	QString userName;
+	AuthenticationResult result;
+protected:
+	void run();
+public:
+	LoginCheck(Servatrice *_server, const QHostAddress &_address, const QString &_userName, const QString &_password);
+	QString getUserName() const { return userName; }
+	AuthenticationResult getResult() const { return result; }
+};
+
 class Servatrice : public Server
 {
 	Q_OBJECT
 private slots:
 	void statusUpdate();
+	void banChecksumFinished();
+	void banRefreshFinished();
 	void shutdownTimeout();
 public:
-	QMutex dbMutex;
 	static const QString versionString;
 	Servatrice(QSettings *_settings, QObject *parent = 0);
 	~Servatrice();
-	bool openDatabase();
-	void checkSql();
-	bool execSqlQuery(QSqlQuery &query);
+	bool execSqlQuery(DatabaseQuery &query);
+	// The query is deleted after it has run and finished() has been emitted.
+	void execSqlQueryAsync(DatabaseQuery *query);
+	// Returns false, without starting the task, if there is no database.
+	bool startDatabaseTask(DatabaseTask *task);
+	BanCache &getBanCache() { return banCache; }
+	// Returns false if the address already has too many logins in progress.
+	bool startLoginCheck(LoginCheck *check);
+	// Thread-safe. Blocks on the database and the password hash.
+	AuthenticationResult authenticate(const QHostAddress &address, const QString &user, const QString &password);
 	QString getLoginMessage() const { return loginMessage; }
 	bool getGameShouldPing() const { return true; }
 	int getMaxGameInactivityTime() const { return maxGameInactivityTime; }
@@ -67,11 +102,20 @@ public:
 	int getMaxMessageCountPerInterval() const { return maxMessageCountPerInterval; }
 	int getMaxMessageSizePerInterval() const { return maxMessageSizePerInterval; }
 	int getMaxGamesPerUser() const { return maxGamesPerUser; }
+	int getMaxSendBufferSize() const { return maxSendBufferSize; }
 	bool getThreaded() const { return threaded; }
 	QString getDbPrefix() const { return dbPrefix; }
 	void updateLoginMessage();
 	ServerInfo_User *getUserData(const QString &name);
-	int getUsersWithAddress(const QHostAddress &address) const;
+	int getUserIdInDB(const QString &name);
+	// Parsed decks by content hash. getCachedDeck() returns a new copy or 0.
+	DeckList *getCachedDeck(const QString &contentHash);
+	void insertCachedDeck(const QString &contentHash, DeckList *deck);
+	// Called after a buddy or ignore list has been changed in the database.
+	void userListChanged(const QString &list, const QString &name);
+	// Counts a new connection from the address. Returns false if the address
+	// opened more connections than allowed during the counting interval.
+	bool registerConnection(const QHostAddress &address);
 	QMap<QString, ServerInfo_User *> getBuddyList(const QString &name);
 	QMap<QString, ServerInfo_User *> getIgnoreList(const QString &name);
 	void scheduleShutdown(const QString &reason, int minutes);
@@ -85,6 +129,24 @@ protected:
 private:
 	QTimer *pingClock, *statusUpdateClock;
 	QTcpServer *tcpServer;
+	DatabasePool *databasePool;
+	DatabaseJournal *databaseJournal;
+	// Session ids are assigned here, so that sessions can be written in
+	// batches. Servers sharing the database must not hand out the same ids,
+	// so every id is a multiple of maxServerIds plus the server id.
+	static const int maxServerIds = 100;
+	QAtomicInt nextSessionNumber;
+	PasswordHasherPool *passwordHasherPool;
+	QString authenticationMethod;
+	BanCache banCache;
+	// The bans table is reloaded whenever its checksum changes, to pick up
+	// bans issued, lifted or edited by other servers sharing the database.
+	QString banTableChecksum;
+	uint banReloadTime;
+	bool banRefreshPending;
+	DatabaseQuery *newBanChecksumQuery() const;
+	DatabaseQuery *newBanQuery();
+	void loadBans(DatabaseQuery &query);
 	QString loginMessage;
 	QString dbPrefix;
 	QSettings *settings;
@@ -94,8 +156,16 @@ private:
 	QMutex txBytesMutex, rxBytesMutex;
 	quint64 txBytes, rxBytes;
 	int maxGameInactivityTime, maxPlayerInactivityTime;
-	int maxUsersPerAddress, messageCountingInterval, maxMessageCountPerInterval, maxMessageSizePerInterval, maxGamesPerUser;
-	ServerInfo_User *evalUserQueryResult(const QSqlQuery &query, bool complete);
+	int maxUsersPerAddress, messageCountingInterval, maxMessageCountPerInterval, maxMessageSizePerInterval, maxGamesPerUser, maxSendBufferSize;
+	int connectionCountingInterval, maxConnectionsPerInterval;
+	QMutex connectionRateMutex;
+	QHash<QHostAddress, Server_RateLimiter> connectionRates;
+	int lastConnectionRatePurge;
+	ServerInfo_User *evalUserQueryResult(const DatabaseQuery &query, bool complete);
+	QMap<QString, ServerInfo_User *> getUserList(const QString &list, const QString &name);
+	UserCache *userCache;
+	QMutex deckCacheMutex;
+	QCache<QString, DeckList> deckCache;
 	
 	QString shutdownReason;
 	int shutdownMinutes;
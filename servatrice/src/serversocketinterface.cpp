@@ -20,9 +20,10 @@
 
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
-#include <QtSql>
+#include <QBuffer>
 #include <QHostAddress>
 #include <QDebug>
+#include <QCryptographicHash>
 #include "serversocketinterface.h"
 #include "servatrice.h"
 #include "protocol.h"
@@ -31,11 +32,17 @@
 #include "server_player.h"
 #include "main.h"
 #include "server_logger.h"
+#include "stream_compression.h"
+#include "databasepool.h"
 
 ServerSocketInterface::ServerSocketInterface(Servatrice *_server, QTcpSocket *_socket, QObject *parent)
-	: Server_ProtocolHandler(_server, parent), servatrice(_server), socket(_socket), topLevelItem(0), compressionSupport(false)
+	: Server_ProtocolHandler(_server, parent), servatrice(_server), socket(_socket), peerAddress(_socket->peerAddress()), topLevelItem(0), compressionSupport(false), binaryInput(false), binaryOutput(false), compressor(0), flushPending(false), sendBufferOverflow(false), pendingContainer(0), pendingDatabaseTask(0), hasCheckedAuthentication(false), checkedAuthentication(PasswordWrong)
 {
-	xmlWriter = new QXmlStreamWriter(&xmlBuffer);
+	// Items written by xmlWriter and pre-encoded broadcast items share
+	// one UTF-8 output buffer, so their order is preserved.
+	outputDevice = new QBuffer(&outputBuffer);
+	outputDevice->open(QIODevice::WriteOnly);
+	xmlWriter = new QXmlStreamWriter(outputDevice);
 	xmlReader = new QXmlStreamReader;
 	
 	connect(socket, SIGNAL(readyRead()), this, SLOT(readClient()));
@@ -46,10 +53,11 @@ ServerSocketInterface::ServerSocketInterface(Servatrice *_server, QTcpSocket *_s
 	xmlWriter->writeStartDocument();
 	xmlWriter->writeStartElement("cockatrice_server_stream");
 	xmlWriter->writeAttribute("version", QString::number(ProtocolItem::protocolVersion));
+	xmlWriter->writeCharacters(QString());
 	flushXmlBuffer();
 	
 	int maxUsers = _server->getMaxUsersPerAddress();
-	if ((maxUsers > 0) && (_server->getUsersWithAddress(socket->peerAddress()) >= maxUsers)) {
+	if (!_server->registerConnection(peerAddress) || ((maxUsers > 0) && (_server->getUsersWithAddress(peerAddress) >= maxUsers))) {
 		sendProtocolItem(new Event_ConnectionClosed("too_many_connections"));
 		deleteLater();
 	} else
@@ -62,14 +70,36 @@ ServerSocketInterface::~ServerSocketInterface()
 {
 	logger->logMessage("ServerSocketInterface destructor", this);
 	
+	// A running task still uses this object.
+	if (pendingDatabaseTask) {
+		pendingDatabaseTask->waitForFinished();
+		if (pendingDatabaseTask->getProcessContainer())
+			pendingContainer = 0;
+	}
+	
 	prepareDestroy();
 	
+	// Stops further output and skips the overflow check while the
+	// game list is being torn down.
+	sendBufferOverflow = true;
 	flushXmlBuffer();
 	delete xmlWriter;
+	delete outputDevice;
+	delete compressor;
 	delete xmlReader;
 	delete socket;
 	socket = 0;
 	delete topLevelItem;
+	
+	if (pendingContainer && pendingContainer->getReceiverMayDelete())
+		delete pendingContainer;
+	for (int i = 0; i < deferredContainers.size(); ++i)
+		if (deferredContainers[i]->getReceiverMayDelete())
+			delete deferredContainers[i];
+	qDeleteAll(prefetchedDecks);
+	QMapIterator<Command *, UserListChange> userListIterator(userListChanges);
+	while (userListIterator.hasNext())
+		delete userListIterator.next().value().info;
 }
 
 void ServerSocketInterface::processProtocolItem(ProtocolItem *item)
@@ -77,38 +107,278 @@ void ServerSocketInterface::processProtocolItem(ProtocolItem *item)
 	CommandContainer *cont = qobject_cast<CommandContainer *>(item);
 	if (!cont)
 		sendProtocolItem(new ProtocolResponse(cont->getCmdId(), RespInvalidCommand));
+	else if (pendingContainer)
+		deferredContainers.append(cont);
 	else
+		startContainer(cont);
+}
+
+void ServerSocketInterface::startContainer(CommandContainer *cont)
+{
+	if (!startLoginCheck(cont) && !startDatabaseTask(cont))
 		processCommandContainer(cont);
 }
 
+void ServerSocketInterface::processDeferredContainers()
+{
+	while (!pendingContainer && !deferredContainers.isEmpty())
+		startContainer(deferredContainers.takeFirst());
+}
+
+bool ServerSocketInterface::startLoginCheck(CommandContainer *cont)
+{
+	const QList<Command *> &cmdList = cont->getCommandList();
+	if ((cmdList.size() != 1) || userInfo)
+		return false;
+	Command_Login *cmd = qobject_cast<Command_Login *>(cmdList.first());
+	if (!cmd)
+		return false;
+	
+	// Same as in cmdLogin() and Server::loginUser(), so that the result matches.
+	QString userName = cmd->getUsername().simplified();
+	if (userName.isEmpty())
+		return false;
+	if (userName.size() > 35)
+		userName = userName.left(35);
+	
+	LoginCheck *check = new LoginCheck(servatrice, peerAddress, userName, cmd->getPassword());
+	connect(check, SIGNAL(finished()), this, SLOT(loginCheckFinished()), Qt::QueuedConnection);
+	connect(check, SIGNAL(finished()), check, SLOT(deleteLater()));
+	if (!servatrice->startLoginCheck(check)) {
+		delete check;
+		qDebug("Login denied: too many logins in progress from this address");
+		setCheckedAuthentication(userName, cmd->getPassword(), PasswordWrong);
+		return false;
+	}
+	pendingContainer = cont;
+	return true;
+}
+
+void ServerSocketInterface::loginCheckFinished()
+{
+	LoginCheck *check = static_cast<LoginCheck *>(sender());
+	setCheckedAuthentication(check->getUserName(), check->getPassword(), check->getResult());
+	
+	CommandContainer *cont = pendingContainer;
+	pendingContainer = 0;
+	processCommandContainer(cont);
+	
+	processDeferredContainers();
+}
+
+bool ServerSocketInterface::startDatabaseTask(CommandContainer *cont)
+{
+	const QList<Command *> &cmdList = cont->getCommandList();
+	if (cmdList.isEmpty())
+		return false;
+	
+	bool databaseCommandsOnly = true, selectsStoredDeck = false, changesUserList = false;
+	for (int i = 0; i < cmdList.size(); ++i)
+		switch (cmdList[i]->getItemId()) {
+			case ItemId_Command_AddToList:
+			case ItemId_Command_RemoveFromList:
+				changesUserList = true;
+				databaseCommandsOnly = false;
+				break;
+			case ItemId_Command_DeckList:
+			case ItemId_Command_DeckNewDir:
+			case ItemId_Command_DeckDelDir:
+			case ItemId_Command_DeckDel:
+			case ItemId_Command_DeckUpload:
+			case ItemId_Command_DeckDownload:
+			case ItemId_Command_BanFromServer:
+				break;
+			case ItemId_Command_DeckSelect:
+				if (static_cast<Command_DeckSelect *>(cmdList[i])->getDeckId() != -1)
+					selectsStoredDeck = true;
+				databaseCommandsOnly = false;
+				break;
+			default:
+				databaseCommandsOnly = false;
+		}
+	if (!databaseCommandsOnly && !selectsStoredDeck && !changesUserList)
+		return false;
+	
+	CommandDatabaseTask *task = new CommandDatabaseTask(this, cont, databaseCommandsOnly);
+	connect(task, SIGNAL(finished()), this, SLOT(databaseTaskFinished()), Qt::QueuedConnection);
+	connect(task, SIGNAL(finished()), task, SLOT(deleteLater()));
+	if (!servatrice->startDatabaseTask(task)) {
+		delete task;
+		return false;
+	}
+	pendingContainer = cont;
+	pendingDatabaseTask = task;
+	return true;
+}
+
+void CommandDatabaseTask::run()
+{
+	if (processContainer)
+		ssi->processCommandContainer(cont);
+	else {
+		ssi->prefetchDecks(cont);
+		ssi->writeUserListChanges(cont);
+	}
+}
+
+void ServerSocketInterface::databaseTaskFinished()
+{
+	CommandContainer *cont = pendingContainer;
+	bool processed = pendingDatabaseTask->getProcessContainer();
+	pendingContainer = 0;
+	pendingDatabaseTask = 0;
+	if (!processed)
+		processCommandContainer(cont);
+	
+	processDeferredContainers();
+}
+
+void ServerSocketInterface::prefetchDecks(CommandContainer *cont)
+{
+	const QList<Command *> &cmdList = cont->getCommandList();
+	for (int i = 0; i < cmdList.size(); ++i) {
+		Command_DeckSelect *cmd = qobject_cast<Command_DeckSelect *>(cmdList[i]);
+		if (!cmd || (cmd->getDeckId() == -1) || (authState != PasswordRight))
+			continue;
+		
+		DeckList *deck;
+		try {
+			deck = getDeckFromDatabase(cmd->getDeckId());
+		} catch (ResponseCode) {
+			// The command will fail the same way.
+			continue;
+		}
+		QMutexLocker locker(&prefetchedDecksMutex);
+		delete prefetchedDecks.value(cmd->getDeckId());
+		prefetchedDecks.insert(cmd->getDeckId(), deck);
+	}
+}
+
+void ServerSocketInterface::setCheckedAuthentication(const QString &userName, const QString &password, AuthenticationResult result)
+{
+	hasCheckedAuthentication = true;
+	checkedUserName = userName;
+	checkedPassword = password;
+	checkedAuthentication = result;
+}
+
+bool ServerSocketInterface::takeCheckedAuthentication(const QString &userName, const QString &password, AuthenticationResult &result)
+{
+	if (!hasCheckedAuthentication || (userName != checkedUserName) || (password != checkedPassword))
+		return false;
+	hasCheckedAuthentication = false;
+	checkedPassword.clear();
+	result = checkedAuthentication;
+	return true;
+}
+
+void ServerSocketInterface::outputBufferChanged()
+{
+	// Everything queued until the next event loop iteration goes out in
+	// a single write.
+	if (!flushPending) {
+		flushPending = true;
+		emit xmlBufferChanged();
+	}
+}
+
 void ServerSocketInterface::flushXmlBuffer()
 {
-	QMutexLocker locker(&xmlBufferMutex);
-	if (xmlBuffer.isEmpty())
+	qint64 bytesToWrite;
+	{
+		QMutexLocker locker(&xmlBufferMutex);
+		flushPending = false;
+		if (outputBuffer.isEmpty())
+			return;
+		if (compressor) {
+			QByteArray compressedData = compressor->compress(outputBuffer);
+			servatrice->incTxBytes(compressedData.size());
+			socket->write(compressedData);
+		} else {
+			servatrice->incTxBytes(outputBuffer.size());
+			socket->write(outputBuffer);
+		}
+		// Hands the data to the OS right away, so that it isn't lost if the
+		// socket is deleted next, as in the destructor.
+		socket->flush();
+		outputBuffer.clear();
+		bytesToWrite = socket->bytesToWrite();
+	}
+	
+	// A peer that does not read its data would make the socket's write
+	// buffer grow without bounds. Users who are not seated in a game are
+	// dropped at the high-water mark, players only when far beyond it.
+	qint64 maxSendBufferSize = servatrice->getMaxSendBufferSize();
+	if (sendBufferOverflow || (maxSendBufferSize <= 0) || (bytesToWrite <= maxSendBufferSize))
 		return;
-	servatrice->incTxBytes(xmlBuffer.size());
-	socket->write(xmlBuffer.toUtf8());
-	socket->flush();
-	xmlBuffer.clear();
+	if ((bytesToWrite > 4 * maxSendBufferSize) || !isPlayingInGame()) {
+		logger->logMessage(QString("Send buffer overflow (%1 bytes), dropping connection").arg(bytesToWrite), this);
+		sendBufferOverflow = true;
+		deleteLater();
+	}
 }
 
 void ServerSocketInterface::readClient()
 {
 	QByteArray data = socket->readAll();
 	servatrice->incRxBytes(data.size());
+	if (binaryInput) {
+		if (!topLevelItem->readBinaryData(data))
+			deleteLater();
+		return;
+	}
 	if (!data.contains("<cmd type=\"ping\""))
 		logger->logMessage(QString(data), this);
 	xmlReader->addData(data);
 	
 	while (!xmlReader->atEnd()) {
 		xmlReader->readNext();
-		if (topLevelItem)
+		if (topLevelItem) {
+			if (xmlReader->isStartElement() && (xmlReader->name() == QLatin1String("binary_stream"))) {
+				// The client has switched to binary framing; anything after
+				// the marker is no longer XML.
+				binaryInput = true;
+				if (!topLevelItem->readBinaryData(TopLevelProtocolItem::getBinaryRemainder(data)))
+					deleteLater();
+				return;
+			}
 			topLevelItem->readElement(xmlReader);
-		else if (xmlReader->isStartElement() && (xmlReader->name().toString() == "cockatrice_client_stream")) {
-			if (xmlReader->attributes().value("comp").toString().toInt() == 1)
+		} else if (xmlReader->isStartElement() && (xmlReader->name() == QLatin1String("cockatrice_client_stream"))) {
+			if (xmlReader->attributes().value(QLatin1String("comp")) == QLatin1String("1"))
 				compressionSupport = true;
 			topLevelItem = new TopLevelProtocolItem;
 			connect(topLevelItem, SIGNAL(protocolItemReceived(ProtocolItem *)), this, SLOT(processProtocolItem(ProtocolItem *)));
+			
+			if (xmlReader->attributes().value(QLatin1String("binary")) == QLatin1String("1")) {
+				// With deflate, the binary frames are sent through one
+				// zlib stream that lives as long as the connection.
+				bool deflate = compressionSupport && (xmlReader->attributes().value(QLatin1String("deflate")) == QLatin1String("1"));
+				StreamCompressor *newCompressor = 0;
+				if (deflate) {
+					newCompressor = new StreamCompressor;
+					if (!newCompressor->isValid()) {
+						logger->logMessage("Cannot initialize deflate stream, sending binary frames uncompressed", this);
+						delete newCompressor;
+						newCompressor = 0;
+						deflate = false;
+					}
+				}
+				
+				QMutexLocker locker(&xmlBufferMutex);
+				outputDevice->seek(outputBuffer.size());
+				xmlWriter->writeEmptyElement(deflate ? "deflate_stream" : "binary_stream");
+				// Forces the writer to close the tag before binary data follows.
+				xmlWriter->writeCharacters(QString());
+				binaryOutput = true;
+				if (deflate) {
+					// Everything up to the marker still goes out uncompressed.
+					servatrice->incTxBytes(outputBuffer.size());
+					socket->write(outputBuffer);
+					outputBuffer.clear();
+					compressor = newCompressor;
+				}
+				outputBufferChanged();
+			}
 		}
 	}
 }
@@ -124,62 +394,118 @@ void ServerSocketInterface::sendProtocolItem(ProtocolItem *item, bool deleteItem
 {
 	QMutexLocker locker(&xmlBufferMutex);
 	
-	item->write(xmlWriter);
+	if (sendBufferOverflow) {
+		if (deleteItem)
+			delete item;
+		return;
+	}
+	if (binaryOutput) {
+		if (!item->writeBinaryFrame(outputBuffer))
+			logger->logMessage(QString("Cannot encode item %1 in binary mode, not sent").arg(item->getItemType() + item->getItemSubType()), this);
+	} else {
+		outputDevice->seek(outputBuffer.size());
+		item->write(xmlWriter);
+	}
 	if (deleteItem)
 		delete item;
 	
-	emit xmlBufferChanged();
+	outputBufferChanged();
+}
+
+void ServerSocketInterface::sendEncodedItem(EncodedProtocolItem &item)
+{
+	QMutexLocker locker(&xmlBufferMutex);
+	
+	if (sendBufferOverflow)
+		return;
+	if (binaryOutput) {
+		const QByteArray &frame = item.getBinaryFrame();
+		if (frame.isEmpty()) {
+			logger->logMessage("Cannot encode broadcast item in binary mode, not sent", this);
+			return;
+		}
+		outputBuffer.append(frame);
+	} else
+		outputBuffer.append(item.getXmlData());
+	
+	outputBufferChanged();
 }
 
 int ServerSocketInterface::getUserIdInDB(const QString &name) const
 {
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
-	query.prepare("select id from " + servatrice->getDbPrefix() + "_users where name = :name");
-	query.bindValue(":name", name);
-	if (!servatrice->execSqlQuery(query))
-		return -1;
-	if (!query.next())
-		return -1;
-	return query.value(0).toInt();
+	return servatrice->getUserIdInDB(name);
 }
 
-ResponseCode ServerSocketInterface::cmdAddToList(Command_AddToList *cmd, CommandContainer *cont)
+void ServerSocketInterface::writeUserListChanges(CommandContainer *cont)
+{
+	// The handler's thread waits for this task, so it does not touch the
+	// lists or userListChanges in the meantime.
+	const QList<Command *> &cmdList = cont->getCommandList();
+	for (int i = 0; i < cmdList.size(); ++i) {
+		Command_AddToList *addCmd = qobject_cast<Command_AddToList *>(cmdList[i]);
+		Command_RemoveFromList *removeCmd = qobject_cast<Command_RemoveFromList *>(cmdList[i]);
+		if (addCmd)
+			userListChanges.insert(addCmd, writeUserListChange(addCmd->getList(), addCmd->getUserName(), true));
+		else if (removeCmd)
+			userListChanges.insert(removeCmd, writeUserListChange(removeCmd->getList(), removeCmd->getUserName(), false));
+	}
+}
+
+ServerSocketInterface::UserListChange ServerSocketInterface::writeUserListChange(const QString &list, const QString &user, bool add)
 {
 	if (authState != PasswordRight)
 		return RespFunctionNotAllowed;
 	
-	QString list = cmd->getList();
-	QString user = cmd->getUserName();
-	
 	if ((list != "buddy") && (list != "ignore"))
 		return RespContextError;
 	
-	if ((list == "buddy") && buddyList.contains(user))
-		return RespContextError;
-	if ((list == "ignore") && ignoreList.contains(user))
+	const QMap<QString, ServerInfo_User *> &userList = (list == "buddy") ? buddyList : ignoreList;
+	if (userList.contains(user) == add)
 		return RespContextError;
 	
 	int id1 = getUserIdInDB(userInfo->getName());
 	int id2 = getUserIdInDB(user);
 	if (id2 < 0)
 		return RespNameNotFound;
-	if (id1 == id2)
+	if (add && (id1 == id2))
 		return RespContextError;
 	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
-	query.prepare("insert into " + servatrice->getDbPrefix() + "_" + list + "list (id_user1, id_user2) values(:id1, :id2)");
+	DatabaseQuery query;
+	if (add)
+		query.prepare("insert into " + servatrice->getDbPrefix() + "_" + list + "list (id_user1, id_user2) values(:id1, :id2)");
+	else
+		query.prepare("delete from " + servatrice->getDbPrefix() + "_" + list + "list where id_user1 = :id1 and id_user2 = :id2");
 	query.bindValue(":id1", id1);
 	query.bindValue(":id2", id2);
 	if (!servatrice->execSqlQuery(query))
 		return RespInternalError;
+	servatrice->userListChanged(list, userInfo->getName());
+	
+	if (!add)
+		return RespOk;
+	return UserListChange(RespOk, servatrice->getUserData(user));
+}
+
+ServerSocketInterface::UserListChange ServerSocketInterface::takeUserListChange(Command *cmd, const QString &list, const QString &user, bool add)
+{
+	// Without a database task (e.g. when the pool is busy), the change is
+	// written right here.
+	if (userListChanges.contains(cmd))
+		return userListChanges.take(cmd);
+	return writeUserListChange(list, user, add);
+}
+
+ResponseCode ServerSocketInterface::cmdAddToList(Command_AddToList *cmd, CommandContainer *cont)
+{
+	QString list = cmd->getList();
+	UserListChange change = takeUserListChange(cmd, list, cmd->getUserName(), true);
+	if (change.response != RespOk)
+		return change.response;
 	
-	ServerInfo_User *info = servatrice->getUserData(user);
-	if (list == "buddy")
-		buddyList.insert(info->getName(), info);
-	else if (list == "ignore")
-		ignoreList.insert(info->getName(), info);
+	ServerInfo_User *info = change.info;
+	QMap<QString, ServerInfo_User *> &userList = (list == "buddy") ? buddyList : ignoreList;
+	delete userList.value(info->getName());
+	userList.insert(info->getName(), info);
 	
 	cont->enqueueItem(new Event_AddToList(list, new ServerInfo_User(info)));
 	return RespOk;
@@ -187,40 +513,15 @@ ResponseCode ServerSocketInterface::cmdAddToList(Command_AddToList *cmd, Command
 
 ResponseCode ServerSocketInterface::cmdRemoveFromList(Command_RemoveFromList *cmd, CommandContainer *cont)
 {
-	if (authState != PasswordRight)
-		return RespFunctionNotAllowed;
-	
 	QString list = cmd->getList();
 	QString user = cmd->getUserName();
+	UserListChange change = takeUserListChange(cmd, list, user, false);
+	if (change.response != RespOk)
+		return change.response;
 	
-	if ((list != "buddy") && (list != "ignore"))
-		return RespContextError;
-	
-	if ((list == "buddy") && !buddyList.contains(user))
-		return RespContextError;
-	if ((list == "ignore") && !ignoreList.contains(user))
-		return RespContextError;
-	
-	int id1 = getUserIdInDB(userInfo->getName());
-	int id2 = getUserIdInDB(user);
-	if (id2 < 0)
-		return RespNameNotFound;
-	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
-	query.prepare("delete from " + servatrice->getDbPrefix() + "_" + list + "list where id_user1 = :id1 and id_user2 = :id2");
-	query.bindValue(":id1", id1);
-	query.bindValue(":id2", id2);
-	if (!servatrice->execSqlQuery(query))
-		return RespInternalError;
-	
-	if (list == "buddy") {
-		delete buddyList.value(user);
-		buddyList.remove(user);
-	} else if (list == "ignore") {
-		delete ignoreList.value(user);
-		ignoreList.remove(user);
-	}
+	QMap<QString, ServerInfo_User *> &userList = (list == "buddy") ? buddyList : ignoreList;
+	delete userList.value(user);
+	userList.remove(user);
 	
 	cont->enqueueItem(new Event_RemoveFromList(list, user));
 	return RespOk;
@@ -233,8 +534,7 @@ int ServerSocketInterface::getDeckPathId(int basePathId, QStringList path)
 	if (path[0].isEmpty())
 		return 0;
 	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
+	DatabaseQuery query;
 	query.prepare("select id from " + servatrice->getDbPrefix() + "_decklist_folders where id_parent = :id_parent and name = :name and user = :user");
 	query.bindValue(":id_parent", basePathId);
 	query.bindValue(":name", path.takeFirst());
@@ -257,8 +557,7 @@ int ServerSocketInterface::getDeckPathId(const QString &path)
 
 bool ServerSocketInterface::deckListHelper(DeckList_Directory *folder)
 {
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
+	DatabaseQuery query;
 	query.prepare("select id, name from " + servatrice->getDbPrefix() + "_decklist_folders where id_parent = :id_parent and user = :user");
 	query.bindValue(":id_parent", folder->getId());
 	query.bindValue(":user", userInfo->getName());
@@ -294,10 +593,7 @@ ResponseCode ServerSocketInterface::cmdDeckList(Command_DeckList * /*cmd*/, Comm
 	if (authState != PasswordRight)
 		return RespFunctionNotAllowed;
 	
-	servatrice->checkSql();
-	
 	DeckList_Directory *root = new DeckList_Directory(QString());
-	QSqlQuery query;
 	if (!deckListHelper(root))
 		return RespContextError;
 	
@@ -314,14 +610,11 @@ ResponseCode ServerSocketInterface::cmdDeckNewDir(Command_DeckNewDir *cmd, Comma
 	if (authState != PasswordRight)
 		return RespFunctionNotAllowed;
 	
-	servatrice->checkSql();
-	
 	int folderId = getDeckPathId(cmd->getPath());
 	if (folderId == -1)
 		return RespNameNotFound;
 	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
+	DatabaseQuery query;
 	query.prepare("insert into " + servatrice->getDbPrefix() + "_decklist_folders (id_parent, user, name) values(:id_parent, :user, :name)");
 	query.bindValue(":id_parent", folderId);
 	query.bindValue(":user", userInfo->getName());
@@ -333,10 +626,7 @@ ResponseCode ServerSocketInterface::cmdDeckNewDir(Command_DeckNewDir *cmd, Comma
 
 void ServerSocketInterface::deckDelDirHelper(int basePathId)
 {
-	servatrice->checkSql();
-	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
+	DatabaseQuery query;
 	
 	query.prepare("select id from " + servatrice->getDbPrefix() + "_decklist_folders where id_parent = :id_parent");
 	query.bindValue(":id_parent", basePathId);
@@ -344,22 +634,43 @@ void ServerSocketInterface::deckDelDirHelper(int basePathId)
 	while (query.next())
 		deckDelDirHelper(query.value(0).toInt());
 	
+	query.prepare("select distinct content_hash from " + servatrice->getDbPrefix() + "_decklist_files where id_folder = :id_folder");
+	query.bindValue(":id_folder", basePathId);
+	servatrice->execSqlQuery(query);
+	QStringList contentHashes;
+	while (query.next())
+		contentHashes.append(query.value(0).toString());
+	
 	query.prepare("delete from " + servatrice->getDbPrefix() + "_decklist_files where id_folder = :id_folder");
 	query.bindValue(":id_folder", basePathId);
 	servatrice->execSqlQuery(query);
 	
+	for (int i = 0; i < contentHashes.size(); ++i)
+		deleteDeckBlobIfUnused(contentHashes[i]);
+	
 	query.prepare("delete from " + servatrice->getDbPrefix() + "_decklist_folders where id = :id");
 	query.bindValue(":id", basePathId);
 	servatrice->execSqlQuery(query);
 }
 
+void ServerSocketInterface::deleteDeckBlobIfUnused(const QString &contentHash)
+{
+	// Decks uploaded before the blob table existed have no hash.
+	if (contentHash.isEmpty())
+		return;
+	
+	DatabaseQuery query;
+	query.prepare("delete from " + servatrice->getDbPrefix() + "_decklist_blobs where content_hash = :content_hash and not exists (select 1 from " + servatrice->getDbPrefix() + "_decklist_files where content_hash = :content_hash2)");
+	query.bindValue(":content_hash", contentHash);
+	query.bindValue(":content_hash2", contentHash);
+	servatrice->execSqlQuery(query);
+}
+
 ResponseCode ServerSocketInterface::cmdDeckDelDir(Command_DeckDelDir *cmd, CommandContainer * /*cont*/)
 {
 	if (authState != PasswordRight)
 		return RespFunctionNotAllowed;
 	
-	servatrice->checkSql();
-	
 	int basePathId = getDeckPathId(cmd->getPath());
 	if (basePathId == -1)
 		return RespNameNotFound;
@@ -372,22 +683,22 @@ ResponseCode ServerSocketInterface::cmdDeckDel(Command_DeckDel *cmd, CommandCont
 	if (authState != PasswordRight)
 		return RespFunctionNotAllowed;
 	
-	servatrice->checkSql();
+	DatabaseQuery query;
 	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
-	
-	query.prepare("select id from " + servatrice->getDbPrefix() + "_decklist_files where id = :id and user = :user");
+	query.prepare("select content_hash from " + servatrice->getDbPrefix() + "_decklist_files where id = :id and user = :user");
 	query.bindValue(":id", cmd->getDeckId());
 	query.bindValue(":user", userInfo->getName());
 	servatrice->execSqlQuery(query);
 	if (!query.next())
 		return RespNameNotFound;
+	const QString contentHash = query.value(0).toString();
 	
 	query.prepare("delete from " + servatrice->getDbPrefix() + "_decklist_files where id = :id");
 	query.bindValue(":id", cmd->getDeckId());
 	servatrice->execSqlQuery(query);
 	
+	deleteDeckBlobIfUnused(contentHash);
+	
 	return RespOk;
 }
 
@@ -396,8 +707,6 @@ ResponseCode ServerSocketInterface::cmdDeckUpload(Command_DeckUpload *cmd, Comma
 	if (authState != PasswordRight)
 		return RespFunctionNotAllowed;
 	
-	servatrice->checkSql();
-	
 	if (!cmd->getDeck())
 		return RespInvalidData;
 	int folderId = getDeckPathId(cmd->getPath());
@@ -410,40 +719,83 @@ ResponseCode ServerSocketInterface::cmdDeckUpload(Command_DeckUpload *cmd, Comma
 	cmd->getDeck()->write(&deckWriter);
 	deckWriter.writeEndDocument();
 	
+	// Identical decks are stored only once. DeckList::getDeckHash() only
+	// covers the cards, so the blobs are keyed by a hash of the whole file.
+	const QString contentHash = QCryptographicHash::hash(deckContents.toUtf8(), QCryptographicHash::Sha1).toHex();
+	
 	QString deckName = cmd->getDeck()->getName();
 	if (deckName.isEmpty())
 		deckName = "Unnamed deck";
 
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
-	query.prepare("insert into " + servatrice->getDbPrefix() + "_decklist_files (id_folder, user, name, upload_time, content) values(:id_folder, :user, :name, NOW(), :content)");
+	// The file entry goes in first, so that a concurrent deletion of
+	// another entry with the same content doesn't remove the blob.
+	DatabaseQuery query;
+	query.prepare("insert into " + servatrice->getDbPrefix() + "_decklist_files (id_folder, user, name, upload_time, content_hash) values(:id_folder, :user, :name, NOW(), :content_hash)");
 	query.bindValue(":id_folder", folderId);
 	query.bindValue(":user", userInfo->getName());
 	query.bindValue(":name", deckName);
+	query.bindValue(":content_hash", contentHash);
+	if (!servatrice->execSqlQuery(query))
+		return RespInternalError;
+	const int deckId = query.lastInsertId().toInt();
+	
+	query.prepare("insert ignore into " + servatrice->getDbPrefix() + "_decklist_blobs (content_hash, content) values(:content_hash, :content)");
+	query.bindValue(":content_hash", contentHash);
 	query.bindValue(":content", deckContents);
-	servatrice->execSqlQuery(query);
+	if (!servatrice->execSqlQuery(query)) {
+		// Don't leave an entry behind that points to no content.
+		query.prepare("delete from " + servatrice->getDbPrefix() + "_decklist_files where id = :id");
+		query.bindValue(":id", deckId);
+		servatrice->execSqlQuery(query);
+		return RespInternalError;
+	}
 	
-	cont->setResponse(new Response_DeckUpload(cont->getCmdId(), RespOk, new DeckList_File(deckName, query.lastInsertId().toInt(), QDateTime::currentDateTime())));
+	servatrice->insertCachedDeck(contentHash, cmd->getDeck());
+	
+	cont->setResponse(new Response_DeckUpload(cont->getCmdId(), RespOk, new DeckList_File(deckName, deckId, QDateTime::currentDateTime())));
 	return RespNothing;
 }
 
 DeckList *ServerSocketInterface::getDeckFromDatabase(int deckId)
 {
-	servatrice->checkSql();
+	prefetchedDecksMutex.lock();
+	DeckList *prefetchedDeck = prefetchedDecks.take(deckId);
+	prefetchedDecksMutex.unlock();
+	if (prefetchedDeck)
+		return prefetchedDeck;
 	
-	QMutexLocker locker(&servatrice->dbMutex);
-	QSqlQuery query;
+	DatabaseQuery query;
 	
-	query.prepare("select content from " + servatrice->getDbPrefix() + "_decklist_files where id = :id and user = :user");
+	query.prepare("select content_hash, content from " + servatrice->getDbPrefix() + "_decklist_files where id = :id and user = :user");
 	query.bindValue(":id", deckId);
 	query.bindValue(":user", userInfo->getName());
 	servatrice->execSqlQuery(query);
 	if (!query.next())
 		throw RespNameNotFound;
 	
-	QXmlStreamReader deckReader(query.value(0).toString());
+	const QString contentHash = query.value(0).toString();
+	QString deckContents;
+	if (contentHash.isEmpty())
+		// Uploaded before the blob table existed.
+		deckContents = query.value(1).toString();
+	else {
+		DeckList *cachedDeck = servatrice->getCachedDeck(contentHash);
+		if (cachedDeck)
+			return cachedDeck;
+		
+		query.prepare("select content from " + servatrice->getDbPrefix() + "_decklist_blobs where content_hash = :content_hash");
+		query.bindValue(":content_hash", contentHash);
+		servatrice->execSqlQuery(query);
+		if (!query.next())
+			throw RespNameNotFound;
+		deckContents = query.value(0).toString();
+	}
+	
+	QXmlStreamReader deckReader(deckContents);
 	DeckList *deck = new DeckList;
 	deck->loadFromXml(&deckReader);
+	if (!contentHash.isEmpty())
+		servatrice->insertCachedDeck(contentHash, deck);
 	
 	return deck;
 }
@@ -472,18 +824,19 @@ ResponseCode ServerSocketInterface::cmdBanFromServer(Command_BanFromServer *cmd,
 	QString address = cmd->getAddress();
 	int minutes = cmd->getMinutes();
 	
-	servatrice->dbMutex.lock();
-	QSqlQuery query;
-	query.prepare("insert into " + servatrice->getDbPrefix() + "_bans (user_name, ip_address, id_admin, time_from, minutes, reason) values(:user_name, :ip_address, :id_admin, NOW(), :minutes, :reason)");
+	// Written before the ban is cached, so that a ban table reload started
+	// from now on can't miss it.
+	DatabaseQuery query("insert into " + servatrice->getDbPrefix() + "_bans (user_name, ip_address, id_admin, time_from, minutes, reason) values(:user_name, :ip_address, :id_admin, NOW(), :minutes, :reason)");
 	query.bindValue(":user_name", userName);
 	query.bindValue(":ip_address", address);
 	query.bindValue(":id_admin", getUserIdInDB(userInfo->getName()));
 	query.bindValue(":minutes", minutes);
 	query.bindValue(":reason", cmd->getReason() + "\n");
 	servatrice->execSqlQuery(query);
-	servatrice->dbMutex.unlock();
+	servatrice->getBanCache().addBan(userName, address, QDateTime::currentDateTime().toTime_t(), minutes * 60);
 	
-	ServerSocketInterface *user = static_cast<ServerSocketInterface *>(server->getUsers().value(userName));
+	QReadLocker locker(&server->clientsLock);
+	ServerSocketInterface *user = static_cast<ServerSocketInterface *>(server->getUser(userName));
 	if (user) {
 		user->sendProtocolItem(new Event_ConnectionClosed("banned"));
 		user->deleteLater();
@@ -24,6 +24,7 @@
 #include <QHostAddress>
 #include <QMutex>
 #include "server_protocolhandler.h"
+#include "databasepool.h"
 
 class QTcpSocket;
 class Servatrice;
@@ -32,26 +33,90 @@ class QXmlStreamWriter;
 class DeckList;
 class TopLevelProtocolItem;
 class QByteArray;
+class QBuffer;
+class StreamCompressor;
+class ServerSocketInterface;
+
+// Runs the database work of a command container in a database connection
+// thread. Containers made up of deck storage commands are processed there
+// completely; for all others, the decks they select are loaded and the
+// buddy and ignore list changes are written in advance.
+class CommandDatabaseTask : public DatabaseTask {
+private:
+	ServerSocketInterface *ssi;
+	CommandContainer *cont;
+	bool processContainer;
+protected:
+	void run();
+public:
+	CommandDatabaseTask(ServerSocketInterface *_ssi, CommandContainer *_cont, bool _processContainer)
+		: DatabaseTask(), ssi(_ssi), cont(_cont), processContainer(_processContainer) { }
+	// If set, the container has been deleted by the time the task finishes.
+	bool getProcessContainer() const { return processContainer; }
+};
 
 class ServerSocketInterface : public Server_ProtocolHandler
 {
 	Q_OBJECT
+	friend class CommandDatabaseTask;
 private slots:
 	void readClient();
 	void catchSocketError(QAbstractSocket::SocketError socketError);
 	void processProtocolItem(ProtocolItem *item);
 	void flushXmlBuffer();
+	void loginCheckFinished();
+	void databaseTaskFinished();
 signals:
 	void xmlBufferChanged();
 private:
 	QMutex xmlBufferMutex;
 	Servatrice *servatrice;
 	QTcpSocket *socket;
+	// The socket forgets its peer once disconnected, but the server still
+	// needs the address to update its per-address counts.
+	QHostAddress peerAddress;
 	QXmlStreamWriter *xmlWriter;
 	QXmlStreamReader *xmlReader;
-	QString xmlBuffer;
+	QByteArray outputBuffer;
+	QBuffer *outputDevice;
 	TopLevelProtocolItem *topLevelItem;
 	bool compressionSupport;
+	bool binaryInput, binaryOutput;
+	StreamCompressor *compressor;
+	bool flushPending, sendBufferOverflow;
+	
+	// While a login is being checked in the password hasher pool, or the
+	// database work of a container is done in the database pool, the
+	// container waits here and later containers are held back behind it.
+	CommandContainer *pendingContainer;
+	CommandDatabaseTask *pendingDatabaseTask;
+	QList<CommandContainer *> deferredContainers;
+	bool hasCheckedAuthentication;
+	QString checkedUserName, checkedPassword;
+	AuthenticationResult checkedAuthentication;
+	void startContainer(CommandContainer *cont);
+	void processDeferredContainers();
+	bool startLoginCheck(CommandContainer *cont);
+	bool startDatabaseTask(CommandContainer *cont);
+	// Decks loaded by a CommandDatabaseTask for the Command_DeckSelect
+	// commands of its container. They are used up in the game's thread.
+	QMutex prefetchedDecksMutex;
+	QMap<int, DeckList *> prefetchedDecks;
+	void prefetchDecks(CommandContainer *cont);
+	// The database half of Command_AddToList and Command_RemoveFromList,
+	// written by a CommandDatabaseTask. buddyList and ignoreList are only
+	// changed in the handler's thread, once the task has finished.
+	struct UserListChange {
+		ResponseCode response;
+		ServerInfo_User *info;
+		UserListChange(ResponseCode _response = RespOk, ServerInfo_User *_info = 0) : response(_response), info(_info) { }
+	};
+	QMap<Command *, UserListChange> userListChanges;
+	void writeUserListChanges(CommandContainer *cont);
+	UserListChange writeUserListChange(const QString &list, const QString &user, bool add);
+	UserListChange takeUserListChange(Command *cmd, const QString &list, const QString &user, bool add);
+	void setCheckedAuthentication(const QString &userName, const QString &password, AuthenticationResult result);
+	void outputBufferChanged();
 	int getUserIdInDB(const QString &name) const;
 
 	ResponseCode cmdAddToList(Command_AddToList *cmd, CommandContainer *cont);
@@ -62,6 +127,7 @@ private:
 	ResponseCode cmdDeckList(Command_DeckList *cmd, CommandContainer *cont);
 	ResponseCode cmdDeckNewDir(Command_DeckNewDir *cmd, CommandContainer *cont);
 	void deckDelDirHelper(int basePathId);
+	void deleteDeckBlobIfUnused(const QString &contentHash);
 	ResponseCode cmdDeckDelDir(Command_DeckDelDir *cmd, CommandContainer *cont);
 	ResponseCode cmdDeckDel(Command_DeckDel *cmd, CommandContainer *cont);
 	ResponseCode cmdDeckUpload(Command_DeckUpload *cmd, CommandContainer *cont);
@@ -75,10 +141,13 @@ protected:
 public:
 	ServerSocketInterface(Servatrice *_server, QTcpSocket *_socket, QObject *parent = 0);
 	~ServerSocketInterface();
-	QHostAddress getPeerAddress() const { return socket->peerAddress(); }
-	QString getAddress() const { return socket->peerAddress().toString(); }
+	QHostAddress getPeerAddress() const { return peerAddress; }
+	QString getAddress() const { return peerAddress.toString(); }
+	// Hands out the result of the finished login check if it was for these credentials.
+	bool takeCheckedAuthentication(const QString &userName, const QString &password, AuthenticationResult &result);
 
 	void sendProtocolItem(ProtocolItem *item, bool deleteItem = true);
+	void sendEncodedItem(EncodedProtocolItem &item);
 };
 
 #endif
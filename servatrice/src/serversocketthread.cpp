@@ -3,25 +3,48 @@
 #include "server_logger.h"
 #include "main.h"
 
-ServerSocketThread::ServerSocketThread(int _socketDescriptor, Servatrice *_server, QObject *parent)
-	: QThread(parent), server(_server), socketDescriptor(_socketDescriptor)
+ServerSocketWorker::ServerSocketWorker(Servatrice *_server)
+	: QObject(), server(_server), connectionCount(0)
 {
 }
 
-ServerSocketThread::~ServerSocketThread()
+void ServerSocketWorker::assignConnection(int socketDescriptor)
 {
-	quit();
-	wait();
+	// Counted right away so that a burst of connections is spread evenly.
+	connectionCount.ref();
+	QMetaObject::invokeMethod(this, "addConnection", Qt::QueuedConnection, Q_ARG(int, socketDescriptor));
 }
 
-void ServerSocketThread::run()
+void ServerSocketWorker::addConnection(int socketDescriptor)
 {
 	QTcpSocket *socket = new QTcpSocket;
 	socket->setSocketDescriptor(socketDescriptor);
 	logger->logMessage(QString("incoming connection: %1").arg(socket->peerAddress().toString()));
 	
-	ssi = new ServerSocketInterface(server, socket);
-	connect(ssi, SIGNAL(destroyed()), this, SLOT(deleteLater()));
-	
+	ServerSocketInterface *ssi = new ServerSocketInterface(server, socket);
+	connect(ssi, SIGNAL(destroyed()), this, SLOT(connectionClosed()));
+}
+
+void ServerSocketWorker::connectionClosed()
+{
+	connectionCount.deref();
+}
+
+ServerSocketThread::ServerSocketThread(Servatrice *_server, QObject *parent)
+	: QThread(parent)
+{
+	worker = new ServerSocketWorker(_server);
+	worker->moveToThread(this);
+}
+
+ServerSocketThread::~ServerSocketThread()
+{
+	quit();
+	wait();
+	delete worker;
+}
+
+void ServerSocketThread::run()
+{
 	exec();
 }
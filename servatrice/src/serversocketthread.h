@@ -2,19 +2,34 @@
 #define SERVERSOCKETTHREAD_H
 
 #include <QThread>
+#include <QAtomicInt>
 
 class Servatrice;
 class ServerSocketInterface;
 
-class ServerSocketThread : public QThread {
+// Lives in a ServerSocketThread and owns all connections assigned to it.
+class ServerSocketWorker : public QObject {
 	Q_OBJECT
 private:
 	Servatrice *server;
-	ServerSocketInterface *ssi;
-	int socketDescriptor;
+	QAtomicInt connectionCount;
+private slots:
+	void addConnection(int socketDescriptor);
+	void connectionClosed();
+public:
+	ServerSocketWorker(Servatrice *_server);
+	int getConnectionCount() const { return connectionCount; }
+	void assignConnection(int socketDescriptor);
+};
+
+class ServerSocketThread : public QThread {
+	Q_OBJECT
+private:
+	ServerSocketWorker *worker;
 public:
-	ServerSocketThread(int _socketDescriptor, Servatrice *_server, QObject *parent = 0);
+	ServerSocketThread(Servatrice *_server, QObject *parent = 0);
 	~ServerSocketThread();
+	ServerSocketWorker *getWorker() const { return worker; }
 protected:
 	void run();
 };
@@ -0,0 +1,110 @@
+#include "usercache.h"
+#include "protocol_datastructures.h"
+#include <QDateTime>
+
+UserCache::CachedUser::~CachedUser()
+{
+	delete user;
+}
+
+UserCache::CachedUserList::~CachedUserList()
+{
+	qDeleteAll(users);
+}
+
+UserCache::UserCache(int maxEntries, int _maxAge)
+	: maxAge(_maxAge), users(maxEntries), userIds(maxEntries), userLists(maxEntries), hits(0), misses(0)
+{
+}
+
+template<typename T> T *UserCache::lookup(QCache<QString, T> &cache, const QString &key)
+{
+	T *entry = cache.object(key);
+	if (entry && (QDateTime::currentDateTime().toTime_t() - entry->cachedAt >= (uint) maxAge)) {
+		cache.remove(key);
+		entry = 0;
+	}
+	if (entry)
+		++hits;
+	else
+		++misses;
+	return entry;
+}
+
+ServerInfo_User *UserCache::getUser(const QString &name)
+{
+	QMutexLocker locker(&mutex);
+	CachedUser *entry = lookup(users, name.toLower());
+	return entry ? new ServerInfo_User(entry->user) : 0;
+}
+
+void UserCache::insertUser(const QString &name, const ServerInfo_User *user)
+{
+	QMutexLocker locker(&mutex);
+	CachedUser *entry = new CachedUser;
+	entry->cachedAt = QDateTime::currentDateTime().toTime_t();
+	entry->user = new ServerInfo_User(user);
+	users.insert(name.toLower(), entry);
+}
+
+int UserCache::getUserId(const QString &name)
+{
+	QMutexLocker locker(&mutex);
+	CachedUserId *entry = lookup(userIds, name.toLower());
+	return entry ? entry->id : -1;
+}
+
+void UserCache::insertUserId(const QString &name, int id)
+{
+	QMutexLocker locker(&mutex);
+	CachedUserId *entry = new CachedUserId;
+	entry->cachedAt = QDateTime::currentDateTime().toTime_t();
+	entry->id = id;
+	userIds.insert(name.toLower(), entry);
+}
+
+bool UserCache::getUserList(const QString &list, const QString &name, QMap<QString, ServerInfo_User *> &result)
+{
+	QMutexLocker locker(&mutex);
+	CachedUserList *entry = lookup(userLists, userListKey(list, name));
+	if (!entry)
+		return false;
+	
+	QMapIterator<QString, ServerInfo_User *> userIterator(entry->users);
+	while (userIterator.hasNext()) {
+		userIterator.next();
+		result.insert(userIterator.key(), new ServerInfo_User(userIterator.value()));
+	}
+	return true;
+}
+
+void UserCache::insertUserList(const QString &list, const QString &name, const QMap<QString, ServerInfo_User *> &userList)
+{
+	QMutexLocker locker(&mutex);
+	CachedUserList *entry = new CachedUserList;
+	entry->cachedAt = QDateTime::currentDateTime().toTime_t();
+	QMapIterator<QString, ServerInfo_User *> userIterator(userList);
+	while (userIterator.hasNext()) {
+		userIterator.next();
+		entry->users.insert(userIterator.key(), new ServerInfo_User(userIterator.value()));
+	}
+	userLists.insert(userListKey(list, name), entry);
+}
+
+void UserCache::invalidateUserList(const QString &list, const QString &name)
+{
+	QMutexLocker locker(&mutex);
+	userLists.remove(userListKey(list, name));
+}
+
+int UserCache::getHits() const
+{
+	QMutexLocker locker(&mutex);
+	return hits;
+}
+
+int UserCache::getMisses() const
+{
+	QMutexLocker locker(&mutex);
+	return misses;
+}
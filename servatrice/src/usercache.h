@@ -0,0 +1,59 @@
+#ifndef USERCACHE_H
+#define USERCACHE_H
+
+#include <QMutex>
+#include <QCache>
+#include <QMap>
+#include <QString>
+
+class ServerInfo_User;
+
+// Recently used user records, user ids and buddy/ignore lists from the
+// database, each kept in a bounded LRU cache. Entries are given out as
+// copies and are dropped after maxAge seconds, so that changes made on
+// the web site show up eventually. Names are compared case-insensitively,
+// like the database does. Thread-safe.
+class UserCache {
+private:
+	struct CachedUser {
+		uint cachedAt;
+		ServerInfo_User *user;
+		~CachedUser();
+	};
+	struct CachedUserId {
+		uint cachedAt;
+		int id;
+	};
+	struct CachedUserList {
+		uint cachedAt;
+		QMap<QString, ServerInfo_User *> users;
+		~CachedUserList();
+	};
+	mutable QMutex mutex;
+	int maxAge;
+	QCache<QString, CachedUser> users;
+	QCache<QString, CachedUserId> userIds;
+	QCache<QString, CachedUserList> userLists;
+	int hits, misses;
+	
+	static QString userListKey(const QString &list, const QString &name) { return list + '/' + name.toLower(); }
+	template<typename T> T *lookup(QCache<QString, T> &cache, const QString &key);
+public:
+	UserCache(int maxEntries, int _maxAge);
+	
+	// Returns a new copy, or 0 if the user isn't cached.
+	ServerInfo_User *getUser(const QString &name);
+	void insertUser(const QString &name, const ServerInfo_User *user);
+	// Returns -1 if the id isn't cached.
+	int getUserId(const QString &name);
+	void insertUserId(const QString &name, int id);
+	// list is "buddy" or "ignore". Fills result with new copies.
+	bool getUserList(const QString &list, const QString &name, QMap<QString, ServerInfo_User *> &result);
+	void insertUserList(const QString &list, const QString &name, const QMap<QString, ServerInfo_User *> &userList);
+	void invalidateUserList(const QString &list, const QString &name);
+	
+	int getHits() const;
+	int getMisses() const;
+};
+
+#endif